@@ -0,0 +1,70 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+/* Monotonic wall-clock time in seconds */
+double
+benchNow(void)
+{
+    struct timespec     ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Current resident set size in kilobytes, or 0 where /proc is unavailable */
+size_t
+benchRssKb(void)
+{
+    FILE               *statm;
+    unsigned long       pages = 0, resident = 0;
+
+    if (!(statm = fopen("/proc/self/statm", "r")))
+        return 0;
+    if (fscanf(statm, "%lu %lu", &pages, &resident) != 2)
+        resident = 0;
+    fclose(statm);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/* xorshift64*: fast, reproducible key generation */
+unsigned long long
+benchRand(unsigned long long *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+/*
+ * splitmix64 finalizer: a bijective scramble, so distinct i give distinct
+ * keys and random present keys can be drawn without a key array
+ */
+unsigned long long
+benchKey(unsigned long long i)
+{
+    i = (i ^ (i >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    i = (i ^ (i >> 27)) * 0x94D049BB133111EBULL;
+    return i ^ (i >> 31);
+}
+
+size_t
+benchArgSize(int argc, char *argv[], int idx, size_t dflt)
+{
+    if (idx < argc)
+        return strtoul(argv[idx], NULL, 10);
+    return dflt;
+}
+
+void
+benchReport(const char *label, size_t ops, double secs)
+{
+    printf("%-44.44s %12zu ops %9.3f s %10.2f Mops/s\n", label, ops, secs,
+           secs > 0 ? ops / secs / 1e6 : 0.0);
+}
@@ -0,0 +1,15 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+
+/* Shared helpers for the benchmark programs in this directory */
+
+double                          benchNow(void);
+size_t                          benchRssKb(void);
+unsigned long long              benchRand(unsigned long long *state);
+unsigned long long              benchKey(unsigned long long i);
+size_t                          benchArgSize(int argc, char *argv[], int idx, size_t dflt);
+void                            benchReport(const char *label, size_t ops, double secs);
+
+#endif
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Throughput of moving data through nStack and nList one element per call
+ * versus in batches with the bulk calls, across batch and element sizes
+ *
+ * Usage: bulk_bench [elemsPerRun]
+ */
+
+#define POOL_SLAB_NODES 4096
+
+static void
+runStack(size_t elemSize, size_t batch, size_t total, char *buf)
+{
+    struct nStack       s;
+    size_t              done, i;
+    double              start, single, bulk;
+
+    nStackInitM(&s, batch, elemSize);
+    start = benchNow();
+    for (done = 0; done < total; done += batch) {
+        for (i = 0; i < batch; i++)
+            nStackPush(&s, buf + i * elemSize);
+        for (i = 0; i < batch; i++)
+            nStackPop(&s, buf + i * elemSize);
+    }
+    single = benchNow() - start;
+
+    start = benchNow();
+    for (done = 0; done < total; done += batch) {
+        nStackPushN(&s, buf, batch);
+        nStackPopN(&s, buf, batch);
+    }
+    bulk = benchNow() - start;
+    nStackDestroy(&s);
+
+    printf("nStack elem %3zu batch %4zu: single %8.1f Mops/s  bulk %8.1f Mops/s\n",
+           elemSize, batch, 2 * total / single / 1e6, 2 * total / bulk / 1e6);
+}
+
+static void
+runList(size_t elemSize, size_t batch, size_t total, char *buf)
+{
+    struct nList        l;
+    size_t              done, i;
+    double              start, single, bulk;
+
+    nListInitPool(&l, elemSize, POOL_SLAB_NODES);
+    start = benchNow();
+    for (done = 0; done < total; done += batch) {
+        for (i = 0; i < batch; i++)
+            nListInsertTail(&l, buf + i * elemSize);
+        for (i = 0; i < batch; i++)
+            nListRemoveHead(&l, buf + i * elemSize);
+    }
+    single = benchNow() - start;
+
+    start = benchNow();
+    for (done = 0; done < total; done += batch) {
+        nListInsertTailN(&l, buf, batch);
+        nListRemoveHeadN(&l, buf, batch);
+    }
+    bulk = benchNow() - start;
+    nListDestroy(&l);
+
+    printf("nList  elem %3zu batch %4zu: single %8.1f Mops/s  bulk %8.1f Mops/s\n",
+           elemSize, batch, 2 * total / single / 1e6, 2 * total / bulk / 1e6);
+}
+
+int
+main(int argc, char *argv[])
+{
+    const size_t        elemSizes[] = {4, 16, 64}, batches[] = {1, 64, 512, 4096};
+    size_t              total, e, b;
+    char               *buf;
+
+    total = benchArgSize(argc, argv, 1, 4096 * 2000);
+    if (!(buf = calloc(4096, 64)))
+        return 1;
+    for (e = 0; e < sizeof(elemSizes) / sizeof(elemSizes[0]); e++) {
+        for (b = 0; b < sizeof(batches) / sizeof(batches[0]); b++)
+            runStack(elemSizes[e], batches[b], total, buf);
+    }
+    for (e = 0; e < sizeof(elemSizes) / sizeof(elemSizes[0]); e++) {
+        for (b = 0; b < sizeof(batches) / sizeof(batches[0]); b++)
+            runList(elemSizes[e], batches[b], total, buf);
+    }
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,155 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * A buffer pool shared by 1 to maxThreads threads, each taking a buffer
+ * and giving it back numOps times in total: nStack behind a spin lock,
+ * nCStack, and nCStack behind a per-thread cache of CACHE_ELEMS buffers.
+ * The pool holds POOL_PER_THREAD buffers per thread.
+ *
+ * Usage: cstack_bench [numOps] [maxThreads]
+ */
+
+#define POOL_PER_THREAD 64
+#define CACHE_ELEMS 32
+
+enum poolMode {
+    poolLocked,
+    poolLockFree,
+    poolCached
+};
+
+static struct nStack            lockedStack;
+static struct nCStack           sharedStack;
+static char                     stackLock;
+static enum poolMode            mode;
+static size_t                   opsPerThread;
+
+static void
+lock(void)
+{
+    while (__atomic_test_and_set(&stackLock, __ATOMIC_ACQUIRE))
+        sched_yield();
+}
+
+static void
+unlock(void)
+{
+    __atomic_clear(&stackLock, __ATOMIC_RELEASE);
+}
+
+static void                    *
+workerLoop(void *arg)
+{
+    struct nCStackCache cache;
+    size_t              i, *misses = arg;
+    unsigned int        buffer;
+    enum nErrorType     ret;
+
+    if (mode == poolCached)
+        nCStackCacheInit(&cache, &sharedStack, CACHE_ELEMS);
+    for (i = 0; i < opsPerThread; i++) {
+        switch (mode) {
+        case poolLocked:
+            lock();
+            ret = nStackPop(&lockedStack, &buffer);
+            unlock();
+            break;
+        case poolLockFree:
+            ret = nCStackPop(&sharedStack, &buffer);
+            break;
+        default:
+            ret = nCStackCachePop(&cache, &buffer);
+            break;
+        }
+        if (ret) {
+            (*misses)++;
+            continue;
+        }
+        switch (mode) {
+        case poolLocked:
+            lock();
+            nStackPush(&lockedStack, &buffer);
+            unlock();
+            break;
+        case poolLockFree:
+            nCStackPush(&sharedStack, &buffer);
+            break;
+        default:
+            nCStackCachePush(&cache, &buffer);
+            break;
+        }
+    }
+    if (mode == poolCached)
+        nCStackCacheDestroy(&cache);
+    return NULL;
+}
+
+static void
+runPool(const char *name, enum poolMode poolMode, size_t numThreads, size_t numOps)
+{
+    pthread_t          *threads;
+    size_t             *misses, i, totalMisses = 0;
+    unsigned int        buffer, numBuffers = numThreads * POOL_PER_THREAD;
+    double              start, secs;
+    char                label[64];
+
+    threads = malloc(numThreads * sizeof(*threads));
+    misses = calloc(numThreads, sizeof(*misses));
+    if (!threads || !misses)
+        return;
+    mode = poolMode;
+    opsPerThread = numOps / numThreads;
+    if (mode == poolLocked) {
+        nStackInitM(&lockedStack, numBuffers, sizeof(buffer));
+        for (buffer = 0; buffer < numBuffers; buffer++)
+            nStackPush(&lockedStack, &buffer);
+    } else {
+        nCStackInit(&sharedStack, numBuffers, sizeof(buffer));
+        for (buffer = 0; buffer < numBuffers; buffer++)
+            nCStackPush(&sharedStack, &buffer);
+    }
+
+    start = benchNow();
+    for (i = 0; i < numThreads; i++)
+        pthread_create(&threads[i], NULL, workerLoop, &misses[i]);
+    for (i = 0; i < numThreads; i++) {
+        pthread_join(threads[i], NULL);
+        totalMisses += misses[i];
+    }
+    secs = benchNow() - start;
+
+    snprintf(label, sizeof(label), "%s, %zu threads", name, numThreads);
+    benchReport(label, opsPerThread * numThreads, secs);
+    if (totalMisses)
+        printf("  %zu pops found the pool empty\n", totalMisses);
+
+    if (mode == poolLocked)
+        nStackDestroy(&lockedStack);
+    else
+        nCStackDestroy(&sharedStack);
+    free(threads);
+    free(misses);
+}
+
+int
+main(int argc, char *argv[])
+{
+    size_t              numOps, maxThreads, numThreads;
+
+    numOps = benchArgSize(argc, argv, 1, 4000000);
+    maxThreads = benchArgSize(argc, argv, 2, 64);
+    for (numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        runPool("nStack behind a spin lock", poolLocked, numThreads, numOps);
+        runPool("nCStack", poolLockFree, numThreads, numOps);
+        runPool("nCStack with per-thread cache", poolCached, numThreads, numOps);
+    }
+    return 0;
+}
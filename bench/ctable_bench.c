@@ -0,0 +1,151 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Read throughput of a table shared by 1 to maxReaders reader threads
+ * while one writer inserts and removes keys in the background: nCTable
+ * with lock-free readers against an nTable behind a mutex taken by every
+ * reader and the writer. Half the keys are present throughout; the writer
+ * churns the other half, pausing between operations.
+ *
+ * Usage: ctable_bench [numKeys] [maxReaders] [writerPauseUs]
+ */
+
+#define RUN_SECS 1.0
+
+static struct nCTable           ctable;
+static struct nTable            table;
+static pthread_mutex_t          tableLock = PTHREAD_MUTEX_INITIALIZER;
+static int                      useLock, running;
+static size_t                   numKeys, writerPauseUs;
+
+struct readerArgs {
+    pthread_t                       thread;
+    size_t                          reader;
+    size_t                          peeks;
+    size_t                          found;
+};
+
+static void                    *
+readerLoop(void *arg)
+{
+    struct readerArgs  *args = arg;
+    unsigned long long  seed = 88172645463325252ULL + args->reader, k, value;
+
+    while (__atomic_load_n(&running, __ATOMIC_RELAXED)) {
+        k = benchRand(&seed) % numKeys;
+        if (useLock) {
+            pthread_mutex_lock(&tableLock);
+            args->found += !nTablePeek(&table, &k, &value);
+            pthread_mutex_unlock(&tableLock);
+        } else {
+            args->found += !nCTablePeek(&ctable, args->reader, &k, &value);
+        }
+        args->peeks++;
+    }
+    return NULL;
+}
+
+static void                    *
+writerLoop(void *arg)
+{
+    size_t             *writes = arg;
+    unsigned long long  seed = 2463534242ULL, k;
+    struct timespec     pause;
+
+    pause.tv_sec = 0;
+    pause.tv_nsec = writerPauseUs * 1000;
+    while (__atomic_load_n(&running, __ATOMIC_RELAXED)) {
+        k = benchRand(&seed) % numKeys | 1;
+        if (useLock) {
+            pthread_mutex_lock(&tableLock);
+            if (seed & 2)
+                nTableInsert(&table, &k, &k);
+            else
+                nTableRemove(&table, &k);
+            pthread_mutex_unlock(&tableLock);
+        } else if (seed & 2) {
+            nCTableInsert(&ctable, &k, &k);
+        } else {
+            nCTableRemove(&ctable, &k);
+        }
+        (*writes)++;
+        if (writerPauseUs)
+            nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+static void
+runReaders(const char *name, size_t numReaders, struct readerArgs *readers)
+{
+    pthread_t           writer;
+    size_t              i, writes = 0, peeks = 0;
+    struct timespec     runTime;
+    double              start, secs;
+    char                label[64];
+
+    runTime.tv_sec = (time_t)RUN_SECS;
+    runTime.tv_nsec = (long)((RUN_SECS - runTime.tv_sec) * 1e9);
+    running = 1;
+    start = benchNow();
+    pthread_create(&writer, NULL, writerLoop, &writes);
+    for (i = 0; i < numReaders; i++) {
+        readers[i].reader = i;
+        readers[i].peeks = readers[i].found = 0;
+        pthread_create(&readers[i].thread, NULL, readerLoop, &readers[i]);
+    }
+    nanosleep(&runTime, NULL);
+    __atomic_store_n(&running, 0, __ATOMIC_RELAXED);
+    for (i = 0; i < numReaders; i++) {
+        pthread_join(readers[i].thread, NULL);
+        peeks += readers[i].peeks;
+    }
+    pthread_join(writer, NULL);
+    secs = benchNow() - start;
+
+    snprintf(label, sizeof(label), "%s, %zu readers", name, numReaders);
+    benchReport(label, peeks, secs);
+    printf("  %zu writes, %.0f ns per read per reader\n", writes,
+           secs * 1e9 * numReaders / (peeks ? peeks : 1));
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct readerArgs  *readers;
+    unsigned long long  k;
+    size_t              maxReaders, numReaders;
+
+    numKeys = benchArgSize(argc, argv, 1, 1000000);
+    maxReaders = benchArgSize(argc, argv, 2, 8);
+    writerPauseUs = benchArgSize(argc, argv, 3, 10);
+    if (!(readers = calloc(maxReaders, sizeof(*readers))))
+        return 1;
+
+    nCTableInit(&ctable, sizeof(k), sizeof(k), 4096, maxReaders);
+    nTableInitPool(&table, sizeof(k), sizeof(k), 4096);
+    for (k = 0; k < numKeys; k++) {
+        nCTableInsert(&ctable, &k, &k);
+        nTableInsert(&table, &k, &k);
+    }
+
+    for (numReaders = 1; numReaders <= maxReaders; numReaders *= 2) {
+        useLock = 0;
+        runReaders("nCTablePeek", numReaders, readers);
+        useLock = 1;
+        runReaders("nTablePeek behind a mutex", numReaders, readers);
+    }
+
+    nCTableDestroy(&ctable);
+    nTableDestroy(&table);
+    free(readers);
+    return 0;
+}
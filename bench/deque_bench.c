@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Push/pop throughput and memory per element of nDeque against nList.
+ * Each container type runs in its own process so that RSS deltas are not
+ * skewed by memory released by another run.
+ *
+ * Usage: deque_bench deque|list|pool [numElems]
+ */
+
+#define POOL_SLAB_NODES 4096
+
+/* Common queue interface so that every container runs the same loop */
+struct queueOps {
+    void                            (*init) (void *, size_t);
+    void                            (*destroy) (void *);
+    enum nErrorType                 (*insertTail) (void *, void *);
+    enum nErrorType                 (*removeHead) (void *, void *);
+};
+
+static void
+dequeInit(void *q, size_t elemSize)
+{
+    nDequeInit(q, elemSize);
+}
+
+static void
+dequeDestroy(void *q)
+{
+    nDequeDestroy(q);
+}
+
+static enum nErrorType
+dequeInsertTail(void *q, void *dataIn)
+{
+    return nDequeInsertTail(q, dataIn);
+}
+
+static enum nErrorType
+dequeRemoveHead(void *q, void *dataOut)
+{
+    return nDequeRemoveHead(q, dataOut);
+}
+
+static void
+listInit(void *q, size_t elemSize)
+{
+    nListInit(q, elemSize);
+}
+
+static void
+listInitPooled(void *q, size_t elemSize)
+{
+    nListInitPool(q, elemSize, POOL_SLAB_NODES);
+}
+
+static void
+listDestroy(void *q)
+{
+    nListDestroy(q);
+}
+
+static enum nErrorType
+listInsertTail(void *q, void *dataIn)
+{
+    return nListInsertTail(q, dataIn);
+}
+
+static enum nErrorType
+listRemoveHead(void *q, void *dataOut)
+{
+    return nListRemoveHead(q, dataOut);
+}
+
+static void
+run(const char *name, const struct queueOps *ops, void *q, size_t numElems)
+{
+    unsigned long long  elem = 0;
+    size_t              i, rssBefore;
+    double              start;
+    char                label[64];
+
+    rssBefore = benchRssKb();
+    ops->init(q, sizeof(elem));
+
+    /* Fill, then drain: worst case for allocation */
+    start = benchNow();
+    for (i = 0; i < numElems; i++, elem++)
+        ops->insertTail(q, &elem);
+    printf("%-44.44s %12.1f bytes\n", "memory per element",
+           (benchRssKb() - rssBefore) * 1024.0 / numElems);
+    for (i = 0; i < numElems; i++)
+        ops->removeHead(q, &elem);
+    sprintf(label, "%s fill/drain", name);
+    benchReport(label, 2 * numElems, benchNow() - start);
+
+    /* Steady-state work queue holding a handful of elements */
+    for (i = 0; i < 16; i++)
+        ops->insertTail(q, &elem);
+    start = benchNow();
+    for (i = 0; i < numElems; i++) {
+        ops->insertTail(q, &elem);
+        ops->removeHead(q, &elem);
+    }
+    sprintf(label, "%s steady queue", name);
+    benchReport(label, 2 * numElems, benchNow() - start);
+
+    ops->destroy(q);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct nDeque       deque;
+    struct nList        list;
+    struct queueOps     dequeOps = {dequeInit, dequeDestroy, dequeInsertTail, dequeRemoveHead};
+    struct queueOps     listOps = {listInit, listDestroy, listInsertTail, listRemoveHead};
+    size_t              numElems;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s deque|list|pool [numElems]\n", argv[0]);
+        return 1;
+    }
+    numElems = benchArgSize(argc, argv, 2, 10000000);
+
+    if (!strcmp(argv[1], "deque")) {
+        run("nDeque", &dequeOps, &deque, numElems);
+    } else if (!strcmp(argv[1], "list")) {
+        run("nList", &listOps, &list, numElems);
+    } else if (!strcmp(argv[1], "pool")) {
+        listOps.init = listInitPooled;
+        run("nList (pooled)", &listOps, &list, numElems);
+    } else {
+        return 1;
+    }
+    return 0;
+}
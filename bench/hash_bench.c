@@ -0,0 +1,138 @@
+#include <stdio.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * nHash against a pooled nTable on the same workloads: inserting numKeys
+ * 8-byte keys with 8-byte values, looking up present and absent keys, then
+ * removing every key. Each insert is timed on its own as well, so the
+ * slowest, and the count over SLOW_INSERT_US, show what growing the table
+ * costs a single call.
+ *
+ * Usage: hash_bench [numKeys] [numLookups]
+ */
+
+#define POOL_SLAB 4096
+#define SLOW_INSERT_US 100
+
+/* One workload, run through either container */
+struct ops {
+    const char *name;
+    enum nErrorType (*insert)(void *c, const void *key, const void *dataIn);
+    enum nErrorType (*peek)(void *c, const void *key, void *dataOut);
+    enum nErrorType (*remove)(void *c, const void *key);
+};
+
+static enum nErrorType
+tableInsert(void *c, const void *key, const void *dataIn)
+{
+    return nTableInsert(c, key, dataIn);
+}
+
+static enum nErrorType
+tablePeek(void *c, const void *key, void *dataOut)
+{
+    return nTablePeek(c, key, dataOut);
+}
+
+static enum nErrorType
+tableRemove(void *c, const void *key)
+{
+    return nTableRemove(c, key);
+}
+
+static enum nErrorType
+hashInsert(void *c, const void *key, const void *dataIn)
+{
+    return nHashInsert(c, key, dataIn);
+}
+
+static enum nErrorType
+hashPeek(void *c, const void *key, void *dataOut)
+{
+    return nHashPeek(c, key, dataOut);
+}
+
+static enum nErrorType
+hashRemove(void *c, const void *key)
+{
+    return nHashRemove(c, key);
+}
+
+static void
+run(const struct ops *o, void *c, size_t numKeys, size_t numLookups)
+{
+    unsigned long long  seed = 0x9E3779B97F4A7C15ULL, key, value;
+    size_t              i, numFound = 0, numSlow = 0;
+    double              start, opStart, opSecs, maxOpSecs = 0;
+    char                label[64];
+
+    start = benchNow();
+    for (i = 0; i < numKeys; i++) {
+        key = benchKey(i);
+        opStart = benchNow();
+        if (o->insert(c, &key, &i)) {
+            printf("%s ran out of memory at %zu keys\n", o->name, i);
+            return;
+        }
+        if ((opSecs = benchNow() - opStart) > maxOpSecs)
+            maxOpSecs = opSecs;
+        numSlow += opSecs * 1e6 > SLOW_INSERT_US;
+    }
+    sprintf(label, "%s insert", o->name);
+    benchReport(label, numKeys, benchNow() - start);
+    printf("    slowest insert %.1f us, %zu over %d us\n", maxOpSecs * 1e6, numSlow,
+           SLOW_INSERT_US);
+
+    start = benchNow();
+    for (i = 0; i < numLookups; i++) {
+        key = benchKey(benchRand(&seed) % numKeys);
+        numFound += o->peek(c, &key, &value) == nCodeSuccess;
+    }
+    sprintf(label, "%s peek present", o->name);
+    benchReport(label, numLookups, benchNow() - start);
+
+    start = benchNow();
+    for (i = 0; i < numLookups; i++) {
+        key = benchKey(numKeys + benchRand(&seed) % numKeys);
+        numFound += o->peek(c, &key, &value) == nCodeSuccess;
+    }
+    sprintf(label, "%s peek absent", o->name);
+    benchReport(label, numLookups, benchNow() - start);
+    if (numFound != numLookups)
+        printf("    %zu lookups found, expected %zu\n", numFound, numLookups);
+
+    start = benchNow();
+    for (i = 0; i < numKeys; i++) {
+        key = benchKey(i);
+        o->remove(c, &key);
+    }
+    sprintf(label, "%s remove", o->name);
+    benchReport(label, numKeys, benchNow() - start);
+}
+
+int
+main(int argc, char *argv[])
+{
+    static const struct ops tableOps = {"nTable", tableInsert, tablePeek, tableRemove};
+    static const struct ops hashOps = {"nHash", hashInsert, hashPeek, hashRemove};
+    struct nTable       t;
+    struct nHash        h;
+    size_t              numKeys, numLookups;
+
+    numKeys = benchArgSize(argc, argv, 1, 10000000);
+    numLookups = benchArgSize(argc, argv, 2, 1000000);
+
+    nTableInitPool(&t, sizeof(unsigned long long), sizeof(size_t), POOL_SLAB);
+    run(&tableOps, &t, numKeys, numLookups);
+    nTableDestroy(&t);
+
+    if (nHashInit(&h, sizeof(unsigned long long), sizeof(size_t), 0)) {
+        printf("nHashInit failed\n");
+        return 1;
+    }
+    run(&hashOps, &h, numKeys, numLookups);
+    nHashDestroy(&h);
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Memory per entry and lookup latency of nITable against a pooled
+ * nTable, at 1M, 10M and 100M entries up to maxKeys. Keys are 8 bytes
+ * and values 8 bytes; key i is a bijective scramble of i, so lookups of
+ * random present keys need no key array. Memory is the growth of the
+ * resident set while the table is built.
+ *
+ * Usage: itable_bench [numLookups] [maxKeys]
+ */
+
+#define POOL_SLAB 4096
+
+static void
+reportTable(const char *name, size_t numKeys, size_t rssBefore, double buildSecs,
+            double peekSecs, size_t numLookups)
+{
+    printf("%-22s %9zu keys: %6.1f bytes/entry  insert %6.1f ns  peek %6.1f ns\n", name,
+           numKeys, (double)(benchRssKb() - rssBefore) * 1024 / numKeys,
+           buildSecs * 1e9 / numKeys, peekSecs * 1e9 / numLookups);
+}
+
+static void
+runTable(size_t numKeys, size_t numLookups)
+{
+    struct nTable       t;
+    unsigned long long  seed = 0x9E3779B97F4A7C15ULL, key, value = 0, i;
+    size_t              rssBefore = benchRssKb();
+    double              start, buildSecs;
+
+    nTableInitPool(&t, sizeof(key), sizeof(value), POOL_SLAB);
+    start = benchNow();
+    for (i = 0; i < numKeys; i++) {
+        key = benchKey(i);
+        if (nTableInsert(&t, &key, &i)) {
+            printf("nTable ran out of memory at %llu keys\n", i);
+            nTableDestroy(&t);
+            return;
+        }
+    }
+    buildSecs = benchNow() - start;
+
+    start = benchNow();
+    for (i = 0; i < numLookups; i++) {
+        key = benchKey(benchRand(&seed) % numKeys);
+        nTablePeek(&t, &key, &value);
+    }
+    reportTable("nTable (pooled)", numKeys, rssBefore, buildSecs, benchNow() - start, numLookups);
+    nTableDestroy(&t);
+}
+
+static void
+runITable(size_t numKeys, size_t numLookups)
+{
+    struct nITable      t;
+    unsigned long long  seed = 0x9E3779B97F4A7C15ULL, key, value = 0, i;
+    size_t              rssBefore = benchRssKb();
+    double              start, buildSecs;
+
+    nITableInit(&t, sizeof(key), sizeof(value), 0);
+    start = benchNow();
+    for (i = 0; i < numKeys; i++) {
+        key = benchKey(i);
+        if (nITableInsert(&t, &key, &i)) {
+            printf("nITable ran out of memory at %llu keys\n", i);
+            nITableDestroy(&t);
+            return;
+        }
+    }
+    buildSecs = benchNow() - start;
+
+    start = benchNow();
+    for (i = 0; i < numLookups; i++) {
+        key = benchKey(benchRand(&seed) % numKeys);
+        nITablePeek(&t, &key, &value);
+    }
+    reportTable("nITable", numKeys, rssBefore, buildSecs, benchNow() - start, numLookups);
+
+    start = benchNow();
+    if (nITablePack(&t)) {
+        printf("nITablePack ran out of memory\n");
+    } else {
+        buildSecs += benchNow() - start;
+        seed = 0x9E3779B97F4A7C15ULL;
+        start = benchNow();
+        for (i = 0; i < numLookups; i++) {
+            key = benchKey(benchRand(&seed) % numKeys);
+            nITablePeek(&t, &key, &value);
+        }
+        reportTable("nITable after pack", numKeys, rssBefore, buildSecs, benchNow() - start,
+                    numLookups);
+    }
+    nITableDestroy(&t);
+}
+
+int
+main(int argc, char *argv[])
+{
+    size_t              numLookups, maxKeys, numKeys;
+
+    numLookups = benchArgSize(argc, argv, 1, 1000000);
+    maxKeys = benchArgSize(argc, argv, 2, 100000000);
+    for (numKeys = 1000000; numKeys <= maxKeys; numKeys *= 10) {
+        runITable(numKeys, numLookups);
+        runTable(numKeys, numLookups);
+    }
+    return 0;
+}
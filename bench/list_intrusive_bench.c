@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * A queue of 200-byte connection records kept on the copying nList, plain
+ * and pooled, against the intrusive nIList, which links the caller's
+ * records in place. Each list takes numRecords records at the tail and
+ * gives them back from the head. The intrusive list then drops
+ * numRemovals records picked at random, each in constant time; the
+ * copying list can only find such a record with a pass of nListForEach,
+ * so it gets one in FOREACH_SHARE as many.
+ *
+ * Usage: list_intrusive_bench [numRecords] [numRemovals]
+ */
+
+#define RECORD_SIZE 200
+#define POOL_SLAB 4096
+#define FOREACH_SHARE 1000
+
+struct conn {
+    struct nListLink    link;
+    unsigned long long  id;
+    char                payload[RECORD_SIZE - sizeof(struct nListLink) - sizeof(unsigned long long)];
+};
+
+static unsigned long long       victimId;
+
+static enum nBool
+isVictim(void *data)
+{
+    return ((struct conn *)data)->id == victimId;
+}
+
+static void
+runCopying(const char *name, struct nList *l, struct conn *conns, size_t numRecords,
+           size_t numRemovals)
+{
+    unsigned long long  seed = 0x9E3779B97F4A7C15ULL;
+    struct conn         out;
+    size_t              i;
+    double              start;
+    char                label[64];
+
+    start = benchNow();
+    for (i = 0; i < numRecords; i++)
+        if (nListInsertTail(l, &conns[i])) {
+            printf("%s ran out of memory at %zu records\n", name, i);
+            return;
+        }
+    sprintf(label, "%s insert tail", name);
+    benchReport(label, numRecords, benchNow() - start);
+
+    start = benchNow();
+    for (i = 0; i < numRecords; i++)
+        nListRemoveHead(l, &out);
+    sprintf(label, "%s remove head", name);
+    benchReport(label, numRecords, benchNow() - start);
+
+    for (i = 0; i < numRecords; i++)
+        nListInsertTail(l, &conns[i]);
+    start = benchNow();
+    for (i = 0; i < numRemovals / FOREACH_SHARE; i++) {
+        victimId = benchRand(&seed) % numRecords;
+        nListForEach(l, isVictim);
+    }
+    sprintf(label, "%s remove any (foreach)", name);
+    benchReport(label, numRemovals / FOREACH_SHARE, benchNow() - start);
+    nListDestroy(l);
+}
+
+static void
+runIntrusive(struct conn *conns, size_t numRecords, size_t numRemovals)
+{
+    unsigned long long  seed = 0x9E3779B97F4A7C15ULL;
+    struct nIList       l;
+    struct nListLink   *out;
+    size_t              i, numRemoved = 0;
+    double              start;
+
+    nIListInit(&l);
+    start = benchNow();
+    for (i = 0; i < numRecords; i++)
+        nIListInsertTail(&l, &conns[i].link);
+    benchReport("nIList insert tail", numRecords, benchNow() - start);
+
+    start = benchNow();
+    for (i = 0; i < numRecords; i++)
+        nIListRemoveHead(&l, &out);
+    benchReport("nIList remove head", numRecords, benchNow() - start);
+
+    for (i = 0; i < numRecords; i++)
+        nIListInsertTail(&l, &conns[i].link);
+    start = benchNow();
+    for (i = 0; i < numRemovals; i++) {
+        out = &conns[benchRand(&seed) % numRecords].link;
+        if (out->next) {
+            nIListRemove(&l, out);
+            numRemoved++;
+        }
+    }
+    benchReport("nIList remove any", numRemovals, benchNow() - start);
+    printf("    %zu of %zu picks were still linked\n", numRemoved, numRemovals);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct nList        l;
+    struct conn        *conns;
+    size_t              numRecords, numRemovals, i;
+
+    numRecords = benchArgSize(argc, argv, 1, 1000000);
+    numRemovals = benchArgSize(argc, argv, 2, 10000);
+    if (!(conns = calloc(numRecords, sizeof(*conns))))
+        return 1;
+    for (i = 0; i < numRecords; i++)
+        conns[i].id = i;
+
+    nListInit(&l, sizeof(struct conn));
+    runCopying("nList", &l, conns, numRecords, numRemovals);
+    nListInitPool(&l, sizeof(struct conn), POOL_SLAB);
+    runCopying("nList pooled", &l, conns, numRecords, numRemovals);
+    runIntrusive(conns, numRecords, numRemovals);
+    free(conns);
+    return 0;
+}
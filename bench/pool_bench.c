@@ -0,0 +1,88 @@
+#include <stdio.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Steady-state churn on nList and nTable with and without a node pool.
+ * Each run fills a container to n elements, then performs n remove/insert
+ * cycles, so the live size stays constant while every node is recycled.
+ * Run the malloc (nodesPerSlab 0) and pooled modes in separate processes
+ * so that RSS figures are not skewed by memory the other mode freed.
+ *
+ * Usage: pool_bench [maxElems] [nodesPerSlab]
+ */
+
+static void
+listChurn(size_t n, size_t nodesPerSlab)
+{
+    struct nList        list;
+    unsigned long long  elem = 0;
+    size_t              i, rssBefore = benchRssKb(), rssPeak;
+    double              start;
+    char                label[64];
+
+    nListInitPool(&list, sizeof(elem), nodesPerSlab);
+    for (i = 0; i < n; i++, elem++)
+        nListInsertTail(&list, &elem);
+
+    start = benchNow();
+    for (i = 0; i < n; i++) {
+        nListRemoveHead(&list, &elem);
+        nListInsertTail(&list, &elem);
+    }
+    rssPeak = benchRssKb();
+    sprintf(label, "nList %s n=%zu", nodesPerSlab ? "pool  " : "malloc", n);
+    benchReport(label, 2 * n, benchNow() - start);
+
+    start = benchNow();
+    nListDestroy(&list);
+    printf("  RSS growth %8zu KB, destroy %.3f s\n", rssPeak - rssBefore, benchNow() - start);
+}
+
+static void
+tableChurn(size_t n, size_t nodesPerSlab)
+{
+    struct nTable       table;
+    unsigned long long  seed = 2463534242ULL, evict = 2463534242ULL, key;
+    size_t              i, rssBefore = benchRssKb(), rssPeak;
+    double              start;
+    char                label[64];
+
+    nTableInitPool(&table, sizeof(key), sizeof(key), nodesPerSlab);
+    for (i = 0; i < n; i++) {
+        key = benchRand(&seed);
+        nTableInsert(&table, &key, &key);
+    }
+
+    /* Evict the oldest key and insert a fresh one, like a FIFO cache */
+    start = benchNow();
+    for (i = 0; i < n; i++) {
+        key = benchRand(&evict);
+        nTableRemove(&table, &key);
+        key = benchRand(&seed);
+        nTableInsert(&table, &key, &key);
+    }
+    rssPeak = benchRssKb();
+    sprintf(label, "nTable %s n=%zu", nodesPerSlab ? "pool  " : "malloc", n);
+    benchReport(label, 2 * n, benchNow() - start);
+
+    start = benchNow();
+    nTableDestroy(&table);
+    printf("  RSS growth %8zu KB, destroy %.3f s\n", rssPeak - rssBefore, benchNow() - start);
+}
+
+int
+main(int argc, char *argv[])
+{
+    size_t              maxElems, nodesPerSlab, n;
+
+    maxElems = benchArgSize(argc, argv, 1, 1000000);
+    nodesPerSlab = benchArgSize(argc, argv, 2, 4096);
+
+    for (n = 1000; n <= maxElems; n *= 10)
+        listChurn(n, nodesPerSlab);
+    for (n = 1000; n <= maxElems; n *= 10)
+        tableChurn(n, nodesPerSlab);
+    return 0;
+}
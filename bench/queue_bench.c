@@ -0,0 +1,189 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Throughput and enqueue-to-dequeue latency of nQueue against an nList
+ * behind a mutex, for matching numbers of producer and consumer threads
+ * up to maxThreads each. Every element carries the time it was enqueued;
+ * consumers record each element's latency and the percentiles are taken
+ * over all of them. A full or empty queue makes the thread yield.
+ *
+ * Usage: queue_bench [numItems] [maxThreads] [capacity]
+ */
+
+struct benchItem {
+    double                          stamp;
+    size_t                          seq;
+};
+
+struct consumerArgs {
+    pthread_t                       thread;
+    double                         *latencies;
+    size_t                          numLatencies;
+};
+
+static struct nQueue            queue;
+static struct nList             list;
+static pthread_mutex_t          listLock = PTHREAD_MUTEX_INITIALIZER;
+static int                      useList, producersDone;
+static size_t                   itemsPerProducer;
+
+static enum nErrorType
+insertItem(struct benchItem *item)
+{
+    enum nErrorType     ret;
+
+    if (!useList)
+        return nQueueInsertTail(&queue, item);
+    pthread_mutex_lock(&listLock);
+    ret = nListInsertTail(&list, item);
+    pthread_mutex_unlock(&listLock);
+    return ret;
+}
+
+static enum nErrorType
+removeItem(struct benchItem *item)
+{
+    enum nErrorType     ret;
+
+    if (!useList)
+        return nQueueRemoveHead(&queue, item);
+    pthread_mutex_lock(&listLock);
+    ret = nListRemoveHead(&list, item);
+    pthread_mutex_unlock(&listLock);
+    return ret;
+}
+
+static void                    *
+producerLoop(void *arg)
+{
+    struct benchItem    item;
+    size_t              i;
+
+    for (i = 0; i < itemsPerProducer; i++) {
+        item.seq = i;
+        item.stamp = benchNow();
+        while (insertItem(&item))
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void                    *
+consumerLoop(void *arg)
+{
+    struct consumerArgs *args = arg;
+    struct benchItem    item;
+
+    for (;;) {
+        if (!removeItem(&item)) {
+            args->latencies[args->numLatencies++] = benchNow() - item.stamp;
+        } else if (__atomic_load_n(&producersDone, __ATOMIC_ACQUIRE)) {
+            if (removeItem(&item))
+                break;
+            args->latencies[args->numLatencies++] = benchNow() - item.stamp;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static int
+compareLatency(const void *a, const void *b)
+{
+    double              x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void
+runQueue(const char *name, size_t numThreads, size_t numItems, struct consumerArgs *consumers,
+         double *allLatencies)
+{
+    pthread_t          *producers;
+    size_t              i, total = 0;
+    double              start, secs;
+    char                label[64];
+
+    if (!(producers = malloc(numThreads * sizeof(*producers))))
+        return;
+    itemsPerProducer = numItems / numThreads;
+    producersDone = 0;
+    start = benchNow();
+    for (i = 0; i < numThreads; i++) {
+        consumers[i].numLatencies = 0;
+        pthread_create(&consumers[i].thread, NULL, consumerLoop, &consumers[i]);
+    }
+    for (i = 0; i < numThreads; i++)
+        pthread_create(&producers[i], NULL, producerLoop, NULL);
+    for (i = 0; i < numThreads; i++)
+        pthread_join(producers[i], NULL);
+    __atomic_store_n(&producersDone, 1, __ATOMIC_RELEASE);
+    for (i = 0; i < numThreads; i++) {
+        pthread_join(consumers[i].thread, NULL);
+        memcpy(allLatencies + total, consumers[i].latencies,
+               consumers[i].numLatencies * sizeof(double));
+        total += consumers[i].numLatencies;
+    }
+    secs = benchNow() - start;
+    free(producers);
+
+    snprintf(label, sizeof(label), "%s, %zu+%zu threads", name, numThreads, numThreads);
+    benchReport(label, total, secs);
+    qsort(allLatencies, total, sizeof(double), compareLatency);
+    if (total)
+        printf("  latency p50 %9.0f ns  p99 %9.0f ns  p99.9 %9.0f ns  max %9.0f ns\n",
+               allLatencies[total / 2] * 1e9, allLatencies[total * 99 / 100] * 1e9,
+               allLatencies[total * 999 / 1000] * 1e9, allLatencies[total - 1] * 1e9);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct consumerArgs *consumers;
+    double             *allLatencies;
+    size_t              numItems, maxThreads, capacity, numThreads, i;
+
+    numItems = benchArgSize(argc, argv, 1, 1000000);
+    maxThreads = benchArgSize(argc, argv, 2, 8);
+    capacity = benchArgSize(argc, argv, 3, 1024);
+    consumers = calloc(maxThreads, sizeof(*consumers));
+    allLatencies = malloc(numItems * sizeof(double));
+    if (!consumers || !allLatencies)
+        return 1;
+    for (i = 0; i < maxThreads; i++)
+        if (!(consumers[i].latencies = malloc(numItems * sizeof(double))))
+            return 1;
+
+    useList = 0;
+    nQueueInitSPSC(&queue, capacity, sizeof(struct benchItem));
+    runQueue("nQueue SPSC", 1, numItems, consumers, allLatencies);
+    nQueueDestroy(&queue);
+
+    for (numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        useList = 0;
+        nQueueInit(&queue, capacity, sizeof(struct benchItem));
+        runQueue("nQueue MPMC", numThreads, numItems, consumers, allLatencies);
+        nQueueDestroy(&queue);
+
+        useList = 1;
+        nListInit(&list, sizeof(struct benchItem));
+        runQueue("nList behind a mutex", numThreads, numItems, consumers, allLatencies);
+        nListDestroy(&list);
+    }
+
+    for (i = 0; i < maxThreads; i++)
+        free(consumers[i].latencies);
+    free(consumers);
+    free(allLatencies);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <stdio.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Amortized push/pop cost and memory of a growable nStack against a
+ * fixed-capacity one sized for the worst case up front
+ *
+ * Usage: stack_bench [numElems]
+ */
+
+static void
+run(const char *name, struct nStack *s, size_t numElems)
+{
+    unsigned long long  elem;
+    size_t              i, rssBefore = benchRssKb(), rssPeak;
+    double              start;
+    char                label[64];
+
+    start = benchNow();
+    for (elem = 0; elem < numElems; elem++)
+        nStackPush(s, &elem);
+    sprintf(label, "%s push", name);
+    benchReport(label, numElems, benchNow() - start);
+    rssPeak = benchRssKb();
+
+    start = benchNow();
+    for (i = 0; i < numElems; i++)
+        nStackPop(s, &elem);
+    sprintf(label, "%s pop", name);
+    benchReport(label, numElems, benchNow() - start);
+    printf("  capacity after drain %zu elements, RSS growth at peak %zu KB, after drain %zu KB\n",
+           s->maxElem, rssPeak - rssBefore, benchRssKb() - rssBefore);
+    nStackDestroy(s);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct nStack       s;
+    size_t              numElems;
+
+    numElems = benchArgSize(argc, argv, 1, 50000000);
+
+    if (nStackInitM(&s, numElems, sizeof(unsigned long long)))
+        return 1;
+    run("fixed", &s, numElems);
+
+    if (nStackInitG(&s, 16, 0, sizeof(unsigned long long)))
+        return 1;
+    run("growable", &s, numElems);
+
+    /* A workload that never gets deep pays only for what it uses */
+    if (nStackInitM(&s, numElems, sizeof(unsigned long long)))
+        return 1;
+    run("fixed, shallow", &s, 1000);
+    if (nStackInitG(&s, 16, 0, sizeof(unsigned long long)))
+        return 1;
+    run("growable, shallow", &s, 1000);
+    return 0;
+}
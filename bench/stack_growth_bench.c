@@ -0,0 +1,84 @@
+#include <stdio.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Per-push latency of a growable nStack, which copies every element each
+ * time it doubles, against a segmented one, which links in a new block.
+ * Every push is timed on its own and counted in a histogram, so the rare
+ * pushes that pay for growing show up next to the typical one. Elements
+ * are 16 bytes.
+ *
+ * Usage: stack_growth_bench [numElems] [blockElems]
+ */
+
+#define NUM_BUCKETS 7
+
+struct elem {
+    unsigned long long  a, b;
+};
+
+static const double             bucketLimits[NUM_BUCKETS - 1] = {
+    100e-9, 1e-6, 10e-6, 100e-6, 1e-3, 10e-3
+};
+static const char              *bucketNames[NUM_BUCKETS] = {
+    "<100ns", "<1us", "<10us", "<100us", "<1ms", "<10ms", ">=10ms"
+};
+
+static void
+run(const char *name, struct nStack *s, size_t numElems)
+{
+    size_t              counts[NUM_BUCKETS] = {0}, i, b;
+    struct elem         e = {0, 0};
+    double              start, opStart, opSecs, maxOpSecs = 0;
+    char                label[64];
+
+    start = benchNow();
+    for (i = 0; i < numElems; i++) {
+        e.a = i;
+        opStart = benchNow();
+        if (nStackPush(s, &e)) {
+            printf("%s ran out of memory at %zu elements\n", name, i);
+            break;
+        }
+        opSecs = benchNow() - opStart;
+        if (opSecs > maxOpSecs)
+            maxOpSecs = opSecs;
+        for (b = 0; b < NUM_BUCKETS - 1 && opSecs >= bucketLimits[b]; b++)
+            ;
+        counts[b]++;
+    }
+    sprintf(label, "%s push (timed singly)", name);
+    benchReport(label, i, benchNow() - start);
+    printf("    slowest push %.1f us, peak RSS %zu KB\n   ", maxOpSecs * 1e6, benchRssKb());
+    for (b = 0; b < NUM_BUCKETS; b++)
+        printf(" %s %zu", bucketNames[b], counts[b]);
+    printf("\n");
+
+    start = benchNow();
+    while (nStackPop(s, &e) == nCodeSuccess)
+        ;
+    sprintf(label, "%s pop", name);
+    benchReport(label, i, benchNow() - start);
+    nStackDestroy(s);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct nStack       s;
+    size_t              numElems, blockElems;
+
+    numElems = benchArgSize(argc, argv, 1, 20000000);
+    blockElems = benchArgSize(argc, argv, 2, 4096);
+
+    if (nStackInitG(&s, 16, 0, sizeof(struct elem)))
+        return 1;
+    run("growable", &s, numElems);
+
+    if (nStackInitS(&s, blockElems, 0, sizeof(struct elem)))
+        return 1;
+    run("segmented", &s, numElems);
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Random lookups on a table larger than the last-level cache, one key at a
+ * time with nTablePeek versus batches through nTablePeekBatch
+ *
+ * Usage: table_batch_bench [numKeys] [batchSize]
+ */
+
+int
+main(int argc, char *argv[])
+{
+    struct nTable       table;
+    unsigned long long *keys, *probes, *values, seed = 0xDEADBEEFULL;
+    enum nErrorType    *status;
+    size_t              numKeys, batchSize, i, found = 0;
+    double              start;
+
+    numKeys = benchArgSize(argc, argv, 1, 8000000);
+    batchSize = benchArgSize(argc, argv, 2, 256);
+    keys = malloc(numKeys * sizeof(*keys));
+    probes = malloc(numKeys * sizeof(*probes));
+    values = malloc(numKeys * sizeof(*values));
+    status = malloc(numKeys * sizeof(*status));
+    if (!keys || !probes || !values || !status)
+        return 1;
+
+    nTableInitPool(&table, sizeof(*keys), sizeof(*values), 4096);
+    for (i = 0; i < numKeys; i++) {
+        keys[i] = benchRand(&seed);
+        nTableInsert(&table, keys + i, keys + i);
+    }
+    for (i = 0; i < numKeys; i++)
+        probes[i] = keys[benchRand(&seed) % numKeys];
+
+    start = benchNow();
+    for (i = 0; i < numKeys; i++)
+        found += !nTablePeek(&table, probes + i, values + i);
+    benchReport("nTablePeek loop", numKeys, benchNow() - start);
+
+    start = benchNow();
+    for (i = 0; i < numKeys; i += batchSize) {
+        found += nTablePeekBatch(&table, probes + i, i + batchSize > numKeys ? numKeys - i : batchSize,
+                                 values + i, status + i);
+    }
+    benchReport("nTablePeekBatch", numKeys, benchNow() - start);
+
+    nTableDestroy(&table);
+    free(keys);
+    free(probes);
+    free(values);
+    free(status);
+    return found == 2 * numKeys ? 0 : 1;
+}
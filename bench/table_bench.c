@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Insert and lookup throughput for nTable with small fixed-size keys
+ *
+ * Usage: table_bench [numKeys]
+ */
+
+int
+main(int argc, char *argv[])
+{
+    struct nTable       table;
+    unsigned long long *keys, seed = 88172645463325252ULL, value;
+    size_t              numKeys, i, found = 0;
+    size_t              rssBefore;
+    double              start;
+
+    numKeys = benchArgSize(argc, argv, 1, 1000000);
+    if (!(keys = malloc(numKeys * sizeof(*keys))))
+        return 1;
+    for (i = 0; i < numKeys; i++)
+        keys[i] = benchRand(&seed);
+
+    rssBefore = benchRssKb();
+    nTableInit(&table, sizeof(*keys), sizeof(value));
+
+    start = benchNow();
+    for (i = 0; i < numKeys; i++) {
+        if (nTableInsert(&table, keys + i, keys + i))
+            return 1;
+    }
+    benchReport("nTableInsert, 8-byte keys", numKeys, benchNow() - start);
+    printf("%-44.44s %12.1f bytes\n", "RSS per entry",
+           (benchRssKb() - rssBefore) * 1024.0 / numKeys);
+
+    /* Look up in a different order than insertion */
+    start = benchNow();
+    for (i = 0; i < numKeys; i++) {
+        if (!nTablePeek(&table, keys + (i * 7919) % numKeys, &value))
+            found++;
+    }
+    benchReport("nTablePeek, 8-byte keys", numKeys, benchNow() - start);
+
+    free(keys);
+    return found == numKeys ? 0 : 1;
+}
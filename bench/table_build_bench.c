@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Startup time of an nTable filled from a sorted snapshot: nTableBuildSorted
+ * against nTableInsert of the same keys in order, with nodes from malloc
+ * and from a node pool. Keys are 8-byte big-endian integers with random
+ * gaps, values 8 bytes.
+ *
+ * Usage: table_build_bench [numKeys]
+ */
+
+#define POOL_SLAB 4096
+
+static void
+run(const unsigned char *keys, const unsigned long long *values, size_t numKeys,
+    size_t nodesPerSlab, enum nBool bulk)
+{
+    struct nTable       t;
+    unsigned long long  seed = 0x2545F4914F6CDD1DULL, value;
+    size_t              i;
+    double              start, buildSecs;
+    char                label[64];
+
+    nTableInitPool(&t, 8, sizeof(value), nodesPerSlab);
+    start = benchNow();
+    if (bulk) {
+        if (nTableBuildSorted(&t, keys, values, numKeys)) {
+            printf("nTableBuildSorted failed\n");
+            return;
+        }
+    } else {
+        for (i = 0; i < numKeys; i++) {
+            if (nTableInsert(&t, keys + i * 8, values + i)) {
+                printf("nTableInsert ran out of memory at %zu keys\n", i);
+                nTableDestroy(&t);
+                return;
+            }
+        }
+    }
+    buildSecs = benchNow() - start;
+    sprintf(label, "%s (%s)", bulk ? "nTableBuildSorted" : "nTableInsert",
+            nodesPerSlab ? "pool" : "malloc");
+    benchReport(label, numKeys, buildSecs);
+
+    /* Spot-check that the table answers lookups */
+    for (i = 0; i < 1000; i++) {
+        value = benchRand(&seed) % numKeys;
+        if (nTablePeek(&t, keys + value * 8, &value) || value >= numKeys) {
+            printf("lookup failed\n");
+            break;
+        }
+    }
+    nTableDestroy(&t);
+}
+
+int
+main(int argc, char *argv[])
+{
+    unsigned char      *keys;
+    unsigned long long *values, seed = 0x853C49E6748FEA9BULL, k = 0;
+    size_t              numKeys, i;
+    int                 byte;
+
+    numKeys = benchArgSize(argc, argv, 1, 10000000);
+    keys = malloc(numKeys * 8);
+    values = malloc(numKeys * sizeof(*values));
+    if (!keys || !values) {
+        printf("out of memory\n");
+        return 1;
+    }
+    for (i = 0; i < numKeys; i++) {
+        k += 1 + benchRand(&seed) % 1000;
+        for (byte = 0; byte < 8; byte++)
+            keys[i * 8 + byte] = k >> (56 - 8 * byte);
+        values[i] = i;
+    }
+
+    run(keys, values, numKeys, 0, nFalse);
+    run(keys, values, numKeys, 0, nTrue);
+    run(keys, values, numKeys, POOL_SLAB, nFalse);
+    run(keys, values, numKeys, POOL_SLAB, nTrue);
+    free(keys);
+    free(values);
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Per-operation latency of nTable lookup, insert and remove across key
+ * widths. Keys are random bytes, so trie depth grows with the table size
+ * rather than with the key width. Keys of a kilobyte and up, whose bit
+ * offsets pass 32767 at 4 KB, use numKeys / 64 keys to bound memory.
+ *
+ * Usage: table_keysize_bench [numKeys]
+ */
+
+static void
+runKeySize(size_t keySize, size_t numKeys)
+{
+    struct nTable       table;
+    unsigned long long  seed = 0x9E3779B97F4A7C15ULL, value = 0;
+    unsigned char      *keys;
+    size_t              i, b;
+    double              start, insertNs, peekNs, removeNs;
+
+    if (!(keys = malloc(keySize * numKeys)))
+        return;
+    for (i = 0; i < numKeys; i++) {
+        for (b = 0; b < keySize; b++)
+            keys[i * keySize + b] = benchRand(&seed);
+    }
+
+    nTableInit(&table, keySize, sizeof(value));
+    start = benchNow();
+    for (i = 0; i < numKeys; i++)
+        nTableInsert(&table, keys + i * keySize, &value);
+    insertNs = (benchNow() - start) * 1e9 / numKeys;
+
+    start = benchNow();
+    for (i = 0; i < numKeys; i++)
+        nTablePeek(&table, keys + (i * 7919 % numKeys) * keySize, &value);
+    peekNs = (benchNow() - start) * 1e9 / numKeys;
+
+    start = benchNow();
+    for (i = 0; i < numKeys; i++)
+        nTableRemove(&table, keys + (i * 7919 % numKeys) * keySize);
+    removeNs = (benchNow() - start) * 1e9 / numKeys;
+
+    printf("%5zu-byte keys: insert %7.1f ns  peek %7.1f ns  remove %7.1f ns\n",
+           keySize, insertNs, peekNs, removeNs);
+    nTableDestroy(&table);
+    free(keys);
+}
+
+int
+main(int argc, char *argv[])
+{
+    const size_t        keySizes[] = {4, 8, 16, 64}, largeKeySizes[] = {1024, 8192, 65536};
+    size_t              numKeys, i;
+
+    numKeys = benchArgSize(argc, argv, 1, 1000000);
+    for (i = 0; i < sizeof(keySizes) / sizeof(keySizes[0]); i++)
+        runKeySize(keySizes[i], numKeys);
+    for (i = 0; i < sizeof(largeKeySizes) / sizeof(largeKeySizes[0]); i++)
+        runKeySize(largeKeySizes[i], numKeys / 64);
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Longest-prefix match over a synthetic IPv4 routing table. Prefix lengths
+ * follow the rough shape of a full BGP table: mostly /24, then /16 to /23,
+ * a few shorter routes and some host routes. Each lookup address falls
+ * inside a random route, so every lookup walks to a real match.
+ *
+ * nTableLongestMatch is compared with one exact lookup per prefix length
+ * in a plain table keyed by (masked address, length), longest first.
+ *
+ * Usage: table_lpm_bench [numRoutes] [numLookups]
+ */
+
+static unsigned int
+routeBits(unsigned long long r)
+{
+    unsigned int        pick = r % 100;
+
+    if (pick < 60)
+        return 24;
+    if (pick < 95)
+        return 16 + r / 100 % 8;
+    if (pick < 98)
+        return 8 + r / 100 % 8;
+    return 32;
+}
+
+static unsigned int
+maskBits(unsigned int bits)
+{
+    return bits ? 0xffffffffu << (32 - bits) : 0;
+}
+
+static void
+putAddr(unsigned char *key, unsigned int addr)
+{
+    key[0] = addr >> 24;
+    key[1] = addr >> 16;
+    key[2] = addr >> 8;
+    key[3] = addr;
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct nTable       lpm, exact;
+    unsigned long long  seed = 0x9E3779B97F4A7C15ULL, r;
+    unsigned int       *addrs, *bits, addr, value, sum = 0;
+    unsigned char       key[5];
+    size_t              numRoutes, numLookups, i, matchedBits, found = 0;
+    int                 len;
+    double              start, secs;
+
+    numRoutes = benchArgSize(argc, argv, 1, 1000000);
+    numLookups = benchArgSize(argc, argv, 2, 100000000);
+    addrs = malloc(numRoutes * sizeof(*addrs));
+    bits = malloc(numRoutes * sizeof(*bits));
+    if (!addrs || !bits)
+        return 1;
+
+    nTableInitPrefix(&lpm, 4, sizeof(value), 4096);
+    nTableInitPool(&exact, sizeof(key), sizeof(value), 4096);
+    start = benchNow();
+    for (i = 0; i < numRoutes; i++) {
+        r = benchRand(&seed);
+        bits[i] = routeBits(r);
+        addrs[i] = (r >> 32) & maskBits(bits[i]);
+        value = i;
+        putAddr(key, addrs[i]);
+        nTableInsertPrefix(&lpm, key, bits[i], &value);
+    }
+    benchReport("nTableInsertPrefix", numRoutes, benchNow() - start);
+    for (i = 0; i < numRoutes; i++) {
+        value = i;
+        putAddr(key, addrs[i]);
+        key[4] = bits[i];
+        nTableInsert(&exact, key, &value);
+    }
+    printf("%zu routes, %zu distinct\n", numRoutes, nTableSize(&lpm));
+
+    start = benchNow();
+    for (i = 0; i < numLookups; i++) {
+        r = benchRand(&seed);
+        addr = addrs[r % numRoutes] | ((r >> 32) & ~maskBits(bits[r % numRoutes]));
+        putAddr(key, addr);
+        if (!nTableLongestMatch(&lpm, key, &value, &matchedBits)) {
+            sum += value;
+            found++;
+        }
+    }
+    secs = benchNow() - start;
+    benchReport("nTableLongestMatch", numLookups, secs);
+    printf("  %.0f lookups/s, %zu matched (checksum %u)\n", numLookups / secs, found, sum);
+
+    /* The per-length baseline is much slower, so it runs a tenth as many lookups */
+    numLookups /= 10;
+    found = 0;
+    start = benchNow();
+    for (i = 0; i < numLookups; i++) {
+        r = benchRand(&seed);
+        addr = addrs[r % numRoutes] | ((r >> 32) & ~maskBits(bits[r % numRoutes]));
+        for (len = 32; len >= 0; len--) {
+            putAddr(key, addr & maskBits(len));
+            key[4] = len;
+            if (!nTablePeek(&exact, key, &value)) {
+                found++;
+                break;
+            }
+        }
+    }
+    secs = benchNow() - start;
+    benchReport("nTablePeek per prefix length", numLookups, secs);
+    printf("  %.0f lookups/s, %zu matched\n", numLookups / secs, found);
+
+    nTableDestroy(&lpm);
+    nTableDestroy(&exact);
+    free(addrs);
+    free(bits);
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Insert throughput for long keys sharing a long common prefix, which
+ * makes the bit-difference search scan most of every key
+ *
+ * Usage: table_prefix_bench [numKeys]
+ */
+
+static void
+runKeySize(size_t keySize, size_t numKeys)
+{
+    struct nTable       table;
+    unsigned long long  seed = 0x2545F4914F6CDD1DULL, tail;
+    unsigned char      *keys;
+    size_t              i, value = 0, prefixLen = keySize - sizeof(tail);
+    double              start;
+    char                label[64];
+
+    if (!(keys = malloc(keySize * numKeys)))
+        return;
+    for (i = 0; i < numKeys; i++) {
+        memset(keys + i * keySize, 0xA5, prefixLen);
+        tail = benchRand(&seed);
+        memcpy(keys + i * keySize + prefixLen, &tail, sizeof(tail));
+    }
+
+    nTableInit(&table, keySize, sizeof(value));
+    start = benchNow();
+    for (i = 0; i < numKeys; i++)
+        nTableInsert(&table, keys + i * keySize, &value);
+    sprintf(label, "nTableInsert, %zu-byte keys, %zu-byte prefix", keySize, prefixLen);
+    benchReport(label, numKeys, benchNow() - start);
+
+    nTableDestroy(&table);
+    free(keys);
+}
+
+int
+main(int argc, char *argv[])
+{
+    const size_t        keySizes[] = {16, 32, 64, 256};
+    size_t              numKeys, i;
+
+    numKeys = benchArgSize(argc, argv, 1, 200000);
+    for (i = 0; i < sizeof(keySizes) / sizeof(keySizes[0]); i++)
+        runKeySize(keySizes[i], numKeys);
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <stdio.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * nTableRange cost against table size and result size. Keys are random
+ * 64-bit values stored big-endian, so a range of width w * 2^64 / n holds
+ * about w keys of a table of n. A full nTableForEach filter over the
+ * largest table shows the cost of a scan without ordered access.
+ *
+ * Usage: table_range_bench [maxKeys]
+ */
+
+#define RANGE_SCANS 2000
+
+static size_t                   numResults;
+static unsigned long long       rangeLo, rangeHi;
+
+static void
+putKey(unsigned char *key, unsigned long long k)
+{
+    int                 i;
+
+    for (i = 7; i >= 0; i--, k >>= 8)
+        key[i] = k & 0xff;
+}
+
+static unsigned long long
+getKey(const unsigned char *key)
+{
+    unsigned long long  k = 0;
+    int                 i;
+
+    for (i = 0; i < 8; i++)
+        k = k << 8 | key[i];
+    return k;
+}
+
+static enum nBool
+countResult(void *key, void *value)
+{
+    numResults++;
+    return nFalse;
+}
+
+static enum nBool
+filterResult(void *key, void *value)
+{
+    unsigned long long  k = getKey(key);
+
+    if (k >= rangeLo && k <= rangeHi)
+        numResults++;
+    return nFalse;
+}
+
+static void
+runRanges(struct nTable *t, size_t numKeys, unsigned long long width)
+{
+    unsigned long long  seed = 12345, span = ~0ULL / numKeys * width;
+    unsigned char       lo[8], hi[8];
+    size_t              i;
+    double              start, secs;
+
+    numResults = 0;
+    start = benchNow();
+    for (i = 0; i < RANGE_SCANS; i++) {
+        rangeLo = benchRand(&seed) % (~0ULL - span);
+        putKey(lo, rangeLo);
+        putKey(hi, rangeLo + span);
+        nTableRange(t, lo, hi, countResult);
+    }
+    secs = benchNow() - start;
+    printf("%8zu keys, ~%4llu per range: %9.0f ns/scan  %6.1f ns/result  (%.1f results)\n",
+           numKeys, width, secs * 1e9 / RANGE_SCANS, secs * 1e9 / (numResults ? numResults : 1),
+           (double)numResults / RANGE_SCANS);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct nTable       table;
+    unsigned long long  seed = 88172645463325252ULL, value = 0, width, span;
+    unsigned char       key[8];
+    size_t              maxKeys, numKeys, i, scans = 20;
+    double              start;
+
+    maxKeys = benchArgSize(argc, argv, 1, 1000000);
+    for (numKeys = 10000; numKeys <= maxKeys; numKeys *= 10) {
+        nTableInitPool(&table, sizeof(key), sizeof(value), 4096);
+        for (i = 0; i < numKeys; i++) {
+            putKey(key, benchRand(&seed));
+            nTableInsert(&table, key, &value);
+        }
+        for (width = 10; width <= 1000; width *= 10)
+            runRanges(&table, numKeys, width);
+        if (numKeys * 10 > maxKeys) {
+            span = ~0ULL / numKeys * 100;
+            numResults = 0;
+            start = benchNow();
+            for (i = 0; i < scans; i++) {
+                rangeLo = benchRand(&seed) % (~0ULL - span);
+                rangeHi = rangeLo + span;
+                nTableForEach(&table, filterResult);
+            }
+            printf("%8zu keys, ~ 100 per range, ForEach filter: %9.0f ns/scan\n", numKeys,
+                   (benchNow() - start) * 1e9 / scans);
+        }
+        nTableDestroy(&table);
+    }
+    return 0;
+}
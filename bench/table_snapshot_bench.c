@@ -0,0 +1,88 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Cold start of a large nTable: rebuilding it with nTableInsert against
+ * mapping a snapshot written by nTableSave, each followed by random
+ * lookups. The snapshot's pages are dropped from the page cache before it
+ * is mapped where the system allows, so its lookups pay for the reads.
+ * Keys are 8 bytes and values 8 bytes.
+ *
+ * Usage: table_snapshot_bench [numKeys] [numLookups] [path]
+ */
+
+static void
+lookups(struct nTable *t, const char *label, size_t numKeys, size_t numLookups)
+{
+    unsigned long long  seed = 0x9E3779B97F4A7C15ULL, key, value;
+    size_t              i, numFound = 0;
+    double              start = benchNow();
+
+    for (i = 0; i < numLookups; i++) {
+        key = benchKey(benchRand(&seed) % numKeys);
+        numFound += nTablePeek(t, &key, &value) == nCodeSuccess && value == key + 1;
+    }
+    benchReport(label, numLookups, benchNow() - start);
+    if (numFound != numLookups)
+        printf("    only %zu of %zu keys found\n", numFound, numLookups);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct nTable       t;
+    unsigned long long  key, value;
+    size_t              numKeys, numLookups, i;
+    const char         *path;
+    double              start;
+    int                 fd;
+
+    numKeys = benchArgSize(argc, argv, 1, 10000000);
+    numLookups = benchArgSize(argc, argv, 2, 1000000);
+    path = argc > 3 ? argv[3] : "/tmp/table_snapshot_bench.bin";
+
+    nTableInitPool(&t, sizeof(key), sizeof(value), 4096);
+    start = benchNow();
+    for (i = 0; i < numKeys; i++) {
+        key = benchKey(i);
+        value = key + 1;
+        if (nTableInsert(&t, &key, &value)) {
+            printf("nTableInsert ran out of memory at %zu keys\n", i);
+            return 1;
+        }
+    }
+    benchReport("rebuild with nTableInsert", numKeys, benchNow() - start);
+    lookups(&t, "nTablePeek after rebuild", numKeys, numLookups);
+
+    if ((fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0) {
+        perror(path);
+        return 1;
+    }
+    start = benchNow();
+    if (nTableSave(&t, fd) || fsync(fd)) {
+        printf("nTableSave failed\n");
+        return 1;
+    }
+    benchReport("nTableSave and fsync", numKeys, benchNow() - start);
+    nTableDestroy(&t);
+#ifdef POSIX_FADV_DONTNEED
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+    close(fd);
+
+    start = benchNow();
+    if (nTableMapReadOnly(&t, path)) {
+        printf("nTableMapReadOnly failed\n");
+        return 1;
+    }
+    benchReport("nTableMapReadOnly", numKeys, benchNow() - start);
+    lookups(&t, "nTablePeek on cold mapping", numKeys, numLookups);
+    lookups(&t, "nTablePeek on warm mapping", numKeys, numLookups);
+    nTableDestroy(&t);
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <stdio.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Full-table iteration and teardown time for a large nTable, with nodes
+ * from malloc and from a node pool
+ *
+ * Usage: table_teardown_bench [numKeys]
+ */
+
+static size_t                   numVisited;
+
+static enum nBool
+countEntry(void *key, void *value)
+{
+    numVisited++;
+    return nFalse;
+}
+
+static void
+run(size_t numKeys, size_t nodesPerSlab)
+{
+    struct nTable       table;
+    unsigned long long  seed = 0x853C49E6748FEA9BULL, key;
+    size_t              i;
+    double              start;
+    char                label[64];
+
+    nTableInitPool(&table, sizeof(key), sizeof(key), nodesPerSlab);
+    for (i = 0; i < numKeys; i++) {
+        key = benchRand(&seed);
+        nTableInsert(&table, &key, &key);
+    }
+
+    numVisited = 0;
+    start = benchNow();
+    nTableForEach(&table, countEntry);
+    sprintf(label, "nTableForEach (%s)", nodesPerSlab ? "pool" : "malloc");
+    benchReport(label, numVisited, benchNow() - start);
+
+    start = benchNow();
+    nTableDestroy(&table);
+    sprintf(label, "nTableDestroy (%s)", nodesPerSlab ? "pool" : "malloc");
+    benchReport(label, numKeys, benchNow() - start);
+}
+
+int
+main(int argc, char *argv[])
+{
+    size_t              numKeys;
+
+    numKeys = benchArgSize(argc, argv, 1, 10000000);
+    run(numKeys, 0);
+    run(numKeys, 4096);
+    return 0;
+}
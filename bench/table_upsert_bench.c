@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Word counts over a synthetic corpus in a variable-length key nTable:
+ * nTablePeek, an nTableInsert of a zero count for a new word and an
+ * nTableInsert of the incremented count, against one nTableUpsertVar.
+ * Words come from a vocabulary of numWords random lowercase strings of 2
+ * to 12 letters, drawn with a heavy skew toward the first ones, so most
+ * tokens hit a word already counted and the tail keeps adding new ones.
+ *
+ * Usage: table_upsert_bench [numTokens] [numWords]
+ */
+
+#define MAX_WORD 12
+#define POOL_SLAB 4096
+
+struct word {
+    char                bytes[MAX_WORD];
+    size_t              len;
+};
+
+static void
+addOne(void *value)
+{
+    unsigned long long  count;
+
+    memcpy(&count, value, sizeof(count));
+    count++;
+    memcpy(value, &count, sizeof(count));
+}
+
+/*
+ * Index of a word to draw: a uniform draw below a uniform draw below a
+ * uniform draw, which favors low indexes much as word frequencies do
+ */
+static size_t
+skewedIndex(unsigned long long *seed, size_t numWords)
+{
+    size_t              i = numWords;
+    int                 level;
+
+    for (level = 0; level < 3; level++)
+        i = benchRand(seed) % i + 1;
+    return i - 1;
+}
+
+static unsigned long long
+countWords(const char *name, const struct word *vocab, const size_t *tokens, size_t numTokens,
+           enum nBool upsert)
+{
+    struct nTable       t;
+    unsigned long long  count, total = 0;
+    const struct word  *w;
+    size_t              i;
+    double              start;
+
+    nTableInitVar(&t, sizeof(count), POOL_SLAB);
+    start = benchNow();
+    for (i = 0; i < numTokens; i++) {
+        w = &vocab[tokens[i]];
+        if (upsert) {
+            nTableUpsertVar(&t, w->bytes, w->len, NULL, addOne);
+        } else {
+            if (nTablePeekVar(&t, w->bytes, w->len, &count)) {
+                count = 0;
+                nTableInsertVar(&t, w->bytes, w->len, &count);
+            }
+            count++;
+            nTableInsertVar(&t, w->bytes, w->len, &count);
+        }
+    }
+    benchReport(name, numTokens, benchNow() - start);
+    printf("    %zu distinct words\n", nTableSize(&t));
+    for (i = 0; i < numTokens; i++) {
+        w = &vocab[tokens[i]];
+        if (!nTablePeekVar(&t, w->bytes, w->len, &count))
+            total += count;
+    }
+    nTableDestroy(&t);
+    return total;
+}
+
+int
+main(int argc, char *argv[])
+{
+    unsigned long long  seed = 0x9E3779B97F4A7C15ULL, sumPeek, sumUpsert;
+    struct word        *vocab;
+    size_t              numTokens, numWords, i, j, *tokens;
+
+    numTokens = benchArgSize(argc, argv, 1, 5000000);
+    numWords = benchArgSize(argc, argv, 2, 200000);
+    vocab = malloc(numWords * sizeof(*vocab));
+    tokens = malloc(numTokens * sizeof(*tokens));
+    if (!vocab || !tokens)
+        return 1;
+
+    for (i = 0; i < numWords; i++) {
+        vocab[i].len = 2 + benchRand(&seed) % (MAX_WORD - 1);
+        for (j = 0; j < vocab[i].len; j++)
+            vocab[i].bytes[j] = 'a' + benchRand(&seed) % 26;
+    }
+    for (i = 0; i < numTokens; i++)
+        tokens[i] = skewedIndex(&seed, numWords);
+
+    sumPeek = countWords("peek + insert + insert", vocab, tokens, numTokens, nFalse);
+    sumUpsert = countWords("nTableUpsertVar", vocab, tokens, numTokens, nTrue);
+    if (sumPeek != sumUpsert)
+        printf("counts differ: %llu against %llu\n", sumPeek, sumUpsert);
+    free(tokens);
+    free(vocab);
+    return 0;
+}
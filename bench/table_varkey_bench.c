@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * URL-like string keys stored in a variable-length key table against the
+ * same keys zero-padded to a fixed worst-case width. Run each mode in its
+ * own process so that RSS figures are not skewed by the other mode.
+ *
+ * Usage: table_varkey_bench padded|var [numKeys]
+ */
+
+#define PAD_WIDTH 128
+
+static const char              *hosts[] = {
+    "www.example.com", "api.example.org", "cdn.static-assets.net", "docs.project.io",
+    "shop.store-front.com", "news.daily-report.co.uk", "m.social.app", "mail.provider.net"
+};
+
+static const char              *words[] = {
+    "index", "users", "v2", "search", "images", "product", "category", "archive",
+    "2024", "blog", "assets", "api", "settings", "profile", "checkout", "help"
+};
+
+#define NUM_HOSTS (sizeof(hosts) / sizeof(hosts[0]))
+#define NUM_WORDS (sizeof(words) / sizeof(words[0]))
+
+/* Write a URL of up to PAD_WIDTH - 1 characters and return its length */
+static size_t
+makeUrl(char *url, unsigned long long *seed)
+{
+    unsigned long long  r = benchRand(seed);
+    size_t              len, segs, i;
+
+    len = sprintf(url, "https://%s", hosts[r % NUM_HOSTS]);
+    segs = 1 + (r >> 8) % 4;
+    for (i = 0; i < segs; i++)
+        len += sprintf(url + len, "/%s", words[(r >> (12 + 4 * i)) % NUM_WORDS]);
+    len += sprintf(url + len, "?id=%llu", (r >> 32) % 100000000);
+    return len;
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct nTable       table;
+    unsigned long long  seed = 0x2545F4914F6CDD1DULL, value = 0;
+    char               *keys;
+    size_t             *lens, numKeys, i, j, totalLen = 0, rssBefore, rssAfter;
+    enum nBool          padded;
+    double              start, insertSecs, peekSecs;
+
+    if (argc < 2 || (strcmp(argv[1], "padded") && strcmp(argv[1], "var"))) {
+        printf("Usage: %s padded|var [numKeys]\n", argv[0]);
+        return 1;
+    }
+    padded = strcmp(argv[1], "padded") ? nFalse : nTrue;
+    numKeys = benchArgSize(argc, argv, 2, 1000000);
+
+    keys = calloc(numKeys, PAD_WIDTH);
+    lens = malloc(numKeys * sizeof(*lens));
+    if (!keys || !lens)
+        return 1;
+    for (i = 0; i < numKeys; i++)
+        totalLen += lens[i] = makeUrl(keys + i * PAD_WIDTH, &seed);
+    printf("%zu keys, mean length %.1f bytes, padded to %d\n", numKeys,
+           (double)totalLen / numKeys, PAD_WIDTH);
+
+    rssBefore = benchRssKb();
+    if (padded)
+        nTableInitPool(&table, PAD_WIDTH, sizeof(value), 4096);
+    else
+        nTableInitVar(&table, sizeof(value), 4096);
+    start = benchNow();
+    for (i = 0; i < numKeys; i++, value++) {
+        if (padded)
+            nTableInsert(&table, keys + i * PAD_WIDTH, &value);
+        else
+            nTableInsertVar(&table, keys + i * PAD_WIDTH, lens[i], &value);
+    }
+    insertSecs = benchNow() - start;
+    rssAfter = benchRssKb();
+
+    start = benchNow();
+    for (i = 0; i < numKeys; i++) {
+        j = i * 7919 % numKeys;
+        if (padded)
+            nTablePeek(&table, keys + j * PAD_WIDTH, &value);
+        else
+            nTablePeekVar(&table, keys + j * PAD_WIDTH, lens[j], &value);
+    }
+    peekSecs = benchNow() - start;
+
+    benchReport(padded ? "nTableInsert, padded keys" : "nTableInsertVar", numKeys, insertSecs);
+    benchReport(padded ? "nTablePeek, padded keys" : "nTablePeekVar", numKeys, peekSecs);
+    printf("%-44.44s %12.1f bytes\n", "RSS per entry",
+           (rssAfter - rssBefore) * 1024.0 / nTableSize(&table));
+
+    nTableDestroy(&table);
+    free(lens);
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#include "nanodtypes.h"
+#include "nanodtypes_typed.h"
+#include "bench.h"
+
+/*
+ * Generic (runtime element size) nStack calls against the typed wrappers
+ * from nanodtypes_typed.h, for 4- and 8-byte elements
+ *
+ * Usage: typed_bench [numOps]
+ */
+
+ND_DEFINE_STACK(u32, uint32_t)
+ND_DEFINE_STACK(u64, uint64_t)
+
+#define STACK_DEPTH 1024
+
+static void
+stackBench(size_t numOps)
+{
+    struct nStack       s;
+    uint64_t            v64 = 0, sum = 0;
+    uint32_t            v32 = 0;
+    size_t              i, j;
+    double              start;
+
+    nStackInitM(&s, STACK_DEPTH, sizeof(v64));
+    start = benchNow();
+    for (i = 0; i < numOps; i += STACK_DEPTH) {
+        for (j = 0; j < STACK_DEPTH; j++, v64++)
+            nStackPush(&s, &v64);
+        for (j = 0; j < STACK_DEPTH; j++, sum += v64)
+            nStackPop(&s, &v64);
+    }
+    benchReport("nStack u64 generic push+pop", 2 * numOps, benchNow() - start);
+
+    start = benchNow();
+    for (i = 0; i < numOps; i += STACK_DEPTH) {
+        for (j = 0; j < STACK_DEPTH; j++, v64++)
+            nStackPush_u64(&s, v64);
+        for (j = 0; j < STACK_DEPTH; j++, sum += v64)
+            nStackPop_u64(&s, &v64);
+    }
+    benchReport("nStack u64 typed push+pop", 2 * numOps, benchNow() - start);
+    nStackDestroy(&s);
+
+    nStackInitM(&s, STACK_DEPTH, sizeof(v32));
+    start = benchNow();
+    for (i = 0; i < numOps; i += STACK_DEPTH) {
+        for (j = 0; j < STACK_DEPTH; j++, v32++)
+            nStackPush(&s, &v32);
+        for (j = 0; j < STACK_DEPTH; j++, sum += v32)
+            nStackPop(&s, &v32);
+    }
+    benchReport("nStack u32 generic push+pop", 2 * numOps, benchNow() - start);
+
+    start = benchNow();
+    for (i = 0; i < numOps; i += STACK_DEPTH) {
+        for (j = 0; j < STACK_DEPTH; j++, v32++)
+            nStackPush_u32(&s, v32);
+        for (j = 0; j < STACK_DEPTH; j++, sum += v32)
+            nStackPop_u32(&s, &v32);
+    }
+    benchReport("nStack u32 typed push+pop", 2 * numOps, benchNow() - start);
+    nStackDestroy(&s);
+    printf("  (checksum %llu)\n", (unsigned long long)sum);
+}
+
+int
+main(int argc, char *argv[])
+{
+    size_t              numOps;
+
+    numOps = benchArgSize(argc, argv, 1, 50000000);
+    stackBench(numOps);
+    return 0;
+}
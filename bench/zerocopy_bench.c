@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanodtypes.h"
+#include "bench.h"
+
+/*
+ * Read-modify-write of one counter inside large values, copying the value
+ * through a caller buffer against working on it in place. For nTable the
+ * copying path is nTablePeek then nTableInsert, the in-place path one
+ * nTableGetRef; for nStack it is nStackPop then nStackPush against
+ * nStackTop. Values are 256, 1024 and 4096 bytes.
+ *
+ * Usage: zerocopy_bench [numKeys] [numOps]
+ */
+
+#define POOL_SLAB 1024
+
+static const size_t             valueSizes[] = {256, 1024, 4096};
+
+static void
+runTable(size_t valueSize, size_t numKeys, size_t numOps, char *buf)
+{
+    unsigned long long  seed = 0x9E3779B97F4A7C15ULL, key, counter, sum = 0;
+    struct nTable       t;
+    size_t              i;
+    void               *ref;
+    double              start;
+    char                label[64];
+
+    nTableInitPool(&t, sizeof(key), valueSize, POOL_SLAB);
+    memset(buf, 0, valueSize);
+    for (key = 0; key < numKeys; key++)
+        if (nTableInsert(&t, &key, buf)) {
+            printf("nTable ran out of memory at %llu keys\n", key);
+            return;
+        }
+
+    start = benchNow();
+    for (i = 0; i < numOps; i++) {
+        key = benchRand(&seed) % numKeys;
+        nTablePeek(&t, &key, buf);
+        memcpy(&counter, buf, sizeof(counter));
+        counter++;
+        memcpy(buf, &counter, sizeof(counter));
+        nTableInsert(&t, &key, buf);
+    }
+    sprintf(label, "nTable %4zu B peek + insert", valueSize);
+    benchReport(label, numOps, benchNow() - start);
+
+    start = benchNow();
+    for (i = 0; i < numOps; i++) {
+        key = benchRand(&seed) % numKeys;
+        nTableGetRef(&t, &key, &ref);
+        memcpy(&counter, ref, sizeof(counter));
+        counter++;
+        memcpy(ref, &counter, sizeof(counter));
+    }
+    sprintf(label, "nTable %4zu B getref", valueSize);
+    benchReport(label, numOps, benchNow() - start);
+
+    for (key = 0; key < numKeys; key++) {
+        nTableGetRef(&t, &key, &ref);
+        memcpy(&counter, ref, sizeof(counter));
+        sum += counter;
+    }
+    if (sum != 2 * numOps)
+        printf("    counters add up to %llu, expected %zu\n", sum, 2 * numOps);
+    nTableDestroy(&t);
+}
+
+static void
+runStack(size_t valueSize, size_t numOps, char *buf)
+{
+    unsigned long long  counter = 0;
+    struct nStack       s;
+    size_t              i;
+    void               *ref;
+    double              start;
+    char                label[64];
+
+    nStackInitG(&s, 16, 0, valueSize);
+    memset(buf, 0, valueSize);
+    nStackPush(&s, buf);
+
+    start = benchNow();
+    for (i = 0; i < numOps; i++) {
+        nStackPop(&s, buf);
+        memcpy(&counter, buf, sizeof(counter));
+        counter++;
+        memcpy(buf, &counter, sizeof(counter));
+        nStackPush(&s, buf);
+    }
+    sprintf(label, "nStack %4zu B pop + push", valueSize);
+    benchReport(label, numOps, benchNow() - start);
+
+    start = benchNow();
+    for (i = 0; i < numOps; i++) {
+        nStackTop(&s, &ref);
+        memcpy(&counter, ref, sizeof(counter));
+        counter++;
+        memcpy(ref, &counter, sizeof(counter));
+    }
+    sprintf(label, "nStack %4zu B top", valueSize);
+    benchReport(label, numOps, benchNow() - start);
+    if (counter != 2 * numOps)
+        printf("    counter reads %llu, expected %zu\n", counter, 2 * numOps);
+    nStackDestroy(&s);
+}
+
+int
+main(int argc, char *argv[])
+{
+    size_t              numKeys, numOps, i;
+    char               *buf;
+
+    numKeys = benchArgSize(argc, argv, 1, 100000);
+    numOps = benchArgSize(argc, argv, 2, 2000000);
+    if (!(buf = malloc(valueSizes[sizeof(valueSizes) / sizeof(valueSizes[0]) - 1])))
+        return 1;
+
+    for (i = 0; i < sizeof(valueSizes) / sizeof(valueSizes[0]); i++)
+        runTable(valueSizes[i], numKeys, numOps, buf);
+    for (i = 0; i < sizeof(valueSizes) / sizeof(valueSizes[0]); i++)
+        runStack(valueSizes[i], numOps * 10, buf);
+    free(buf);
+    return 0;
+}
@@ -18,6 +18,17 @@ enum nBool {
     nTrue = 1
 };
 
+/*** nanoPool types ***/
+
+struct nPool {
+    void *slabs;
+    void *freeList;
+    char *bump;
+    char *bumpEnd;
+    size_t nodeSize;
+    size_t nodesPerSlab;
+};
+
 /*** nanoStack types ***/
 
 struct nStack {
@@ -26,20 +37,72 @@ struct nStack {
 	short managed;
 	size_t elemSize;
 	size_t maxElem;
+	size_t minElem;
+	size_t limitElem;
+	void *block;        /* top block of a segmented stack */
+	void *spareBlock;   /* emptied block kept for the next push */
 };
 
 /*** nanoStack functions ***/
 
 enum nErrorType nStackInitM(struct nStack *s, size_t maxElem, size_t elemSize);
 enum nErrorType nStackInit(struct nStack *s, void *stackData, size_t maxElem, size_t elemSize);
+enum nErrorType nStackInitG(struct nStack *s, size_t initElem, size_t limitElem, size_t elemSize);
+enum nErrorType nStackInitS(struct nStack *s, size_t blockElem, size_t limitElem, size_t elemSize);
+enum nErrorType nStackReserve(struct nStack *s, size_t numElem);
 void nStackDestroy(struct nStack *s);
 enum nErrorType nStackPush(struct nStack *s, void *dataIn);
 enum nErrorType nStackPop(struct nStack *s, void *dataOut);
+enum nErrorType nStackPushN(struct nStack *s, void *dataIn, size_t numElem);
+enum nErrorType nStackPopN(struct nStack *s, void *dataOut, size_t numElem);
 enum nErrorType nStackPeek(struct nStack *s, void *dataOut);
+enum nErrorType nStackTop(struct nStack *s, void **dataOut);
+enum nErrorType nStackPushSlot(struct nStack *s, void **slotOut);
 enum nBool nStackEmpty(struct nStack *s);
 enum nBool nStackFull(struct nStack *s);
 size_t nStackSize(struct nStack *s);
 
+/*** nanoCStack types ***/
+
+/*
+ * Stack shared between threads over a fixed array of maxElem nodes. The
+ * list of nodes holding elements and the list of free nodes each have a
+ * head on its own cache line.
+ */
+struct nCStack {
+    char *nodes;
+    size_t nodeSize;
+    size_t elemSize;
+    size_t maxElem;
+    char padTop[64];
+    unsigned long long top;
+    char padFree[64];
+    unsigned long long freeNodes;
+    char padEnd[64];
+};
+
+/* Elements one thread holds back from a shared nCStack */
+struct nCStackCache {
+    struct nCStack *s;
+    char *elems;
+    size_t numElems;
+    size_t maxElem;
+};
+
+/*** nanoCStack functions ***/
+
+enum nErrorType nCStackInit(struct nCStack *s, size_t maxElem, size_t elemSize);
+void nCStackDestroy(struct nCStack *s);
+enum nErrorType nCStackPush(struct nCStack *s, const void *dataIn);
+enum nErrorType nCStackPop(struct nCStack *s, void *dataOut);
+enum nErrorType nCStackPushN(struct nCStack *s, const void *dataIn, size_t numElem);
+enum nErrorType nCStackPopN(struct nCStack *s, void *dataOut, size_t numElem);
+enum nBool nCStackEmpty(struct nCStack *s);
+enum nErrorType nCStackCacheInit(struct nCStackCache *c, struct nCStack *s, size_t maxElem);
+void nCStackCacheDestroy(struct nCStackCache *c);
+enum nErrorType nCStackCachePush(struct nCStackCache *c, const void *dataIn);
+enum nErrorType nCStackCachePop(struct nCStackCache *c, void *dataOut);
+enum nErrorType nCStackCacheFlush(struct nCStackCache *c);
 
 /*** nanoList types ***/
 
@@ -49,22 +112,112 @@ struct nList {
     struct nListNode *head;
     unsigned int numElems;
 	size_t elemSize;
+    struct nPool pool;
 };
 
 typedef enum nBool (*nListIterFunc) (void *);
 
+/*
+ * Links the caller embeds in its own struct to put it on an nIList, an
+ * intrusive list that neither allocates nor copies. A struct can sit on
+ * as many lists at once as it has links.
+ */
+struct nListLink {
+    struct nListLink *next, *prev;
+};
+
+struct nIList {
+    struct nListLink *head;
+    size_t numElems;
+};
+
+typedef enum nBool (*nIListIterFunc) (struct nListLink *);
+
+/* The struct of the given type whose member is the link at ptr */
+#define nListEntry(ptr, type, member) \
+    ((type *)((char *)(ptr) - offsetof(type, member)))
+
 /*** nanoList functions ***/
 
 void nListInit(struct nList *l, size_t elemSize);
+void nListInitPool(struct nList *l, size_t elemSize, size_t nodesPerSlab);
 void nListDestroy(struct nList *l);
 enum nErrorType nListInsertHead(struct nList *l, void *dataIn);
 enum nErrorType nListInsertTail(struct nList *l, void *dataIn);
 enum nErrorType nListRemoveHead(struct nList *l, void *dataOut);
 enum nErrorType nListRemoveTail(struct nList *l, void *dataOut);
+enum nErrorType nListInsertTailN(struct nList *l, void *dataIn, size_t numElem);
+enum nErrorType nListRemoveHeadN(struct nList *l, void *dataOut, size_t numElem);
 void nListForEach(struct nList *l, nListIterFunc func);
 enum nBool nListEmpty(struct nList *l);
 size_t nListSize(struct nList *l);
 
+void nIListInit(struct nIList *l);
+void nIListInsertHead(struct nIList *l, struct nListLink *link);
+void nIListInsertTail(struct nIList *l, struct nListLink *link);
+enum nErrorType nIListRemoveHead(struct nIList *l, struct nListLink **linkOut);
+enum nErrorType nIListRemoveTail(struct nIList *l, struct nListLink **linkOut);
+void nIListRemove(struct nIList *l, struct nListLink *link);
+struct nListLink *nIListFirst(const struct nIList *l);
+struct nListLink *nIListNext(const struct nIList *l, const struct nListLink *link);
+void nIListForEach(struct nIList *l, nIListIterFunc func);
+enum nBool nIListEmpty(const struct nIList *l);
+size_t nIListSize(const struct nIList *l);
+
+/*** nanoDeque types ***/
+
+struct nDeque {
+    char *data;
+    size_t head;
+    size_t numElems;
+    size_t capacity;
+    size_t elemSize;
+};
+
+typedef enum nBool (*nDequeIterFunc) (void *);
+
+/*** nanoDeque functions ***/
+
+void nDequeInit(struct nDeque *d, size_t elemSize);
+void nDequeDestroy(struct nDeque *d);
+enum nErrorType nDequeInsertHead(struct nDeque *d, void *dataIn);
+enum nErrorType nDequeInsertTail(struct nDeque *d, void *dataIn);
+enum nErrorType nDequeRemoveHead(struct nDeque *d, void *dataOut);
+enum nErrorType nDequeRemoveTail(struct nDeque *d, void *dataOut);
+void nDequeForEach(struct nDeque *d, nDequeIterFunc func);
+enum nBool nDequeEmpty(struct nDeque *d);
+size_t nDequeSize(struct nDeque *d);
+
+/*** nanoQueue types ***/
+
+/*
+ * Bounded FIFO shared between threads. The enqueue and dequeue counters
+ * sit on cache lines of their own so producers and consumers do not
+ * contend for one line.
+ */
+struct nQueue {
+    char *slots;
+    size_t mask;
+    size_t elemSize;
+    size_t slotSize;
+    short mode;
+    char padTail[64];
+    size_t tail;
+    char padHead[64];
+    size_t head;
+    char padEnd[64];
+};
+
+/*** nanoQueue functions ***/
+
+enum nErrorType nQueueInit(struct nQueue *q, size_t capacity, size_t elemSize);
+enum nErrorType nQueueInitSPSC(struct nQueue *q, size_t capacity, size_t elemSize);
+void nQueueDestroy(struct nQueue *q);
+enum nErrorType nQueueInsertTail(struct nQueue *q, const void *dataIn);
+enum nErrorType nQueueRemoveHead(struct nQueue *q, void *dataOut);
+enum nBool nQueueEmpty(struct nQueue *q);
+size_t nQueueSize(struct nQueue *q);
+
 /*** nanoTable types ***/
 
 struct nTableNode;
@@ -72,22 +225,159 @@ struct nTableNode;
 struct nTable {
     struct nTableNode *head;
     size_t numElems;
-    size_t keySize;
+    size_t keySize;     /* longest key so far for variable-length keys */
     size_t valueSize;
-    char *nullKey;
+    char *nullKey;      /* value of the zero-length key, if present */
+    short keyMode;
+    struct nPool pool;
+    void *mapping;      /* snapshot file of a table from nTableMapReadOnly */
+    size_t mappingSize;
 };
 
 typedef enum nBool (*nTableIterFunc) (void *, void *);
+typedef enum nBool (*nTableVarIterFunc) (void *, size_t, void *);
+typedef void (*nTableValueFunc) (void *);
+
+struct nTableCursor {
+    struct nTable *t;
+    struct nStack path;
+    enum nBool atNullKey;
+    void *key;
+    size_t keyLen;
+    void *value;
+};
 
 /*** nanoTable functions ***/
 
-void nTableInit(struct nTable *t, size_t keySize, size_t valueSize);
+enum nErrorType nTableInit(struct nTable *t, size_t keySize, size_t valueSize);
+enum nErrorType nTableInitPool(struct nTable *t, size_t keySize, size_t valueSize,
+                               size_t nodesPerSlab);
+enum nErrorType nTableInitVar(struct nTable *t, size_t valueSize, size_t nodesPerSlab);
+enum nErrorType nTableInitPrefix(struct nTable *t, size_t keySize, size_t valueSize,
+                                 size_t nodesPerSlab);
 void nTableDestroy(struct nTable *t);
 enum nErrorType nTableInsert(struct nTable *t, const void *key, const void *dataIn);
 enum nErrorType nTablePeek(struct nTable *t, const void *key, void *dataOut);
+enum nErrorType nTableGetRef(struct nTable *t, const void *key, void **valueOut);
+enum nErrorType nTableUpsertSlot(struct nTable *t, const void *key, void **valueOut);
+enum nErrorType nTableUpsert(struct nTable *t, const void *key, nTableValueFunc initFunc,
+                             nTableValueFunc updateFunc);
+enum nErrorType nTableBuildSorted(struct nTable *t, const void *keys, const void *values,
+                                  size_t numElems);
+enum nErrorType nTableSave(struct nTable *t, int fd);
+enum nErrorType nTableMapReadOnly(struct nTable *t, const char *path);
+size_t nTablePeekBatch(struct nTable *t, const void *keys, size_t numKeys, void *valuesOut,
+                       enum nErrorType *statusOut);
 enum nErrorType nTableRemove(struct nTable *t, const void *key);
-void nTableForEach(const struct nTable *t, nTableIterFunc func);
+void nTableForEach(struct nTable *t, nTableIterFunc func);
+enum nErrorType nTableInsertVar(struct nTable *t, const void *key, size_t keyLen, const void *dataIn);
+enum nErrorType nTableUpsertVar(struct nTable *t, const void *key, size_t keyLen,
+                                nTableValueFunc initFunc, nTableValueFunc updateFunc);
+enum nErrorType nTablePeekVar(struct nTable *t, const void *key, size_t keyLen, void *dataOut);
+enum nErrorType nTableRemoveVar(struct nTable *t, const void *key, size_t keyLen);
+enum nErrorType nTableInsertPrefix(struct nTable *t, const void *key, size_t prefixBits,
+                                   const void *dataIn);
+enum nErrorType nTableRemovePrefix(struct nTable *t, const void *key, size_t prefixBits);
+enum nErrorType nTableLongestMatch(struct nTable *t, const void *key, void *dataOut,
+                                   size_t *matchedBitsOut);
+void nTableForEachVar(struct nTable *t, nTableVarIterFunc func);
+enum nErrorType nTableFirst(struct nTable *t, struct nTableCursor *c);
+enum nErrorType nTableSeek(struct nTable *t, struct nTableCursor *c, const void *key, size_t keyLen);
+enum nErrorType nTableNext(struct nTableCursor *c);
+void nTableCursorDestroy(struct nTableCursor *c);
+enum nErrorType nTableRange(struct nTable *t, const void *lo, const void *hi, nTableIterFunc func);
+enum nErrorType nTableRangeVar(struct nTable *t, const void *lo, size_t loLen, const void *hi,
+                               size_t hiLen, nTableVarIterFunc func);
+enum nErrorType nTablePrefix(struct nTable *t, const void *prefix, size_t prefixBits,
+                             nTableIterFunc func);
+enum nErrorType nTablePrefixVar(struct nTable *t, const void *prefix, size_t prefixBits,
+                                nTableVarIterFunc func);
 enum nBool nTableEmpty(const struct nTable *t);
 size_t nTableSize(const struct nTable *t);
 
+/*** nanoCTable types ***/
+
+struct nCTableReader;
+
+/* Fixed-size key table searched by many threads while one thread writes */
+struct nCTable {
+    struct nTable t;
+    struct nCTableReader *readers;  /* one epoch slot per reader number */
+    size_t maxReaders;
+    unsigned long epoch;
+    char writeLock;
+    struct nDeque retired;          /* unlinked nodes waiting out readers */
+};
+
+/*** nanoCTable functions ***/
+
+enum nErrorType nCTableInit(struct nCTable *ct, size_t keySize, size_t valueSize,
+                            size_t nodesPerSlab, size_t maxReaders);
+void nCTableDestroy(struct nCTable *ct);
+enum nErrorType nCTableInsert(struct nCTable *ct, const void *key, const void *dataIn);
+enum nErrorType nCTableRemove(struct nCTable *ct, const void *key);
+enum nErrorType nCTablePeek(struct nCTable *ct, size_t reader, const void *key, void *dataOut);
+size_t nCTableSize(struct nCTable *ct);
+
+/*** nanoITable types ***/
+
+/*
+ * Fixed-size key table whose nodes sit in one array and link to each
+ * other by 32-bit index, for tables of fewer than 4 billion entries
+ */
+struct nITable {
+    char *nodes;
+    size_t nodeSize;
+    size_t capacity;    /* nodes the array has room for */
+    size_t used;        /* nodes handed out so far, live or free */
+    unsigned int head;
+    unsigned int freeNodes;
+    size_t numElems;
+    size_t keySize;
+    size_t valueSize;
+};
+
+/*** nanoITable functions ***/
+
+enum nErrorType nITableInit(struct nITable *t, size_t keySize, size_t valueSize, size_t initElems);
+void nITableDestroy(struct nITable *t);
+enum nErrorType nITableInsert(struct nITable *t, const void *key, const void *dataIn);
+enum nErrorType nITablePeek(struct nITable *t, const void *key, void *dataOut);
+enum nErrorType nITableRemove(struct nITable *t, const void *key);
+void nITableForEach(struct nITable *t, nTableIterFunc func);
+enum nErrorType nITablePack(struct nITable *t);
+enum nBool nITableEmpty(const struct nITable *t);
+size_t nITableSize(const struct nITable *t);
+
+/*** nanoHash types ***/
+
+/*
+ * Fixed-size key table in an open-addressed array of slots, for point
+ * lookups with no ordering. While the array grows, entries move over from
+ * the old one a few slots per insert or remove.
+ */
+struct nHash {
+    char *slots;
+    size_t capacity;    /* slots, a power of two */
+    size_t slotSize;
+    size_t numElems;
+    size_t keySize;
+    size_t valueSize;
+    char *oldSlots;     /* array being emptied into slots, or NULL */
+    size_t oldCapacity;
+    size_t migrated;    /* old slots emptied so far */
+    char *scratch;      /* room for two entries being moved */
+};
+
+/*** nanoHash functions ***/
+
+enum nErrorType nHashInit(struct nHash *h, size_t keySize, size_t valueSize, size_t initElems);
+void nHashDestroy(struct nHash *h);
+enum nErrorType nHashInsert(struct nHash *h, const void *key, const void *dataIn);
+enum nErrorType nHashPeek(struct nHash *h, const void *key, void *dataOut);
+enum nErrorType nHashRemove(struct nHash *h, const void *key);
+void nHashForEach(struct nHash *h, nTableIterFunc func);
+enum nBool nHashEmpty(const struct nHash *h);
+size_t nHashSize(const struct nHash *h);
+
 #endif
@@ -0,0 +1,66 @@
+#ifndef NANODTYPES_TYPED_H
+#define NANODTYPES_TYPED_H
+
+#include <string.h>
+
+#include "nanodtypes.h"
+
+/*
+ * Typed wrappers around nStack. The macro defines static inline functions
+ * for one element type that work on the same struct as the generic API,
+ * so the two can be mixed freely. Element copies use sizeof(type),
+ * letting the compiler turn them into plain loads and stores. The stack
+ * must have been initialized with that element size.
+ *
+ *     ND_DEFINE_STACK(u64, uint64_t)
+ *
+ * defines nStackPush_u64(s, value), nStackPop_u64(s, &value) and
+ * nStackPeek_u64(s, &value). List and table nodes are private to the
+ * library, so their 4- and 8-byte copies and compares are specialized
+ * inside it (src/copy.h) rather than here.
+ */
+
+/*
+ * Stack pushes and pops that could reallocate (a full stack, or a growable
+ * stack that might shrink) fall back to the generic calls, as do pushes
+ * that reach the limit. A fixed stack has minElem == maxElem and never
+ * takes that path on pop. A segmented stack takes it whenever elements
+ * lie past its first block.
+ */
+#define ND_DEFINE_STACK(name, type)                                           \
+static inline enum nErrorType                                                 \
+nStackPush_##name(struct nStack *s, type value)                               \
+{                                                                             \
+    if (s->numElems >= s->maxElem                                             \
+        || (s->limitElem && s->numElems >= s->limitElem))                     \
+        return nStackPush(s, &value);                                         \
+    memcpy(s->stackData, &value, sizeof(type));                               \
+    s->numElems++;                                                            \
+    s->stackData += sizeof(type);                                             \
+    return nCodeSuccess;                                                      \
+}                                                                             \
+                                                                              \
+static inline enum nErrorType                                                 \
+nStackPop_##name(struct nStack *s, type *dataOut)                             \
+{                                                                             \
+    if (!s->numElems)                                                         \
+        return nCodeEmpty;                                                    \
+    if (s->numElems > s->maxElem                                              \
+        || (s->numElems <= s->maxElem / 4 && s->maxElem > s->minElem))        \
+        return nStackPop(s, dataOut);                                         \
+    s->stackData -= sizeof(type);                                             \
+    memcpy(dataOut, s->stackData, sizeof(type));                              \
+    s->numElems--;                                                            \
+    return nCodeSuccess;                                                      \
+}                                                                             \
+                                                                              \
+static inline enum nErrorType                                                 \
+nStackPeek_##name(struct nStack *s, type *dataOut)                            \
+{                                                                             \
+    if (!s->numElems)                                                         \
+        return nCodeEmpty;                                                    \
+    memcpy(dataOut, s->stackData - sizeof(type), sizeof(type));               \
+    return nCodeSuccess;                                                      \
+}
+
+#endif
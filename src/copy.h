@@ -0,0 +1,43 @@
+#ifndef COPY_H
+#define COPY_H
+
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * Element copy and compare for the container internals. The common 4- and
+ * 8-byte sizes get their own constant-size calls, which the compiler turns
+ * into single loads and stores instead of a library call.
+ */
+
+static inline void
+elemCopy(void *dst, const void *src, size_t size)
+{
+    switch (size) {
+    case 4:
+        memcpy(dst, src, 4);
+        break;
+    case 8:
+        memcpy(dst, src, 8);
+        break;
+    default:
+        memcpy(dst, src, size);
+        break;
+    }
+}
+
+/* Returns 0 when equal, like memcmp, but without an ordering */
+static inline int
+elemDiffer(const void *a, const void *b, size_t size)
+{
+    switch (size) {
+    case 4:
+        return memcmp(a, b, 4) != 0;
+    case 8:
+        return memcmp(a, b, 8) != 0;
+    default:
+        return memcmp(a, b, size) != 0;
+    }
+}
+
+#endif
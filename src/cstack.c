@@ -0,0 +1,290 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanodtypes.h"
+#include "cstack.h"
+#include "copy.h"
+
+#if !defined(__GNUC__)
+#error "nCStack needs the GCC __atomic builtins"
+#endif
+
+/*
+ * Lock-free stack over a preallocated node array. Nodes move between two
+ * singly linked lists, elements and free nodes, linked by array index, so
+ * a node a thread has stopped looking at is never released to the system.
+ *
+ * Each list head carries a count of the changes made to it. A pop that
+ * read the head, and the index of the node below it, commits only if the
+ * head is unchanged since: a node popped and pushed back in the meantime
+ * (the ABA problem) has bumped the count, so the stale index is never
+ * installed. The count is 32 bits wide, so a thread would have to stall
+ * across four billion changes to one list for that to go wrong.
+ *
+ * A chain of nodes moves with a single compare-and-swap, which is what
+ * the bulk calls and the per-thread cache build on.
+ */
+
+/* Helper functions */
+
+static char                    *
+nodeAt(struct nCStack *s, uint32_t index)
+{
+    return s->nodes + (size_t)index * s->nodeSize;
+}
+
+static uint32_t                *
+nodeNext(struct nCStack *s, uint32_t index)
+{
+    return (uint32_t *)nodeAt(s, index);
+}
+
+static char                    *
+nodeData(struct nCStack *s, uint32_t index)
+{
+    return nodeAt(s, index) + CSTACK_DATA_OFFSET;
+}
+
+static uint32_t
+loadNext(struct nCStack *s, uint32_t index)
+{
+    return __atomic_load_n(nodeNext(s, index), __ATOMIC_RELAXED);
+}
+
+/*
+ * Take up to maxCount nodes off the top of a list, or none at all when
+ * fewer than minCount are there. Returns the index of the first node
+ * taken, with the rest following through their next indexes, and their
+ * number through countOut.
+ */
+static uint32_t
+popChain(struct nCStack *s, unsigned long long *head, size_t minCount, size_t maxCount,
+         size_t *countOut)
+{
+    unsigned long long  oldHead = __atomic_load_n(head, __ATOMIC_ACQUIRE), newHead;
+    uint32_t            first, last, next;
+    size_t              count;
+
+    do {
+        first = CSTACK_INDEX(oldHead);
+        count = 0;
+        if (first != CSTACK_END) {
+            last = first;
+            count = 1;
+            /* A stale walk may meet a cycle; the swap then fails anyway */
+            while (count < maxCount && count < s->maxElem
+                   && (next = loadNext(s, last)) != CSTACK_END) {
+                last = next;
+                count++;
+            }
+        }
+        if (!count || count < minCount) {
+            *countOut = 0;
+            return CSTACK_END;
+        }
+        newHead = CSTACK_HEAD((oldHead >> 32) + 1, loadNext(s, last));
+    } while (!__atomic_compare_exchange_n(head, &oldHead, newHead, 1, __ATOMIC_ACQUIRE,
+                                          __ATOMIC_ACQUIRE));
+    *countOut = count;
+    return first;
+}
+
+/* Put a chain of nodes, already linked from first to last, on top of a list */
+static void
+pushChain(struct nCStack *s, unsigned long long *head, uint32_t first, uint32_t last)
+{
+    unsigned long long  oldHead = __atomic_load_n(head, __ATOMIC_RELAXED), newHead;
+
+    do {
+        __atomic_store_n(nodeNext(s, last), CSTACK_INDEX(oldHead), __ATOMIC_RELAXED);
+        newHead = CSTACK_HEAD((oldHead >> 32) + 1, first);
+    } while (!__atomic_compare_exchange_n(head, &oldHead, newHead, 1, __ATOMIC_RELEASE,
+                                          __ATOMIC_RELAXED));
+}
+
+/*
+ * Push numElem elements from dataIn as one chain, the last one ending up
+ * on top, or none when fewer free nodes than that remain
+ */
+static enum nErrorType
+pushElems(struct nCStack *s, const char *dataIn, size_t numElem)
+{
+    uint32_t            first, last, index;
+    size_t              count, i;
+
+    first = popChain(s, &s->freeNodes, numElem, numElem, &count);
+    if (first == CSTACK_END)
+        return nCodeFull;
+    for (index = last = first, i = count; i-- > 0; index = loadNext(s, index)) {
+        elemCopy(nodeData(s, index), dataIn + i * s->elemSize, s->elemSize);
+        last = index;
+    }
+    pushChain(s, &s->top, first, last);
+    return nCodeSuccess;
+}
+
+/*
+ * Pop between minElem and maxElem elements as one chain into dataOut,
+ * bottom-most first; the number popped goes to countOut
+ */
+static enum nErrorType
+popElems(struct nCStack *s, char *dataOut, size_t minElem, size_t maxElem, size_t *countOut)
+{
+    uint32_t            first, last, index;
+    size_t              count, i;
+
+    first = popChain(s, &s->top, minElem, maxElem, &count);
+    if (first == CSTACK_END)
+        return nCodeEmpty;
+    for (index = last = first, i = count; i-- > 0; index = loadNext(s, index)) {
+        elemCopy(dataOut + i * s->elemSize, nodeData(s, index), s->elemSize);
+        last = index;
+    }
+    pushChain(s, &s->freeNodes, first, last);
+    *countOut = count;
+    return nCodeSuccess;
+}
+
+/* API functions */
+
+enum nErrorType
+nCStackInit(struct nCStack *s, size_t maxElem, size_t elemSize)
+{
+    uint32_t            index;
+
+    if (!maxElem || maxElem >= CSTACK_MAX_ELEMS)
+        return nCodeBadInput;
+
+    /* Keep the data of every node aligned like its next index */
+    s->nodeSize = CSTACK_DATA_OFFSET + (elemSize + CSTACK_DATA_OFFSET - 1)
+        / CSTACK_DATA_OFFSET * CSTACK_DATA_OFFSET;
+    if (!(s->nodes = malloc(maxElem * s->nodeSize)))
+        return nCodeNoSpace;
+    for (index = 0; index < maxElem; index++)
+        *nodeNext(s, index) = index + 1 < maxElem ? index + 1 : CSTACK_END;
+    s->elemSize = elemSize;
+    s->maxElem = maxElem;
+    s->top = CSTACK_HEAD(0, CSTACK_END);
+    s->freeNodes = CSTACK_HEAD(0, 0);
+    return nCodeSuccess;
+}
+
+/* No thread may be using the stack any more */
+void
+nCStackDestroy(struct nCStack *s)
+{
+    free(s->nodes);
+    s->nodes = NULL;
+    s->maxElem = 0;
+    s->top = CSTACK_HEAD(0, CSTACK_END);
+    s->freeNodes = CSTACK_HEAD(0, CSTACK_END);
+}
+
+enum nErrorType
+nCStackPush(struct nCStack *s, const void *dataIn)
+{
+    return pushElems(s, dataIn, 1);
+}
+
+enum nErrorType
+nCStackPop(struct nCStack *s, void *dataOut)
+{
+    size_t              count;
+
+    return popElems(s, dataOut, 1, 1, &count);
+}
+
+/* Push numElem elements stored contiguously at dataIn; all or nothing */
+enum nErrorType
+nCStackPushN(struct nCStack *s, const void *dataIn, size_t numElem)
+{
+    if (!numElem)
+        return nCodeSuccess;
+    return pushElems(s, dataIn, numElem);
+}
+
+/*
+ * Pop the top numElem elements into dataOut, bottom-most first, as
+ * nStackPopN does; all or nothing
+ */
+enum nErrorType
+nCStackPopN(struct nCStack *s, void *dataOut, size_t numElem)
+{
+    size_t              count;
+
+    if (!numElem)
+        return nCodeSuccess;
+    return popElems(s, dataOut, numElem, numElem, &count);
+}
+
+/* A snapshot when other threads are using the stack */
+enum nBool
+nCStackEmpty(struct nCStack *s)
+{
+    return CSTACK_INDEX(__atomic_load_n(&s->top, __ATOMIC_RELAXED)) == CSTACK_END;
+}
+
+/*
+ * A cache for one thread holds up to maxElem elements of its own. When
+ * it fills, the older half goes back to the shared stack in one chain;
+ * when it runs dry, it takes up to half its size back the same way.
+ * Cached elements are out of reach of every other thread.
+ */
+enum nErrorType
+nCStackCacheInit(struct nCStackCache *c, struct nCStack *s, size_t maxElem)
+{
+    if (maxElem < 2)
+        return nCodeBadInput;
+    if (!(c->elems = malloc(maxElem * s->elemSize)))
+        return nCodeNoSpace;
+    c->s = s;
+    c->numElems = 0;
+    c->maxElem = maxElem;
+    return nCodeSuccess;
+}
+
+/* Returns whatever the cache holds to the shared stack */
+void
+nCStackCacheDestroy(struct nCStackCache *c)
+{
+    nCStackCacheFlush(c);
+    free(c->elems);
+    c->elems = NULL;
+    c->numElems = 0;
+}
+
+enum nErrorType
+nCStackCachePush(struct nCStackCache *c, const void *dataIn)
+{
+    size_t              elemSize = c->s->elemSize, half = c->maxElem / 2;
+
+    if (c->numElems == c->maxElem) {
+        if (pushElems(c->s, c->elems, half))
+            return nCodeFull;
+        c->numElems -= half;
+        memmove(c->elems, c->elems + half * elemSize, c->numElems * elemSize);
+    }
+    elemCopy(c->elems + c->numElems++ * elemSize, dataIn, elemSize);
+    return nCodeSuccess;
+}
+
+enum nErrorType
+nCStackCachePop(struct nCStackCache *c, void *dataOut)
+{
+    size_t              elemSize = c->s->elemSize;
+
+    if (!c->numElems && popElems(c->s, c->elems, 1, c->maxElem / 2, &c->numElems))
+        return nCodeEmpty;
+    elemCopy(dataOut, c->elems + --c->numElems * elemSize, elemSize);
+    return nCodeSuccess;
+}
+
+/* Return every cached element to the shared stack */
+enum nErrorType
+nCStackCacheFlush(struct nCStackCache *c)
+{
+    if (c->numElems && pushElems(c->s, c->elems, c->numElems))
+        return nCodeFull;
+    c->numElems = 0;
+    return nCodeSuccess;
+}
@@ -0,0 +1,18 @@
+#ifndef CSTACK_H
+#define CSTACK_H
+
+#include <stdint.h>
+
+/*
+ * A list head packs a change count into its upper half and the index of
+ * the first node into its lower half; CSTACK_END marks an empty list
+ */
+#define CSTACK_END 0xffffffffu
+#define CSTACK_INDEX(head) ((uint32_t)(head))
+#define CSTACK_HEAD(tag, index) ((uint64_t)(tag) << 32 | (index))
+#define CSTACK_MAX_ELEMS CSTACK_END
+
+/* Element data starts this far into a node, after the next index */
+#define CSTACK_DATA_OFFSET sizeof(uint64_t)
+
+#endif
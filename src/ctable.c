@@ -0,0 +1,406 @@
+#include <sched.h>              /* sched_yield */
+#include <stdlib.h>
+
+#include "nanodtypes.h"
+#include "table.h"
+#include "ctable.h"
+#include "pool.h"
+#include "copy.h"
+
+#if !defined(__GNUC__)
+#error "nCTable needs the GCC __atomic builtins"
+#endif
+
+/*
+ * A fixed-size key nTable that readers search without taking a lock.
+ *
+ * Writers never change a node a reader may be looking at: keys, values
+ * and bits are written before a node is published, and every change to
+ * the trie is a single release store of one link. An update or a removal
+ * that would rewrite an entry in place (linkSwap in table.c) builds a
+ * fresh copy of the node instead and swings the links to it one at a
+ * time, in an order where every intermediate trie still leads each
+ * search to a current entry for its key.
+ *
+ * Unlinked nodes are retired rather than freed. Each reader publishes the
+ * global epoch in its own slot while it searches, and the writer only
+ * advances the epoch once every active reader has seen the current one.
+ * A node retired in epoch e is unreachable to any search that starts
+ * after it was unlinked, so it is freed once the epoch reaches e + 2.
+ */
+
+/* Links around the end of a search, as the addresses of the link fields */
+struct ctablePath {
+    struct nTableNode             **link;       /* link that ended the search */
+    struct nTableNode              *owner;      /* node holding that link */
+    struct nTableNode             **ownerLink;  /* downward link to owner */
+    struct nTableNode             **targetLink; /* downward link to the target node */
+};
+
+/* Helper functions */
+
+static void
+publish(struct nTableNode **link, struct nTableNode *node)
+{
+    __atomic_store_n(link, node, __ATOMIC_RELEASE);
+}
+
+static void
+writeLock(struct nCTable *ct)
+{
+    while (__atomic_test_and_set(&ct->writeLock, __ATOMIC_ACQUIRE))
+        sched_yield();
+}
+
+static void
+writeUnlock(struct nCTable *ct)
+{
+    __atomic_clear(&ct->writeLock, __ATOMIC_RELEASE);
+}
+
+static void
+setSize(struct nCTable *ct, size_t numElems)
+{
+    __atomic_store_n(&ct->t.numElems, numElems, __ATOMIC_RELAXED);
+}
+
+static struct nTableNode       *
+allocNode(struct nCTable *ct, const void *key, const void *value, tableBit bit)
+{
+    struct nTableNode  *newNode;
+
+    if (!(newNode = nPoolAlloc(&ct->t.pool)))
+        return NULL;
+    elemCopy(newNode->data, key, ct->t.keySize);
+    elemCopy(tableNodeValue(&ct->t, newNode), value, ct->t.valueSize);
+    newNode->bit = bit;
+    return newNode;
+}
+
+/*
+ * Writer-side search for key. Fills in path and returns the node the
+ * search ends on: the target of its final link, or the owner when that
+ * link is empty. targetLink is set when the search passes target.
+ */
+static struct nTableNode       *
+findPath(struct nTable *t, const void *key, const struct nTableNode *target,
+         struct ctablePath *path)
+{
+    struct nTableNode **link = &t->head, *node;
+    tableBit            prevBit = -1;
+
+    path->owner = NULL;
+    path->ownerLink = NULL;
+    path->targetLink = NULL;
+    while ((node = *link) && tableLinkDown(prevBit, node->bit)) {
+        if (node == target)
+            path->targetLink = link;
+        path->ownerLink = link;
+        path->owner = node;
+        prevBit = node->bit;
+        link = tableBitSet(t->keySize, node->bit, key) ? &node->r : &node->l;
+    }
+    path->link = link;
+    return node ? node : path->owner;
+}
+
+/* Nonzero when every reader is outside a search or has seen the current epoch */
+static int
+readersCurrent(struct nCTable *ct)
+{
+    unsigned long       readerEpoch;
+    size_t              i;
+
+    for (i = 0; i < ct->maxReaders; i++) {
+        readerEpoch = __atomic_load_n(&ct->readers[i].epoch, __ATOMIC_SEQ_CST);
+        if (readerEpoch != CTABLE_QUIESCENT && readerEpoch != ct->epoch)
+            return 0;
+    }
+    return 1;
+}
+
+static void
+advanceEpoch(struct nCTable *ct)
+{
+    __atomic_store_n(&ct->epoch, ct->epoch + 1, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * Free a node no longer in the trie once readers are done with it. When
+ * the retired queue cannot grow, wait out two epochs and free it directly.
+ */
+static void
+retireNode(struct nCTable *ct, struct nTableNode *node)
+{
+    struct ctableRetired retired;
+
+    retired.node = node;
+    retired.epoch = ct->epoch;
+    if (!nDequeInsertTail(&ct->retired, &retired))
+        return;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    while (ct->epoch < retired.epoch + 2) {
+        while (!readersCurrent(ct))
+            sched_yield();
+        advanceEpoch(ct);
+    }
+    nPoolFree(&ct->t.pool, node);
+}
+
+/* Move the epoch on if readers allow it and free what that releases */
+static void
+reclaim(struct nCTable *ct)
+{
+    struct ctableRetired retired;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (readersCurrent(ct))
+        advanceEpoch(ct);
+
+    while (!nDequeRemoveHead(&ct->retired, &retired)) {
+        if (retired.epoch + 2 > ct->epoch) {
+            nDequeInsertHead(&ct->retired, &retired);
+            break;
+        }
+        nPoolFree(&ct->t.pool, retired.node);
+    }
+}
+
+/*
+ * Link a new node for newKey at the first link along its search path that
+ * crosses diffBit or points back up the trie, as insert_step in table.c
+ * does, publishing it only once its links are set
+ */
+static enum nErrorType
+insertStep(struct nCTable *ct, tableBit diffBit, const void *newKey, const void *newItem)
+{
+    struct nTable      *t = &ct->t;
+    struct nTableNode **link = &t->head, *node, *newLink;
+    tableBit            parentBit = -1;
+
+    for (;;) {
+        node = *link;
+        if (tableInsertHere(parentBit, node->bit, diffBit)) {
+            if (!(newLink = allocNode(ct, newKey, newItem, diffBit)))
+                return nCodeNoSpace;
+            TABLE_LINK_NEW(newLink, newLink, node, tableBitSet(t->keySize, diffBit, newKey));
+            publish(link, newLink);
+            return nCodeSuccess;
+        }
+        parentBit = node->bit;
+        if (tableBitSet(t->keySize, node->bit, newKey)) {
+            link = &node->r;
+        } else if (node->l) {
+            link = &node->l;
+        } else {
+            newLink = allocNode(ct, newKey, newItem, tableFindBitDiff(t->keySize, newKey, NULL));
+            if (!newLink)
+                return nCodeNoSpace;
+            newLink->r = newLink;
+            newLink->l = NULL;
+            publish(&node->l, newLink);
+            return nCodeSuccess;
+        }
+    }
+}
+
+/*
+ * Give node a new value by replacing it with a copy. The link that refers
+ * to its key moves first, so a search reaching the old node from above
+ * still finds the old value until the node itself is swapped out.
+ */
+static enum nErrorType
+replaceValue(struct nCTable *ct, struct nTableNode *node, const void *dataIn)
+{
+    struct ctablePath   path;
+    struct nTableNode  *copy;
+
+    findPath(&ct->t, node->data, node, &path);
+    if (!(copy = allocNode(ct, node->data, dataIn, node->bit)))
+        return nCodeNoSpace;
+    copy->l = node->l == node ? copy : node->l;
+    copy->r = node->r == node ? copy : node->r;
+
+    if (path.owner != node)
+        publish(path.link, copy);
+    publish(path.targetLink, copy);
+    retireNode(ct, node);
+    return nCodeSuccess;
+}
+
+/*
+ * Where removeKey in table.c moves the entry of the node whose link refers
+ * to the victim's key (the parent) into the victim, a copy of the victim
+ * carrying the parent's entry is built and linked in instead: first where
+ * the parent's key is referred to, then in place of the parent, then in
+ * place of the victim.
+ */
+static enum nErrorType
+removeNode(struct nCTable *ct, struct nTableNode *victim, const void *key)
+{
+    struct ctablePath   path, parentPath;
+    struct nTableNode  *parent, *other, *copy;
+
+    findPath(&ct->t, key, victim, &path);
+    parent = path.owner;
+    other = path.link == &parent->l ? parent->r : parent->l;
+
+    if (parent == victim) {
+        /* The node refers to its own key; its other link takes its place */
+        publish(path.targetLink, other);
+        retireNode(ct, victim);
+        return nCodeSuccess;
+    }
+
+    findPath(&ct->t, parent->data, parent, &parentPath);
+    if (!(copy = allocNode(ct, parent->data, tableNodeValue(&ct->t, parent), victim->bit)))
+        return nCodeNoSpace;
+    if (other == parent)
+        other = copy;
+    copy->l = path.ownerLink == &victim->l ? other : victim->l;
+    copy->r = path.ownerLink == &victim->r ? other : victim->r;
+
+    if (parentPath.owner != parent)
+        publish(parentPath.link, copy);
+    publish(path.ownerLink, other);
+    publish(path.targetLink, copy);
+    retireNode(ct, parent);
+    retireNode(ct, victim);
+    return nCodeSuccess;
+}
+
+/* API functions */
+
+/*
+ * Up to maxReaders threads may search at once, each passing its own
+ * reader number below maxReaders to nCTablePeek. Nodes are carved out of
+ * slabs of nodesPerSlab nodes each; 0 means plain malloc.
+ */
+enum nErrorType
+nCTableInit(struct nCTable *ct, size_t keySize, size_t valueSize, size_t nodesPerSlab,
+            size_t maxReaders)
+{
+    size_t              i;
+
+    if (!maxReaders)
+        return nCodeBadInput;
+    if (nTableInitPool(&ct->t, keySize, valueSize, nodesPerSlab))
+        return nCodeBadInput;
+    ct->readers = aligned_alloc(CTABLE_CACHE_LINE, maxReaders * sizeof(struct nCTableReader));
+    if (!ct->readers)
+        return nCodeNoSpace;
+    for (i = 0; i < maxReaders; i++)
+        ct->readers[i].epoch = CTABLE_QUIESCENT;
+    ct->maxReaders = maxReaders;
+    ct->epoch = CTABLE_QUIESCENT + 1;
+    ct->writeLock = 0;
+    nDequeInit(&ct->retired, sizeof(struct ctableRetired));
+    return nCodeSuccess;
+}
+
+/* No reader or writer may be using the table any more */
+void
+nCTableDestroy(struct nCTable *ct)
+{
+    struct ctableRetired retired;
+
+    while (!nDequeRemoveHead(&ct->retired, &retired))
+        nPoolFree(&ct->t.pool, retired.node);
+    nDequeDestroy(&ct->retired);
+    nTableDestroy(&ct->t);
+    free(ct->readers);
+    ct->readers = NULL;
+    ct->maxReaders = 0;
+}
+
+enum nErrorType
+nCTableInsert(struct nCTable *ct, const void *key, const void *dataIn)
+{
+    struct nTable      *t = &ct->t;
+    struct ctablePath   path;
+    struct nTableNode  *closest, *newNode;
+    enum nErrorType     ret = nCodeSuccess;
+
+    writeLock(ct);
+    closest = findPath(t, key, NULL, &path);
+    if (closest && !elemDiffer(closest->data, key, t->keySize)) {
+        ret = replaceValue(ct, closest, dataIn);
+    } else if (closest) {
+        ret = insertStep(ct, tableFindBitDiff(t->keySize, key, closest->data), key, dataIn);
+        if (!ret)
+            setSize(ct, t->numElems + 1);
+    } else if ((newNode = allocNode(ct, key, dataIn, tableFindBitDiff(t->keySize, key, NULL)))) {
+        newNode->r = newNode;
+        newNode->l = NULL;
+        publish(&t->head, newNode);
+        setSize(ct, 1);
+    } else {
+        ret = nCodeNoSpace;
+    }
+    reclaim(ct);
+    writeUnlock(ct);
+    return ret;
+}
+
+enum nErrorType
+nCTableRemove(struct nCTable *ct, const void *key)
+{
+    struct nTable      *t = &ct->t;
+    struct ctablePath   path;
+    struct nTableNode  *closest;
+    enum nErrorType     ret = nCodeNotFound;
+
+    writeLock(ct);
+    closest = findPath(t, key, NULL, &path);
+    if (closest && !elemDiffer(closest->data, key, t->keySize)) {
+        if (!(ret = removeNode(ct, closest, key)))
+            setSize(ct, t->numElems - 1);
+    }
+    reclaim(ct);
+    writeUnlock(ct);
+    return ret;
+}
+
+/* Safe to call from any number of threads alongside one another and writers */
+enum nErrorType
+nCTablePeek(struct nCTable *ct, size_t reader, const void *key, void *dataOut)
+{
+    struct nCTableReader *slot;
+    struct nTableNode  *node, *nextNode, *left, *right;
+    tableBit            prevBit = -1;
+    enum nErrorType     ret = nCodeNotFound;
+
+    if (reader >= ct->maxReaders)
+        return nCodeBadInput;
+    slot = &ct->readers[reader];
+    __atomic_store_n(&slot->epoch, __atomic_load_n(&ct->epoch, __ATOMIC_RELAXED),
+                     __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if ((node = __atomic_load_n(&ct->t.head, __ATOMIC_ACQUIRE))) {
+        while (tableLinkDown(prevBit, node->bit)) {
+            /* Loading both links lets the compiler pick one without a branch */
+            left = __atomic_load_n(&node->l, __ATOMIC_ACQUIRE);
+            right = __atomic_load_n(&node->r, __ATOMIC_ACQUIRE);
+            nextNode = tableBitSet(ct->t.keySize, node->bit, key) ? right : left;
+            if (!nextNode)
+                break;
+            prevBit = node->bit;
+            node = nextNode;
+        }
+        if (!elemDiffer(node->data, key, ct->t.keySize)) {
+            elemCopy(dataOut, tableNodeValue(&ct->t, node), ct->t.valueSize);
+            ret = nCodeSuccess;
+        }
+    }
+
+    __atomic_store_n(&slot->epoch, CTABLE_QUIESCENT, __ATOMIC_RELEASE);
+    return ret;
+}
+
+size_t
+nCTableSize(struct nCTable *ct)
+{
+    return __atomic_load_n(&ct->t.numElems, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,21 @@
+#ifndef CTABLE_H
+#define CTABLE_H
+
+/* Epoch slots are padded to a cache line so readers do not share lines */
+#define CTABLE_CACHE_LINE 64
+
+/* Epoch slot value of a reader that is not inside nCTablePeek */
+#define CTABLE_QUIESCENT 0
+
+struct nCTableReader {
+    unsigned long                   epoch;
+    char                            pad[CTABLE_CACHE_LINE - sizeof(unsigned long)];
+};
+
+/* A node unlinked by a writer, freed once no reader can still hold it */
+struct ctableRetired {
+    struct nTableNode              *node;
+    unsigned long                   epoch;
+};
+
+#endif
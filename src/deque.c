@@ -0,0 +1,129 @@
+#include <stdlib.h>             /* NULL */
+#include <string.h>             /* memcpy */
+
+#include "nanodtypes.h"
+
+#include "deque.h"
+#include "copy.h"
+
+/* Helper functions */
+
+/* Address of the element at a position counted from the head */
+static char                    *
+slotAt(struct nDeque *d, size_t pos)
+{
+    return d->data + ((d->head + pos) & (d->capacity - 1)) * d->elemSize;
+}
+
+/* Double the buffer, unwrapping elements that ran past the old end */
+static enum nErrorType
+grow(struct nDeque *d)
+{
+    size_t              newCapacity, wrapped;
+    char               *newData;
+
+    newCapacity = d->capacity ? d->capacity * 2 : DEQUE_MIN_CAPACITY;
+    if (!(newData = realloc(d->data, newCapacity * d->elemSize)))
+        return nCodeNoSpace;
+
+    if (d->head + d->numElems > d->capacity) {
+        wrapped = d->head + d->numElems - d->capacity;
+        memcpy(newData + d->capacity * d->elemSize, newData, wrapped * d->elemSize);
+    }
+    d->data = newData;
+    d->capacity = newCapacity;
+    return nCodeSuccess;
+}
+
+/* API functions */
+
+void
+nDequeInit(struct nDeque *d, size_t elemSize)
+{
+    d->data = NULL;
+    d->head = 0;
+    d->numElems = 0;
+    d->capacity = 0;
+    d->elemSize = elemSize;
+}
+
+void
+nDequeDestroy(struct nDeque *d)
+{
+    free(d->data);
+    nDequeInit(d, d->elemSize);
+}
+
+enum nErrorType
+nDequeInsertHead(struct nDeque *d, void *dataIn)
+{
+    if (d->numElems == d->capacity && grow(d))
+        return nCodeNoSpace;
+    d->head = (d->head - 1) & (d->capacity - 1);
+    elemCopy(slotAt(d, 0), dataIn, d->elemSize);
+    d->numElems++;
+    return nCodeSuccess;
+}
+
+enum nErrorType
+nDequeInsertTail(struct nDeque *d, void *dataIn)
+{
+    if (d->numElems == d->capacity && grow(d))
+        return nCodeNoSpace;
+    elemCopy(slotAt(d, d->numElems), dataIn, d->elemSize);
+    d->numElems++;
+    return nCodeSuccess;
+}
+
+enum nErrorType
+nDequeRemoveHead(struct nDeque *d, void *dataOut)
+{
+    if (nDequeEmpty(d))
+        return nCodeEmpty;
+    elemCopy(dataOut, slotAt(d, 0), d->elemSize);
+    d->head = (d->head + 1) & (d->capacity - 1);
+    d->numElems--;
+    return nCodeSuccess;
+}
+
+enum nErrorType
+nDequeRemoveTail(struct nDeque *d, void *dataOut)
+{
+    if (nDequeEmpty(d))
+        return nCodeEmpty;
+    d->numElems--;
+    elemCopy(dataOut, slotAt(d, d->numElems), d->elemSize);
+    return nCodeSuccess;
+}
+
+enum nBool
+nDequeEmpty(struct nDeque *d)
+{
+    if (nDequeSize(d) == 0)
+        return nTrue;
+    return nFalse;
+}
+
+size_t
+nDequeSize(struct nDeque *d)
+{
+    return d->numElems;
+}
+
+/* Elements the callback asks to remove are squeezed out in a single pass */
+void
+nDequeForEach(struct nDeque *d, nDequeIterFunc func)
+{
+    size_t              readPos, writePos = 0;
+    char               *curElem;
+
+    for (readPos = 0; readPos < d->numElems; readPos++) {
+        curElem = slotAt(d, readPos);
+        if (func(curElem))
+            continue;
+        if (writePos != readPos)
+            memcpy(slotAt(d, writePos), curElem, d->elemSize);
+        writePos++;
+    }
+    d->numElems = writePos;
+}
@@ -0,0 +1,7 @@
+#ifndef DEQUE_H
+#define DEQUE_H
+
+/* Capacity of the first buffer allocated; always a power of two */
+#define DEQUE_MIN_CAPACITY 8
+
+#endif
@@ -0,0 +1,370 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanodtypes.h"
+#include "hash.h"
+#include "copy.h"
+
+/*
+ * Open addressing with Robin Hood probing: an entry that has come further
+ * from its ideal slot takes the place of one that has come less far, so
+ * probe lengths stay short and even, and a search stops as soon as it
+ * meets an entry closer to home than the key would be. Removal shifts the
+ * following entries back a slot instead of leaving a marker.
+ *
+ * To grow, the table allocates an array twice the size and keeps the old
+ * one beside it. Each insert or remove then moves the entries of a few old
+ * slots across, and searches look in both arrays until the old one is
+ * empty. No single call pays for moving the whole table.
+ */
+
+/* Helper functions */
+
+static struct hashSlot         *
+slotAt(const struct nHash *h, char *slots, size_t index)
+{
+    return (struct hashSlot *)(slots + index * h->slotSize);
+}
+
+/* The scratch slot that is not slot */
+static struct hashSlot         *
+otherScratch(const struct nHash *h, const struct hashSlot *slot)
+{
+    return slotAt(h, h->scratch, slot == slotAt(h, h->scratch, 0));
+}
+
+/* Slots an entry sits past its ideal slot */
+static size_t
+probeDistance(uint32_t hash, size_t index, size_t mask)
+{
+    return (index - (hash & mask)) & mask;
+}
+
+/* A word at a time, then a splitmix64 finalizer to spread the bits */
+static uint32_t
+hashOf(const void *key, size_t keySize)
+{
+    const unsigned char *keyByte = key;
+    uint64_t            hash = keySize, word;
+    size_t              byteOffset = 0;
+
+    for (; byteOffset + sizeof(word) <= keySize; byteOffset += sizeof(word)) {
+        memcpy(&word, keyByte + byteOffset, sizeof(word));
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+        hash ^= hash >> 32;
+    }
+    for (word = 0; byteOffset < keySize; byteOffset++)
+        word = word << 8 | keyByte[byteOffset];
+    hash ^= word;
+
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+    return (uint32_t)hash != HASH_EMPTY ? (uint32_t)hash : 1;
+}
+
+/* Index of the slot holding key in slots, or capacity when absent */
+static size_t
+findSlot(const struct nHash *h, char *slots, size_t capacity, const void *key, uint32_t hash)
+{
+    struct hashSlot    *slot;
+    size_t              mask = capacity - 1, index = hash & mask, dist;
+
+    for (dist = 0;; dist++, index = (index + 1) & mask) {
+        slot = slotAt(h, slots, index);
+        if (slot->hash == HASH_EMPTY || probeDistance(slot->hash, index, mask) < dist)
+            return capacity;
+        if (slot->hash == hash && !elemDiffer(slot->data, key, h->keySize))
+            return index;
+    }
+}
+
+/*
+ * Place the entry in carry, starting at index dist slots from its ideal
+ * slot, moving richer entries along until one lands in an empty slot.
+ * carry is one of the two scratch slots and is overwritten.
+ */
+static void
+placeEntry(const struct nHash *h, char *slots, size_t capacity, size_t index, size_t dist,
+           struct hashSlot *carry)
+{
+    struct hashSlot    *slot, *spare = otherScratch(h, carry);
+    size_t              mask = capacity - 1, slotDist;
+
+    for (;; dist++, index = (index + 1) & mask) {
+        slot = slotAt(h, slots, index);
+        if (slot->hash == HASH_EMPTY) {
+            memcpy(slot, carry, h->slotSize);
+            return;
+        }
+        if ((slotDist = probeDistance(slot->hash, index, mask)) < dist) {
+            memcpy(spare, slot, h->slotSize);
+            memcpy(slot, carry, h->slotSize);
+            carry = spare;
+            spare = otherScratch(h, carry);
+            dist = slotDist;
+        }
+    }
+}
+
+/* Empty slot index and shift the entries after it back a slot */
+static void
+clearSlot(const struct nHash *h, char *slots, size_t capacity, size_t index)
+{
+    struct hashSlot    *next;
+    size_t              mask = capacity - 1, nextIndex;
+
+    for (;; index = nextIndex) {
+        nextIndex = (index + 1) & mask;
+        next = slotAt(h, slots, nextIndex);
+        if (next->hash == HASH_EMPTY || !probeDistance(next->hash, nextIndex, mask))
+            break;
+        memcpy(slotAt(h, slots, index), next, h->slotSize);
+    }
+    slotAt(h, slots, index)->hash = HASH_EMPTY;
+}
+
+/*
+ * Empty slots hash to zero, so a large array comes straight from the
+ * system's zeroed pages, which are touched only as entries arrive
+ */
+static char                    *
+allocSlots(const struct nHash *h, size_t capacity)
+{
+    return calloc(capacity, h->slotSize);
+}
+
+/*
+ * Move the entries of up to numSlots old slots into the new array. A
+ * removal from the old array can shift an entry back into the slot just
+ * emptied, so each slot is emptied before moving on.
+ */
+static void
+migrateSlots(struct nHash *h, size_t numSlots)
+{
+    struct hashSlot    *slot, *carry = slotAt(h, h->scratch, 0);
+
+    for (; numSlots && h->migrated < h->oldCapacity; numSlots--, h->migrated++) {
+        slot = slotAt(h, h->oldSlots, h->migrated);
+        while (slot->hash != HASH_EMPTY) {
+            memcpy(carry, slot, h->slotSize);
+            clearSlot(h, h->oldSlots, h->oldCapacity, h->migrated);
+            placeEntry(h, h->slots, h->capacity, carry->hash & (h->capacity - 1), 0, carry);
+        }
+    }
+    if (h->migrated == h->oldCapacity) {
+        free(h->oldSlots);
+        h->oldSlots = NULL;
+        h->oldCapacity = 0;
+    }
+}
+
+/* Start moving entries into an array twice the size, once the last move is done */
+static enum nErrorType
+growSlots(struct nHash *h)
+{
+    char               *newSlots;
+
+    if (h->capacity > UINT32_MAX / 2)
+        return nCodeFull;
+    if (h->oldSlots)
+        migrateSlots(h, h->oldCapacity);
+    if (!(newSlots = allocSlots(h, h->capacity * 2)))
+        return nCodeNoSpace;
+    h->oldSlots = h->slots;
+    h->oldCapacity = h->capacity;
+    h->migrated = 0;
+    h->slots = newSlots;
+    h->capacity *= 2;
+    return nCodeSuccess;
+}
+
+/* API functions */
+
+/*
+ * Keys of keySize bytes, compared byte for byte. The slot array starts
+ * with room for initElems entries and doubles when it is 7/8 full.
+ */
+enum nErrorType
+nHashInit(struct nHash *h, size_t keySize, size_t valueSize, size_t initElems)
+{
+    const size_t        align = sizeof(uint32_t);
+
+    if (!keySize || initElems > UINT32_MAX / HASH_LOAD_DEN * HASH_LOAD_NUM)
+        return nCodeBadInput;
+    h->slotSize = (offsetof(struct hashSlot, data) + keySize + valueSize + align - 1)
+        / align * align;
+    for (h->capacity = HASH_MIN_SLOTS;
+         h->capacity / HASH_LOAD_DEN * HASH_LOAD_NUM < initElems; h->capacity *= 2);
+    h->keySize = keySize;
+    h->valueSize = valueSize;
+    h->numElems = 0;
+    h->oldSlots = NULL;
+    h->oldCapacity = 0;
+    h->migrated = 0;
+    if (!(h->scratch = malloc(2 * h->slotSize)))
+        return nCodeNoSpace;
+    if (!(h->slots = allocSlots(h, h->capacity))) {
+        free(h->scratch);
+        return nCodeNoSpace;
+    }
+    return nCodeSuccess;
+}
+
+void
+nHashDestroy(struct nHash *h)
+{
+    free(h->slots);
+    free(h->oldSlots);
+    free(h->scratch);
+    h->slots = NULL;
+    h->oldSlots = NULL;
+    h->scratch = NULL;
+    h->capacity = 0;
+    h->oldCapacity = 0;
+    h->numElems = 0;
+}
+
+/*
+ * Replace the value of key if present, otherwise add the entry. The
+ * search for the key stops where the new entry belongs, and placement
+ * carries on from there.
+ */
+enum nErrorType
+nHashInsert(struct nHash *h, const void *key, const void *dataIn)
+{
+    struct hashSlot    *slot, *carry;
+    uint32_t            hash = hashOf(key, h->keySize);
+    size_t              mask, index, dist, found;
+    enum nErrorType     ret;
+
+    if (h->oldSlots) {
+        found = findSlot(h, h->oldSlots, h->oldCapacity, key, hash);
+        if (found != h->oldCapacity) {
+            elemCopy(slotAt(h, h->oldSlots, found)->data + h->keySize, dataIn, h->valueSize);
+            return nCodeSuccess;
+        }
+    }
+
+    mask = h->capacity - 1;
+    for (index = hash & mask, dist = 0;; dist++, index = (index + 1) & mask) {
+        slot = slotAt(h, h->slots, index);
+        if (slot->hash == HASH_EMPTY || probeDistance(slot->hash, index, mask) < dist)
+            break;
+        if (slot->hash == hash && !elemDiffer(slot->data, key, h->keySize)) {
+            elemCopy(slot->data + h->keySize, dataIn, h->valueSize);
+            return nCodeSuccess;
+        }
+    }
+
+    /* Growing moves entries, so the search starts over in the new array */
+    if ((h->numElems + 1) * HASH_LOAD_DEN > h->capacity * HASH_LOAD_NUM) {
+        if ((ret = growSlots(h)))
+            return ret;
+        mask = h->capacity - 1;
+        index = hash & mask;
+        dist = 0;
+    }
+
+    carry = slotAt(h, h->scratch, 0);
+    carry->hash = hash;
+    elemCopy(carry->data, key, h->keySize);
+    elemCopy(carry->data + h->keySize, dataIn, h->valueSize);
+    placeEntry(h, h->slots, h->capacity, index, dist, carry);
+    h->numElems++;
+
+    if (h->oldSlots)
+        migrateSlots(h, HASH_MIGRATE_SLOTS);
+    return nCodeSuccess;
+}
+
+enum nErrorType
+nHashPeek(struct nHash *h, const void *key, void *dataOut)
+{
+    uint32_t            hash = hashOf(key, h->keySize);
+    size_t              found;
+
+    found = findSlot(h, h->slots, h->capacity, key, hash);
+    if (found != h->capacity) {
+        elemCopy(dataOut, slotAt(h, h->slots, found)->data + h->keySize, h->valueSize);
+        return nCodeSuccess;
+    }
+    if (h->oldSlots) {
+        found = findSlot(h, h->oldSlots, h->oldCapacity, key, hash);
+        if (found != h->oldCapacity) {
+            elemCopy(dataOut, slotAt(h, h->oldSlots, found)->data + h->keySize, h->valueSize);
+            return nCodeSuccess;
+        }
+    }
+    return nCodeNotFound;
+}
+
+enum nErrorType
+nHashRemove(struct nHash *h, const void *key)
+{
+    uint32_t            hash = hashOf(key, h->keySize);
+    size_t              found;
+
+    found = findSlot(h, h->slots, h->capacity, key, hash);
+    if (found != h->capacity) {
+        clearSlot(h, h->slots, h->capacity, found);
+    } else {
+        if (!h->oldSlots)
+            return nCodeNotFound;
+        found = findSlot(h, h->oldSlots, h->oldCapacity, key, hash);
+        if (found == h->oldCapacity)
+            return nCodeNotFound;
+        clearSlot(h, h->oldSlots, h->oldCapacity, found);
+    }
+    h->numElems--;
+
+    if (h->oldSlots)
+        migrateSlots(h, HASH_MIGRATE_SLOTS);
+    return nCodeSuccess;
+}
+
+/*
+ * Call func on every entry, in no particular order. Entries func asks to
+ * remove are removed once the walk is complete, as nTableForEach does.
+ */
+void
+nHashForEach(struct nHash *h, nTableIterFunc func)
+{
+    struct nDeque       victims;
+    struct hashSlot    *slot;
+    char               *slots, *victimKey;
+    size_t              capacity, index;
+    int                 array;
+
+    nDequeInit(&victims, h->keySize);
+    for (array = 0; array < 2; array++) {
+        slots = array ? h->oldSlots : h->slots;
+        capacity = array ? h->oldCapacity : h->capacity;
+        for (index = 0; slots && index < capacity; index++) {
+            slot = slotAt(h, slots, index);
+            if (slot->hash != HASH_EMPTY && func(slot->data, slot->data + h->keySize))
+                nDequeInsertTail(&victims, slot->data);
+        }
+    }
+
+    if (!nDequeEmpty(&victims) && (victimKey = malloc(h->keySize))) {
+        while (!nDequeRemoveHead(&victims, victimKey))
+            nHashRemove(h, victimKey);
+        free(victimKey);
+    }
+    nDequeDestroy(&victims);
+}
+
+enum nBool
+nHashEmpty(const struct nHash *h)
+{
+    return nHashSize(h) == 0 ? nTrue : nFalse;
+}
+
+size_t
+nHashSize(const struct nHash *h)
+{
+    return h->numElems;
+}
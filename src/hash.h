@@ -0,0 +1,32 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+
+/* Room for this many slots at least; slot counts are powers of two */
+#define HASH_MIN_SLOTS 16
+
+/* The slot array grows once more than 7/8 of it would be taken */
+#define HASH_LOAD_NUM 7
+#define HASH_LOAD_DEN 8
+
+/*
+ * Old slots emptied by each insert or remove while the array grows. The
+ * new array fills to its own limit only after 7/8 of the old slot count
+ * further inserts, so moving 2 per insert would already be enough.
+ */
+#define HASH_MIGRATE_SLOTS 8
+
+/* Hash of an empty slot, all zero bytes; hashOf never returns it */
+#define HASH_EMPTY 0
+
+/*
+ * Key bytes followed by value bytes are stored inline after the hash of
+ * the key, whose low bits give the slot the entry would like to sit in
+ */
+struct hashSlot {
+    uint32_t                        hash;
+    char                            data[];
+};
+
+#endif
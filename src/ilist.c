@@ -0,0 +1,137 @@
+#include <stdlib.h>             /* NULL */
+
+#include "nanodtypes.h"
+
+/*
+ * The circular, doubly-linked list of nList, built from links the caller
+ * embeds in its own structs. Nothing is allocated or copied: inserting
+ * links the caller's struct in place, and removing unlinks it and leaves
+ * it to the caller. A link must be on at most one list at a time, and
+ * only a link on this list may be passed to nIListRemove.
+ */
+
+/* Helper functions */
+
+static void
+insertLink(struct nIList *l, enum nBool atHead, struct nListLink *link)
+{
+    if (l->head) {
+        l->head->prev->next = link;
+        link->prev = l->head->prev;
+        l->head->prev = link;
+        link->next = l->head;
+        if (atHead)
+            l->head = link;
+    } else {
+        link->next = link;
+        link->prev = link;
+        l->head = link;
+    }
+    l->numElems++;
+}
+
+/* API functions */
+
+void
+nIListInit(struct nIList *l)
+{
+    l->head = NULL;
+    l->numElems = 0;
+}
+
+void
+nIListInsertHead(struct nIList *l, struct nListLink *link)
+{
+    insertLink(l, nTrue, link);
+}
+
+void
+nIListInsertTail(struct nIList *l, struct nListLink *link)
+{
+    insertLink(l, nFalse, link);
+}
+
+enum nErrorType
+nIListRemoveHead(struct nIList *l, struct nListLink **linkOut)
+{
+    if (nIListEmpty(l))
+        return nCodeEmpty;
+    *linkOut = l->head;
+    nIListRemove(l, l->head);
+    return nCodeSuccess;
+}
+
+enum nErrorType
+nIListRemoveTail(struct nIList *l, struct nListLink **linkOut)
+{
+    if (nIListEmpty(l))
+        return nCodeEmpty;
+    *linkOut = l->head->prev;
+    nIListRemove(l, l->head->prev);
+    return nCodeSuccess;
+}
+
+/*
+ * Unlink any element of the list in constant time. Its links are cleared,
+ * so a removed element can be told from a linked one by a NULL next.
+ */
+void
+nIListRemove(struct nIList *l, struct nListLink *link)
+{
+    if (l->numElems == 1)
+        l->head = NULL;
+    else if (l->head == link)
+        l->head = link->next;
+    link->next->prev = link->prev;
+    link->prev->next = link->next;
+    link->next = link->prev = NULL;
+    l->numElems--;
+}
+
+/* Walk the list from the head; both return NULL once there is no element */
+struct nListLink               *
+nIListFirst(const struct nIList *l)
+{
+    return l->head;
+}
+
+struct nListLink               *
+nIListNext(const struct nIList *l, const struct nListLink *link)
+{
+    if (link->next == l->head)
+        return NULL;
+    return link->next;
+}
+
+/*
+ * Call func on every element from the head; an element for which it
+ * returns nTrue is unlinked after the call, and may be freed only then
+ */
+void
+nIListForEach(struct nIList *l, nIListIterFunc func)
+{
+    struct nListLink   *curIter, *nextIter = l->head, *final;
+
+    if (nIListEmpty(l))
+        return;
+
+    final = l->head->prev;
+    do {
+        curIter = nextIter;
+        nextIter = nextIter->next;
+        if (func(curIter))
+            nIListRemove(l, curIter);
+    } while (curIter != final);
+}
+
+enum nBool
+nIListEmpty(const struct nIList *l)
+{
+    return l->numElems == 0;
+}
+
+size_t
+nIListSize(const struct nIList *l)
+{
+    return l->numElems;
+}
@@ -0,0 +1,429 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "nanodtypes.h"
+#include "table.h"
+#include "itable.h"
+#include "copy.h"
+
+/*
+ * The Patricia trie of nTable with fixed-size keys, its nodes stored in
+ * one growable array and linked by index. A node takes 10 bytes plus its
+ * key and value, rounded up to a multiple of 4, with no allocator header
+ * of its own; removed nodes go on a free list for the next insert.
+ *
+ * Indexes stay valid when the array grows, but node addresses do not, so
+ * an insert makes room for its node before it takes any address.
+ */
+
+/* Helper functions */
+
+static struct itableNode       *
+nodeAt(const struct nITable *t, uint32_t index)
+{
+    return (struct itableNode *)(t->nodes + (size_t)index * t->nodeSize);
+}
+
+static char                    *
+nodeValue(const struct nITable *t, struct itableNode *node)
+{
+    return node->data + t->keySize;
+}
+
+static uint32_t
+nextLink(const struct nITable *t, const struct itableNode *node, const void *srchKey)
+{
+    if (tableBitSet(t->keySize, node->bit, srchKey))
+        return node->r;
+    return node->l;
+}
+
+/* Make sure the next allocNode will not move the array */
+static enum nErrorType
+reserveNode(struct nITable *t)
+{
+    size_t              newCapacity;
+    char               *newNodes;
+
+    if (t->freeNodes != ITABLE_NONE || t->used < t->capacity)
+        return nCodeSuccess;
+    if (t->capacity >= ITABLE_MAX_ELEMS)
+        return nCodeFull;
+    newCapacity = t->capacity * 2;
+    if (newCapacity > ITABLE_MAX_ELEMS)
+        newCapacity = ITABLE_MAX_ELEMS;
+    if (!(newNodes = realloc(t->nodes, newCapacity * t->nodeSize)))
+        return nCodeNoSpace;
+    t->nodes = newNodes;
+    t->capacity = newCapacity;
+    return nCodeSuccess;
+}
+
+/* Take the node made room for by reserveNode */
+static uint32_t
+allocNode(struct nITable *t, const void *keyIn, const void *valueIn, uint16_t bit)
+{
+    struct itableNode  *node;
+    uint32_t            index;
+
+    if ((index = t->freeNodes) != ITABLE_NONE)
+        t->freeNodes = nodeAt(t, index)->l;
+    else
+        index = t->used++;
+    node = nodeAt(t, index);
+    elemCopy(node->data, keyIn, t->keySize);
+    elemCopy(nodeValue(t, node), valueIn, t->valueSize);
+    node->bit = bit;
+    return index;
+}
+
+static void
+freeNode(struct nITable *t, uint32_t index)
+{
+    nodeAt(t, index)->l = t->freeNodes;
+    t->freeNodes = index;
+}
+
+/*
+ * Walk down from index toward srchKey until a link points back up the
+ * trie (or is empty), by the rules in table.h
+ */
+static uint32_t
+lookupStep(const struct nITable *t, uint32_t index, const void *srchKey, uint32_t parent,
+           uint32_t *parentOut, uint32_t *grandparentOut)
+{
+    struct itableNode  *node = nodeAt(t, index);
+    uint32_t            grandparent = ITABLE_NONE, next;
+    tableBit            prevBit = parent != ITABLE_NONE ? nodeAt(t, parent)->bit : -1;
+
+    while (tableLinkDown(prevBit, node->bit) && (next = nextLink(t, node, srchKey)) != ITABLE_NONE) {
+        grandparent = parent;
+        parent = index;
+        prevBit = node->bit;
+        index = next;
+        node = nodeAt(t, index);
+    }
+    *parentOut = parent;
+    *grandparentOut = grandparent;
+    return index;
+}
+
+/*
+ * Link a new node for newKey in place of the link tableInsertHere picks
+ * along its search path; reserveNode has already run
+ */
+static void
+insertStep(struct nITable *t, tableBit diffBit, const void *newKey, const void *newItem)
+{
+    struct itableNode  *node, *newNode;
+    uint32_t           *link = &t->head, newIndex;
+    tableBit            parentBit = -1;
+
+    for (;;) {
+        node = nodeAt(t, *link);
+        if (tableInsertHere(parentBit, node->bit, diffBit)) {
+            newIndex = allocNode(t, newKey, newItem, diffBit);
+            newNode = nodeAt(t, newIndex);
+            TABLE_LINK_NEW(newNode, newIndex, *link, tableBitSet(t->keySize, diffBit, newKey));
+            *link = newIndex;
+            return;
+        }
+        parentBit = node->bit;
+        if (tableBitSet(t->keySize, node->bit, newKey)) {
+            link = &node->r;
+        } else if (node->l != ITABLE_NONE) {
+            link = &node->l;
+        } else {
+            newIndex = allocNode(t, newKey, newItem, tableFindBitDiff(t->keySize, newKey, NULL));
+            newNode = nodeAt(t, newIndex);
+            newNode->r = newIndex;
+            newNode->l = ITABLE_NONE;
+            node->l = newIndex;
+            return;
+        }
+    }
+}
+
+static void
+linkSwap(struct nITable *t, uint32_t grandchild, uint32_t child, uint32_t parent)
+{
+    struct itableNode  *childNode = nodeAt(t, child), *parentNode = nodeAt(t, parent);
+
+    memcpy(nodeAt(t, grandchild)->data, childNode->data, t->keySize + t->valueSize);
+
+    TABLE_RELINK(parentNode, child, grandchild);
+    TABLE_RELINK(childNode, grandchild, ITABLE_NONE);
+}
+
+/* Splice victim out of the trie, given its parent (ITABLE_NONE for the head) */
+static void
+reduceLink(struct nITable *t, uint32_t parent, uint32_t victim)
+{
+    struct itableNode  *victimNode = nodeAt(t, victim), *parentNode;
+    uint32_t            newChild;
+
+    if (victimNode->l != ITABLE_NONE)
+        newChild = victimNode->l;
+    else
+        newChild = victimNode->r;
+
+    if (parent == ITABLE_NONE) {
+        t->head = newChild;
+    } else {
+        parentNode = nodeAt(t, parent);
+        TABLE_RELINK(parentNode, victim, newChild);
+    }
+    freeNode(t, victim);
+}
+
+/*
+ * A walk follows downward links only, so it visits each node once and
+ * never stacks more than one entry per node plus one, as walkDepth in
+ * table.c allows for
+ */
+static enum nErrorType
+walkInit(const struct nITable *t, struct nStack *pending)
+{
+    uint32_t            head = t->head;
+    size_t              maxDepth = TABLE_WALK_DEPTH(t->keySize * CHAR_BIT);
+
+    if (maxDepth > t->numElems + 2)
+        maxDepth = t->numElems + 2;
+    if (nStackInitM(pending, maxDepth, sizeof(uint32_t)))
+        return nCodeNoSpace;
+    nStackPush(pending, &head);
+    return nCodeSuccess;
+}
+
+/* Return the next node of a walk after queueing its children; ITABLE_NONE when done */
+static uint32_t
+walkNext(const struct nITable *t, struct nStack *pending)
+{
+    struct itableNode  *node;
+    uint32_t            index, child;
+    int                 side;
+
+    if (nStackPop(pending, &index))
+        return ITABLE_NONE;
+    node = nodeAt(t, index);
+    for (side = 0; side < 2; side++) {
+        child = side ? node->r : node->l;
+        if (child != ITABLE_NONE && tableLinkDown(node->bit, nodeAt(t, child)->bit))
+            nStackPush(pending, &child);
+    }
+    return index;
+}
+
+/* API functions */
+
+/*
+ * Keys of keySize bytes, up to ITABLE_MAX_KEY. The node array starts
+ * with room for initElems entries and doubles when it runs out.
+ */
+enum nErrorType
+nITableInit(struct nITable *t, size_t keySize, size_t valueSize, size_t initElems)
+{
+    const size_t        align = sizeof(uint32_t);
+
+    if (!keySize || keySize > ITABLE_MAX_KEY || initElems > ITABLE_MAX_ELEMS)
+        return nCodeBadInput;
+    if (initElems < ITABLE_MIN_NODES)
+        initElems = ITABLE_MIN_NODES;
+    t->nodeSize = (offsetof(struct itableNode, data) + keySize + valueSize + align - 1)
+        / align * align;
+    if (!(t->nodes = malloc(initElems * t->nodeSize)))
+        return nCodeNoSpace;
+    t->capacity = initElems;
+    t->used = 0;
+    t->head = ITABLE_NONE;
+    t->freeNodes = ITABLE_NONE;
+    t->numElems = 0;
+    t->keySize = keySize;
+    t->valueSize = valueSize;
+    return nCodeSuccess;
+}
+
+void
+nITableDestroy(struct nITable *t)
+{
+    free(t->nodes);
+    t->nodes = NULL;
+    t->capacity = 0;
+    t->used = 0;
+    t->head = ITABLE_NONE;
+    t->freeNodes = ITABLE_NONE;
+    t->numElems = 0;
+}
+
+enum nErrorType
+nITableInsert(struct nITable *t, const void *key, const void *dataIn)
+{
+    uint32_t            closest, parent, grandparent;
+    enum nErrorType     ret;
+
+    if (t->head != ITABLE_NONE) {
+        closest = lookupStep(t, t->head, key, ITABLE_NONE, &parent, &grandparent);
+        if (!elemDiffer(nodeAt(t, closest)->data, key, t->keySize)) {
+            elemCopy(nodeValue(t, nodeAt(t, closest)), dataIn, t->valueSize);
+            return nCodeSuccess;
+        }
+        if ((ret = reserveNode(t)))
+            return ret;
+        insertStep(t, tableFindBitDiff(t->keySize, key, nodeAt(t, closest)->data), key, dataIn);
+    } else {
+        if ((ret = reserveNode(t)))
+            return ret;
+        t->head = allocNode(t, key, dataIn, tableFindBitDiff(t->keySize, key, NULL));
+        nodeAt(t, t->head)->r = t->head;
+        nodeAt(t, t->head)->l = ITABLE_NONE;
+    }
+
+    t->numElems++;
+    return nCodeSuccess;
+}
+
+enum nErrorType
+nITablePeek(struct nITable *t, const void *key, void *dataOut)
+{
+    struct itableNode  *closest;
+    uint32_t            parent, grandparent;
+
+    if (t->head == ITABLE_NONE)
+        return nCodeNotFound;
+
+    closest = nodeAt(t, lookupStep(t, t->head, key, ITABLE_NONE, &parent, &grandparent));
+    if (elemDiffer(closest->data, key, t->keySize))
+        return nCodeNotFound;
+    elemCopy(dataOut, nodeValue(t, closest), t->valueSize);
+    return nCodeSuccess;
+}
+
+enum nErrorType
+nITableRemove(struct nITable *t, const void *key)
+{
+    struct itableNode  *parentNode;
+    uint32_t            closest, parent, grandparent, linkOwner, unused;
+
+    if (t->head == ITABLE_NONE)
+        return nCodeNotFound;
+
+    closest = lookupStep(t, t->head, key, ITABLE_NONE, &parent, &grandparent);
+    if (elemDiffer(nodeAt(t, closest)->data, key, t->keySize))
+        return nCodeNotFound;
+
+    parentNode = nodeAt(t, parent);
+    if (parent == closest) {
+        /* The node refers to its own key; drop that link and splice it out */
+        TABLE_RELINK(parentNode, closest, ITABLE_NONE);
+        reduceLink(t, grandparent, closest);
+    } else {
+        /* Move the parent's entry into the victim node and splice out the parent */
+        lookupStep(t, parent, parentNode->data, grandparent, &linkOwner, &unused);
+        linkSwap(t, closest, parent, linkOwner);
+        reduceLink(t, grandparent, parent);
+    }
+
+    t->numElems--;
+    return nCodeSuccess;
+}
+
+/*
+ * Call func on every entry, in no particular order. Entries func asks to
+ * remove are removed once the walk is complete, as nTableForEach does.
+ */
+void
+nITableForEach(struct nITable *t, nTableIterFunc func)
+{
+    struct nStack       pending;
+    struct nDeque       victims;
+    struct itableNode  *node;
+    uint32_t            index;
+    char               *victimKey;
+
+    if (t->head == ITABLE_NONE || walkInit(t, &pending))
+        return;
+    nDequeInit(&victims, t->keySize);
+    while ((index = walkNext(t, &pending)) != ITABLE_NONE) {
+        node = nodeAt(t, index);
+        if (func(node->data, nodeValue(t, node)))
+            nDequeInsertTail(&victims, node->data);
+    }
+    nStackDestroy(&pending);
+
+    if (!nDequeEmpty(&victims) && (victimKey = malloc(t->keySize))) {
+        while (!nDequeRemoveHead(&victims, victimKey))
+            nITableRemove(t, victimKey);
+        free(victimKey);
+    }
+    nDequeDestroy(&victims);
+}
+
+/*
+ * Renumber the nodes breadth-first from the head into an array of exactly
+ * numElems nodes, so that the top levels of the trie, which every search
+ * passes through, share the first few cache lines. Free nodes are dropped.
+ */
+enum nErrorType
+nITablePack(struct nITable *t)
+{
+    struct itableNode  *node;
+    uint32_t           *newIndex, child;
+    char               *packed, *oldNodes = t->nodes;
+    size_t              scan, filled = 0;
+    int                 side;
+
+    if (t->head == ITABLE_NONE)
+        return nCodeSuccess;
+    if (!(newIndex = malloc(t->used * sizeof(*newIndex))))
+        return nCodeNoSpace;
+    if (!(packed = malloc(t->numElems * t->nodeSize))) {
+        free(newIndex);
+        return nCodeNoSpace;
+    }
+
+    /* The packed array doubles as the queue of the breadth-first walk */
+    newIndex[t->head] = filled;
+    memcpy(packed, nodeAt(t, t->head), t->nodeSize);
+    filled++;
+    for (scan = 0; scan < filled; scan++) {
+        node = (struct itableNode *)(packed + scan * t->nodeSize);
+        for (side = 0; side < 2; side++) {
+            child = side ? node->r : node->l;
+            if (child == ITABLE_NONE || !tableLinkDown(node->bit, nodeAt(t, child)->bit))
+                continue;
+            newIndex[child] = filled;
+            memcpy(packed + filled * t->nodeSize, nodeAt(t, child), t->nodeSize);
+            filled++;
+        }
+    }
+
+    /* Upward links lead to nodes already numbered */
+    for (scan = 0; scan < filled; scan++) {
+        node = (struct itableNode *)(packed + scan * t->nodeSize);
+        if (node->l != ITABLE_NONE)
+            node->l = newIndex[node->l];
+        if (node->r != ITABLE_NONE)
+            node->r = newIndex[node->r];
+    }
+
+    free(newIndex);
+    free(oldNodes);
+    t->nodes = packed;
+    t->capacity = t->used = filled;
+    t->head = 0;
+    t->freeNodes = ITABLE_NONE;
+    return nCodeSuccess;
+}
+
+enum nBool
+nITableEmpty(const struct nITable *t)
+{
+    return nITableSize(t) == 0 ? nTrue : nFalse;
+}
+
+size_t
+nITableSize(const struct nITable *t)
+{
+    return t->numElems;
+}
@@ -0,0 +1,28 @@
+#ifndef ITABLE_H
+#define ITABLE_H
+
+#include <limits.h>
+#include <stdint.h>
+
+/* Link value of an empty link and of the end of the free node list */
+#define ITABLE_NONE 0xffffffffu
+#define ITABLE_MAX_ELEMS ITABLE_NONE
+
+/* Widest key whose bit offsets, up to keySize * 8, fit a node's bit */
+#define ITABLE_MAX_KEY (UINT16_MAX / CHAR_BIT)
+
+/* Room for this many nodes when the array is first allocated */
+#define ITABLE_MIN_NODES 16
+
+/*
+ * Key bytes followed by value bytes are stored inline after the header,
+ * which takes 10 bytes against the 20 of struct nTableNode. Free nodes
+ * are chained through l.
+ */
+struct itableNode {
+    uint32_t                        l, r;
+    uint16_t                        bit;
+    char                            data[];
+};
+
+#endif
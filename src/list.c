@@ -4,6 +4,8 @@
 #include "nanodtypes.h"
 
 #include "list.h"
+#include "pool.h"
+#include "copy.h"
 
 /* Helper functions */
 
@@ -26,12 +28,11 @@ insertNodeBefore(struct nListNode *newNode, struct nListNode *curNode)
 }
 
 static void
-removeNode(struct nListNode *victim)
+removeNode(struct nList *l, struct nListNode *victim)
 {
     victim->next->prev = victim->prev;
     victim->prev->next = victim->next;
-    free(victim->data);
-    free(victim);
+    nPoolFree(&l->pool, victim);
 }
 
 /* Allocate a new node and place the data into it; return NULL on failure */
@@ -40,14 +41,9 @@ allocNode(struct nList *l, void *dataIn)
 {
     struct nListNode   *newNode;
 
-    if (!(newNode = malloc(sizeof(struct nListNode)))) {
+    if (!(newNode = nPoolAlloc(&l->pool)))
         return NULL;
-    }
-    if (!(newNode->data = malloc(l->elemSize))) {
-        free(newNode);
-        return NULL;
-    }
-    memcpy(newNode->data, dataIn, l->elemSize);
+    elemCopy(newNode->data, dataIn, l->elemSize);
 
     return newNode;
 }
@@ -79,7 +75,7 @@ removeFromList(enum nBool copy, struct nList *l, struct nListNode *victim, void
     struct nListNode   *newHead;
 
     if (copy)
-        memcpy(dataOut, victim->data, l->elemSize);
+        elemCopy(dataOut, victim->data, l->elemSize);
     if (nListSize(l) == 1) {
         newHead = NULL;
     } else if (l->head == victim) {
@@ -89,7 +85,7 @@ removeFromList(enum nBool copy, struct nList *l, struct nListNode *victim, void
     }
     l->head = newHead;
 
-    removeNode(victim);
+    removeNode(l, victim);
     l->numElems--;
 }
 
@@ -97,10 +93,38 @@ removeFromList(enum nBool copy, struct nList *l, struct nListNode *victim, void
 
 void
 nListInit(struct nList *l, size_t elemSize)
+{
+    nListInitPool(l, elemSize, 0);
+}
+
+/* Carve nodes out of slabs of nodesPerSlab nodes each; 0 means plain malloc */
+void
+nListInitPool(struct nList *l, size_t elemSize, size_t nodesPerSlab)
 {
     l->head = NULL;
     l->numElems = 0;
     l->elemSize = elemSize;
+    nPoolInit(&l->pool, sizeof(struct nListNode) + elemSize, nodesPerSlab);
+}
+
+void
+nListDestroy(struct nList *l)
+{
+    struct nListNode   *curNode, *nextNode;
+    size_t              remaining;
+
+    if (l->pool.nodesPerSlab) {
+        nPoolRelease(&l->pool);
+    } else {
+        curNode = l->head;
+        for (remaining = nListSize(l); remaining; remaining--) {
+            nextNode = curNode->next;
+            nPoolFree(&l->pool, curNode);
+            curNode = nextNode;
+        }
+    }
+    l->head = NULL;
+    l->numElems = 0;
 }
 
 enum nErrorType
@@ -133,6 +157,88 @@ nListRemoveTail(struct nList *l, void *dataOut)
     return nCodeSuccess;
 }
 
+/*
+ * Append numElem elements stored contiguously at dataIn. The nodes are
+ * allocated and chained first, then spliced in at once; all or nothing.
+ */
+enum nErrorType
+nListInsertTailN(struct nList *l, void *dataIn, size_t numElem)
+{
+    struct nListNode   *first = NULL, *last = NULL, *newNode;
+    char               *curData = dataIn;
+    size_t              i;
+
+    if (!numElem)
+        return nCodeSuccess;
+
+    for (i = 0; i < numElem; i++, curData += l->elemSize) {
+        if (!(newNode = allocNode(l, curData))) {
+            while (first) {
+                newNode = first == last ? NULL : first->next;
+                nPoolFree(&l->pool, first);
+                first = newNode;
+            }
+            return nCodeNoSpace;
+        }
+        if (last) {
+            last->next = newNode;
+            newNode->prev = last;
+        } else {
+            first = newNode;
+        }
+        last = newNode;
+    }
+
+    if (l->head) {
+        first->prev = l->head->prev;
+        l->head->prev->next = first;
+        last->next = l->head;
+        l->head->prev = last;
+    } else {
+        first->prev = last;
+        last->next = first;
+        l->head = first;
+    }
+    l->numElems += numElem;
+    return nCodeSuccess;
+}
+
+/*
+ * Remove numElem elements from the head into dataOut, head first, unlinking
+ * them as one segment; all or nothing
+ */
+enum nErrorType
+nListRemoveHeadN(struct nList *l, void *dataOut, size_t numElem)
+{
+    struct nListNode   *curNode, *nextNode, *before;
+    char               *curData = dataOut;
+    size_t              i;
+
+    if (nListSize(l) < numElem)
+        return nCodeEmpty;
+    if (!numElem)
+        return nCodeSuccess;
+
+    curNode = l->head;
+    before = l->head->prev;
+    for (i = 0; i < numElem; i++, curData += l->elemSize) {
+        nextNode = curNode->next;
+        elemCopy(curData, curNode->data, l->elemSize);
+        nPoolFree(&l->pool, curNode);
+        curNode = nextNode;
+    }
+
+    l->numElems -= numElem;
+    if (nListEmpty(l)) {
+        l->head = NULL;
+    } else {
+        curNode->prev = before;
+        before->next = curNode;
+        l->head = curNode;
+    }
+    return nCodeSuccess;
+}
+
 enum nBool
 nListEmpty(struct nList *l)
 {
@@ -1,9 +1,10 @@
 #ifndef LIST_H
 #define LIST_H
 
+/* Element data is stored inline after the links */
 struct nListNode {
     struct nListNode               *next, *prev;
-    void                           *data;
+    char                            data[];
 };
 
 #endif
@@ -0,0 +1,116 @@
+#include <stdlib.h>
+
+#include "nanodtypes.h"
+#include "pool.h"
+
+/* Every slab starts with a pointer to the previously allocated slab */
+struct poolSlab {
+    struct poolSlab                *next;
+};
+
+/* Nodes start this far into a slab, past its header and aligned */
+#define SLAB_HEADER ((sizeof(struct poolSlab) + POOL_ALIGN - 1) / POOL_ALIGN * POOL_ALIGN)
+
+/* Freed nodes are chained through their first bytes */
+struct poolFreeNode {
+    struct poolFreeNode            *next;
+};
+
+/* Helper functions */
+
+static enum nErrorType
+addSlab(struct nPool *p, size_t numNodes)
+{
+    struct poolSlab    *slab;
+
+    if (!(slab = malloc(SLAB_HEADER + p->nodeSize * numNodes)))
+        return nCodeNoSpace;
+    slab->next = p->slabs;
+    p->slabs = slab;
+    p->bump = (char *)slab + SLAB_HEADER;
+    p->bumpEnd = p->bump + p->nodeSize * numNodes;
+    return nCodeSuccess;
+}
+
+/* Pool functions */
+
+void
+nPoolInit(struct nPool *p, size_t nodeSize, size_t nodesPerSlab)
+{
+    const size_t        align = POOL_ALIGN;
+
+    p->slabs = NULL;
+    p->freeList = NULL;
+    p->bump = NULL;
+    p->bumpEnd = NULL;
+    p->nodesPerSlab = nodesPerSlab;
+
+    /* Keep every node in a slab aligned for any scalar value */
+    if (nodesPerSlab)
+        nodeSize = (nodeSize + align - 1) / align * align;
+    p->nodeSize = nodeSize;
+}
+
+void               *
+nPoolAlloc(struct nPool *p)
+{
+    struct poolFreeNode *node;
+
+    if (!p->nodesPerSlab)
+        return malloc(p->nodeSize);
+
+    if ((node = p->freeList)) {
+        p->freeList = node->next;
+        return node;
+    }
+    if (p->bump == p->bumpEnd && addSlab(p, p->nodesPerSlab))
+        return NULL;
+    node = (struct poolFreeNode *)p->bump;
+    p->bump += p->nodeSize;
+    return node;
+}
+
+void
+nPoolFree(struct nPool *p, void *node)
+{
+    struct poolFreeNode *freed = node;
+
+    if (!p->nodesPerSlab) {
+        free(node);
+        return;
+    }
+    freed->next = p->freeList;
+    p->freeList = freed;
+}
+
+/*
+ * Make room for numNodes nodes in the current slab, starting a slab of at
+ * least numNodes when it is short, so that the next numNodes allocations
+ * not served from the free list are contiguous. Does nothing without a
+ * pool.
+ */
+enum nErrorType
+nPoolReserve(struct nPool *p, size_t numNodes)
+{
+    if (!p->nodesPerSlab || (size_t)(p->bumpEnd - p->bump) / p->nodeSize >= numNodes)
+        return nCodeSuccess;
+    if (numNodes > ((size_t)-1 - SLAB_HEADER) / p->nodeSize)
+        return nCodeNoSpace;
+    return addSlab(p, numNodes > p->nodesPerSlab ? numNodes : p->nodesPerSlab);
+}
+
+/* Return every slab to the system at once; outstanding nodes become invalid */
+void
+nPoolRelease(struct nPool *p)
+{
+    struct poolSlab    *slab, *next;
+
+    for (slab = p->slabs; slab; slab = next) {
+        next = slab->next;
+        free(slab);
+    }
+    p->slabs = NULL;
+    p->freeList = NULL;
+    p->bump = NULL;
+    p->bumpEnd = NULL;
+}
@@ -0,0 +1,32 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+/*
+ * Fixed-size node allocator shared by the container types. A pool with
+ * nodesPerSlab == 0 passes every request straight through to malloc/free.
+ */
+
+/*
+ * Alignment of every pooled node, enough for any pointer, integer or
+ * floating-point type up to double
+ */
+struct poolAlignProbe {
+    char                            c;
+    union {
+        void                       *p;
+        long long                   ll;
+        double                      d;
+    }                               u;
+};
+
+#define POOL_ALIGN offsetof(struct poolAlignProbe, u)
+
+void                            nPoolInit(struct nPool *p, size_t nodeSize, size_t nodesPerSlab);
+void                           *nPoolAlloc(struct nPool *p);
+enum nErrorType                 nPoolReserve(struct nPool *p, size_t numNodes);
+void                            nPoolFree(struct nPool *p, void *node);
+void                            nPoolRelease(struct nPool *p);
+
+#endif
@@ -0,0 +1,189 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "nanodtypes.h"
+#include "queue.h"
+#include "copy.h"
+
+#if !defined(__GNUC__)
+#error "nQueue needs the GCC __atomic builtins"
+#endif
+
+/*
+ * Bounded lock-free queue over a ring of slots, each holding a sequence
+ * number followed by one element. A slot at ring position pos is free for
+ * the enqueue numbered pos when its sequence is pos, and holds that
+ * element for the dequeue numbered pos once its sequence is pos + 1; the
+ * dequeue hands it on to enqueue pos + capacity. Producers claim enqueue
+ * numbers by compare-and-swap on tail, consumers claim dequeue numbers on
+ * head, and the slot sequence alone passes each element across.
+ *
+ * With a single producer and a single consumer, each side owns its
+ * counter outright and claims the next number with a plain store.
+ */
+
+/* Helper functions */
+
+static size_t                  *
+slotSeq(struct nQueue *q, size_t pos)
+{
+    return (size_t *)(q->slots + (pos & q->mask) * q->slotSize);
+}
+
+static char                    *
+slotData(size_t *seq)
+{
+    return (char *)(seq + 1);
+}
+
+/* Claim the next enqueue number; NULL when the queue is full */
+static size_t                  *
+claimTail(struct nQueue *q, size_t *posOut)
+{
+    size_t              pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED), *seq;
+    intptr_t            dif;
+
+    for (;;) {
+        seq = slotSeq(q, pos);
+        dif = (intptr_t)__atomic_load_n(seq, __ATOMIC_ACQUIRE) - (intptr_t)pos;
+        if (dif < 0)
+            return NULL;
+        if (dif == 0) {
+            if (q->mode == QUEUE_SPSC) {
+                __atomic_store_n(&q->tail, pos + 1, __ATOMIC_RELAXED);
+                break;
+            }
+            if (__atomic_compare_exchange_n(&q->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED))
+                break;
+        } else {
+            pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+        }
+    }
+    *posOut = pos;
+    return seq;
+}
+
+/* Claim the next dequeue number; NULL when the queue is empty */
+static size_t                  *
+claimHead(struct nQueue *q, size_t *posOut)
+{
+    size_t              pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED), *seq;
+    intptr_t            dif;
+
+    for (;;) {
+        seq = slotSeq(q, pos);
+        dif = (intptr_t)__atomic_load_n(seq, __ATOMIC_ACQUIRE) - (intptr_t)(pos + 1);
+        if (dif < 0)
+            return NULL;
+        if (dif == 0) {
+            if (q->mode == QUEUE_SPSC) {
+                __atomic_store_n(&q->head, pos + 1, __ATOMIC_RELAXED);
+                break;
+            }
+            if (__atomic_compare_exchange_n(&q->head, &pos, pos + 1, 1, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED))
+                break;
+        } else {
+            pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+        }
+    }
+    *posOut = pos;
+    return seq;
+}
+
+/* API functions */
+
+/*
+ * Queue of capacity elements, rounded up to a power of two, for any
+ * number of producer and consumer threads
+ */
+enum nErrorType
+nQueueInit(struct nQueue *q, size_t capacity, size_t elemSize)
+{
+    size_t              numSlots = 2, pos;
+
+    if (!capacity || capacity > SIZE_MAX / 4)
+        return nCodeBadInput;
+    while (numSlots < capacity)
+        numSlots *= 2;
+
+    /* Keep every slot's sequence number aligned */
+    q->slotSize = (sizeof(size_t) + elemSize + sizeof(size_t) - 1) / sizeof(size_t)
+        * sizeof(size_t);
+    if (numSlots > SIZE_MAX / q->slotSize || !(q->slots = malloc(numSlots * q->slotSize)))
+        return nCodeNoSpace;
+    q->mask = numSlots - 1;
+    q->elemSize = elemSize;
+    q->mode = QUEUE_MPMC;
+    q->tail = 0;
+    q->head = 0;
+    for (pos = 0; pos < numSlots; pos++)
+        *slotSeq(q, pos) = pos;
+    return nCodeSuccess;
+}
+
+/*
+ * The same queue for exactly one producer thread and one consumer thread,
+ * which claim slots without compare-and-swap
+ */
+enum nErrorType
+nQueueInitSPSC(struct nQueue *q, size_t capacity, size_t elemSize)
+{
+    enum nErrorType     ret;
+
+    if ((ret = nQueueInit(q, capacity, elemSize)))
+        return ret;
+    q->mode = QUEUE_SPSC;
+    return nCodeSuccess;
+}
+
+void
+nQueueDestroy(struct nQueue *q)
+{
+    free(q->slots);
+    q->slots = NULL;
+    q->mask = 0;
+    q->tail = 0;
+    q->head = 0;
+}
+
+enum nErrorType
+nQueueInsertTail(struct nQueue *q, const void *dataIn)
+{
+    size_t              pos, *seq;
+
+    if (!(seq = claimTail(q, &pos)))
+        return nCodeFull;
+    elemCopy(slotData(seq), dataIn, q->elemSize);
+    __atomic_store_n(seq, pos + 1, __ATOMIC_RELEASE);
+    return nCodeSuccess;
+}
+
+enum nErrorType
+nQueueRemoveHead(struct nQueue *q, void *dataOut)
+{
+    size_t              pos, *seq;
+
+    if (!(seq = claimHead(q, &pos)))
+        return nCodeEmpty;
+    elemCopy(dataOut, slotData(seq), q->elemSize);
+    __atomic_store_n(seq, pos + q->mask + 1, __ATOMIC_RELEASE);
+    return nCodeSuccess;
+}
+
+/* Exact when no other thread is using the queue, otherwise a snapshot */
+enum nBool
+nQueueEmpty(struct nQueue *q)
+{
+    return nQueueSize(q) == 0;
+}
+
+size_t
+nQueueSize(struct nQueue *q)
+{
+    size_t              head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+    size_t              tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+
+    return tail > head ? tail - head : 0;
+}
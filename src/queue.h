@@ -0,0 +1,8 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+/* Values of the nQueue mode field */
+#define QUEUE_MPMC 0
+#define QUEUE_SPSC 1
+
+#endif
@@ -3,6 +3,149 @@
 
 #include "nanodtypes.h"
 #include "stack.h"
+#include "copy.h"
+
+/* Helper functions */
+
+/* Move a growable stack to a buffer of newMax elements */
+static enum nErrorType
+resize(struct nStack *s, size_t newMax)
+{
+    char               *base = s->stackData - s->numElems * s->elemSize;
+
+    if (!(base = realloc(base, newMax * s->elemSize)))
+        return nCodeNoSpace;
+    s->stackData = base + s->numElems * s->elemSize;
+    s->maxElem = newMax;
+    return nCodeSuccess;
+}
+
+/* Make room for numElem elements, at least doubling, up to the limit */
+static enum nErrorType
+grow(struct nStack *s, size_t numElem)
+{
+    size_t              newMax = s->maxElem * 2;
+
+    if (s->managed != STACK_GROWABLE || (s->limitElem && numElem > s->limitElem))
+        return nCodeFull;
+    if (newMax < numElem)
+        newMax = numElem;
+    if (s->limitElem && newMax > s->limitElem)
+        newMax = s->limitElem;
+    return resize(s, newMax);
+}
+
+/*
+ * Halve the capacity once the stack is only a quarter full, but never
+ * below its initial or reserved size; growing happens only when full, so
+ * alternating pushes and pops at a boundary cannot thrash
+ */
+static void
+shrink(struct nStack *s)
+{
+    size_t              newMax = s->maxElem;
+
+    if (s->managed != STACK_GROWABLE)
+        return;
+    while (s->numElems < newMax / 4 && newMax / 2 >= s->minElem)
+        newMax /= 2;
+    if (newMax != s->maxElem)
+        resize(s, newMax);
+}
+
+/*
+ * A segmented stack keeps its elements in blocks of maxElem elements,
+ * linked from the top block down, so growing adds a block and never moves
+ * an element. stackData points into the top block, which holds at least
+ * one element unless the whole stack is empty. The last block to empty is
+ * kept as a spare, so pushes and pops across a block boundary do not
+ * call malloc and free each time.
+ */
+
+static char                    *
+blockEnd(const struct nStack *s)
+{
+    return ((struct stackBlock *)s->block)->data + s->maxElem * s->elemSize;
+}
+
+/* Put a block on top, the spare if there is one */
+static enum nErrorType
+pushBlock(struct nStack *s)
+{
+    struct stackBlock  *block = s->spareBlock;
+
+    if (block)
+        s->spareBlock = NULL;
+    else if (!(block = malloc(sizeof(*block) + s->maxElem * s->elemSize)))
+        return nCodeNoSpace;
+    block->prev = s->block;
+    s->block = block;
+    s->stackData = block->data;
+    return nCodeSuccess;
+}
+
+/* Step down from an emptied top block, keeping it as the spare */
+static void
+popBlock(struct nStack *s)
+{
+    struct stackBlock  *block = s->block;
+
+    s->block = block->prev;
+    free(s->spareBlock);
+    s->spareBlock = block;
+    s->stackData = blockEnd(s);
+}
+
+/*
+ * Pop numElem elements into dataOut as nStackPopN does, a block at a
+ * time; with dataOut NULL they are dropped
+ */
+static void
+segmentPopN(struct nStack *s, void *dataOut, size_t numElem)
+{
+    struct stackBlock  *block;
+    size_t              chunk;
+
+    while (numElem) {
+        block = s->block;
+        chunk = (s->stackData - block->data) / s->elemSize;
+        if (chunk > numElem)
+            chunk = numElem;
+        s->stackData -= chunk * s->elemSize;
+        s->numElems -= chunk;
+        numElem -= chunk;
+        if (dataOut)
+            memcpy((char *)dataOut + numElem * s->elemSize, s->stackData, chunk * s->elemSize);
+        if (s->stackData == block->data && block->prev)
+            popBlock(s);
+    }
+}
+
+/* nStackPushN a block at a time; a failed push drops what it added */
+static enum nErrorType
+segmentPushN(struct nStack *s, void *dataIn, size_t numElem)
+{
+    size_t              chunk, pushed = 0;
+
+    if (s->limitElem && s->numElems + numElem > s->limitElem)
+        return nCodeFull;
+    while (pushed < numElem) {
+        if (s->stackData == blockEnd(s) && pushBlock(s)) {
+            segmentPopN(s, NULL, pushed);
+            return nCodeNoSpace;
+        }
+        chunk = (blockEnd(s) - s->stackData) / s->elemSize;
+        if (chunk > numElem - pushed)
+            chunk = numElem - pushed;
+        memcpy(s->stackData, (char *)dataIn + pushed * s->elemSize, chunk * s->elemSize);
+        s->stackData += chunk * s->elemSize;
+        s->numElems += chunk;
+        pushed += chunk;
+    }
+    return nCodeSuccess;
+}
+
+/* API functions */
 
 enum nErrorType
 nStackInitM(struct nStack *s, size_t maxElem, size_t elemSize)
@@ -27,31 +170,105 @@ nStackInit(struct nStack *s, void *stackData, size_t maxElem, size_t elemSize)
     s->stackData = stackData;   /* Check for NULL ptr? */
     s->elemSize = elemSize;     /* Check for limits */
     s->maxElem = maxElem;       /* Check for limits */
+    s->minElem = maxElem;
+    s->limitElem = maxElem;
     s->managed = STACK_FALSE;
+    s->block = NULL;
+    s->spareBlock = NULL;
+    return nCodeSuccess;
+}
+
+/*
+ * Managed stack that starts with room for initElem elements and doubles
+ * when full, up to limitElem elements (0 for no limit)
+ */
+enum nErrorType
+nStackInitG(struct nStack *s, size_t initElem, size_t limitElem, size_t elemSize)
+{
+    enum nErrorType     ret;
+
+    if (!initElem || (limitElem && initElem > limitElem))
+        return nCodeBadInput;
+    if ((ret = nStackInitM(s, initElem, elemSize)))
+        return ret;
+    s->limitElem = limitElem;
+    s->managed = STACK_GROWABLE;
+    return nCodeSuccess;
+}
+
+/*
+ * Managed stack of blocks of blockElem elements each, up to limitElem
+ * elements (0 for no limit, otherwise at least blockElem). Growing links
+ * in another block instead of moving the elements, so no push pays for
+ * copying the stack; the first block is allocated here.
+ */
+enum nErrorType
+nStackInitS(struct nStack *s, size_t blockElem, size_t limitElem, size_t elemSize)
+{
+    if (!blockElem || !elemSize || (limitElem && limitElem < blockElem))
+        return nCodeBadInput;
+    nStackInit(s, NULL, blockElem, elemSize);
+    s->limitElem = limitElem;
+    s->managed = STACK_SEGMENTED;
+    return pushBlock(s);
+}
+
+/*
+ * Make room for numElem elements; a growable stack keeps it from then on.
+ * A segmented stack only checks its limit, since its blocks come as needed.
+ */
+enum nErrorType
+nStackReserve(struct nStack *s, size_t numElem)
+{
+    if (s->managed == STACK_SEGMENTED)
+        return s->limitElem && numElem > s->limitElem ? nCodeFull : nCodeSuccess;
+    if (numElem <= s->maxElem) {
+        if (numElem > s->minElem)
+            s->minElem = numElem;
+        return nCodeSuccess;
+    }
+    if (s->managed != STACK_GROWABLE || (s->limitElem && numElem > s->limitElem))
+        return nCodeFull;
+    if (resize(s, numElem))
+        return nCodeNoSpace;
+    s->minElem = numElem;
     return nCodeSuccess;
 }
 
 void
 nStackDestroy(struct nStack *s)
 {
-    if (s->managed)
-        free(s->stackData);
+    struct stackBlock  *block, *prev;
+
+    if (s->managed == STACK_SEGMENTED) {
+        for (block = s->block; block; block = prev) {
+            prev = block->prev;
+            free(block);
+        }
+        free(s->spareBlock);
+    } else if (s->managed) {
+        free(s->stackData - s->numElems * s->elemSize);
+    }
+    s->block = NULL;
+    s->spareBlock = NULL;
     s->stackData = NULL;
     s->managed = STACK_FALSE;
     s->numElems = 0;
     s->maxElem = 0;
+    s->minElem = 0;
+    s->limitElem = 0;
     s->elemSize = 0;
 }
 
 enum nErrorType
 nStackPush(struct nStack *s, void *dataIn)
 {
-    if (nStackFull(s)) {
-        return nCodeFull;
-    }
-    memcpy(s->stackData, dataIn, s->elemSize);
-    s->numElems++;
-    s->stackData += s->elemSize;
+    enum nErrorType     ret;
+    void               *slot;
+
+    if ((ret = nStackPushSlot(s, &slot)))
+        return ret;
+    elemCopy(slot, dataIn, s->elemSize);
     return nCodeSuccess;
 }
 
@@ -62,8 +279,52 @@ nStackPop(struct nStack *s, void *dataOut)
         return nCodeEmpty;
     }
     s->stackData -= s->elemSize;
-    memcpy(dataOut, s->stackData, s->elemSize);
+    elemCopy(dataOut, s->stackData, s->elemSize);
     s->numElems--;
+    if (s->managed == STACK_SEGMENTED) {
+        if (s->stackData == ((struct stackBlock *)s->block)->data && s->numElems)
+            popBlock(s);
+    } else {
+        shrink(s);
+    }
+    return nCodeSuccess;
+}
+
+/* Push numElem elements stored contiguously at dataIn; all or nothing */
+enum nErrorType
+nStackPushN(struct nStack *s, void *dataIn, size_t numElem)
+{
+    enum nErrorType     ret;
+
+    if (s->managed == STACK_SEGMENTED)
+        return segmentPushN(s, dataIn, numElem);
+    if (s->numElems + numElem > s->maxElem && (ret = grow(s, s->numElems + numElem))) {
+        return ret;
+    }
+    memcpy(s->stackData, dataIn, numElem * s->elemSize);
+    s->numElems += numElem;
+    s->stackData += numElem * s->elemSize;
+    return nCodeSuccess;
+}
+
+/*
+ * Pop the top numElem elements into dataOut, bottom-most first, so that
+ * the data reads back in the order nStackPushN took it; all or nothing
+ */
+enum nErrorType
+nStackPopN(struct nStack *s, void *dataOut, size_t numElem)
+{
+    if (nStackSize(s) < numElem) {
+        return nCodeEmpty;
+    }
+    if (s->managed == STACK_SEGMENTED) {
+        segmentPopN(s, dataOut, numElem);
+        return nCodeSuccess;
+    }
+    s->stackData -= numElem * s->elemSize;
+    memcpy(dataOut, s->stackData, numElem * s->elemSize);
+    s->numElems -= numElem;
+    shrink(s);
     return nCodeSuccess;
 }
 
@@ -73,7 +334,47 @@ nStackPeek(struct nStack *s, void *dataOut)
     if (nStackEmpty(s)) {
         return nCodeEmpty;
     }
-    memcpy(dataOut, s->stackData - s->elemSize, s->elemSize);
+    elemCopy(dataOut, s->stackData - s->elemSize, s->elemSize);
+    return nCodeSuccess;
+}
+
+/*
+ * Zero-copy access to the top element: dataOut receives a pointer into the
+ * stack's storage. A growable stack moves its elements when it grows or
+ * shrinks, so there the pointer is good only until the next push, pop or
+ * reserve; on a fixed-size or segmented stack it stays valid until that
+ * element is popped.
+ */
+enum nErrorType
+nStackTop(struct nStack *s, void **dataOut)
+{
+    if (nStackEmpty(s))
+        return nCodeEmpty;
+    *dataOut = s->stackData - s->elemSize;
+    return nCodeSuccess;
+}
+
+/*
+ * Push an element without copying one in: slotOut receives the new top
+ * element, uninitialized, to be filled in place. The pointer stays valid
+ * as for nStackTop.
+ */
+enum nErrorType
+nStackPushSlot(struct nStack *s, void **slotOut)
+{
+    enum nErrorType     ret;
+
+    if (s->managed == STACK_SEGMENTED) {
+        if (s->limitElem && s->numElems >= s->limitElem)
+            return nCodeFull;
+        if (s->stackData == blockEnd(s) && (ret = pushBlock(s)))
+            return ret;
+    } else if (s->numElems >= s->maxElem && (ret = grow(s, s->numElems + 1))) {
+        return ret;
+    }
+    *slotOut = s->stackData;
+    s->stackData += s->elemSize;
+    s->numElems++;
     return nCodeSuccess;
 }
 
@@ -83,9 +384,12 @@ nStackEmpty(struct nStack *s)
     return s->numElems <= 0;
 }
 
+/* A growable or segmented stack is full only once it reaches its limit */
 enum nBool
 nStackFull(struct nStack *s)
 {
+    if (s->managed == STACK_GROWABLE || s->managed == STACK_SEGMENTED)
+        return s->limitElem && s->numElems >= s->limitElem;
     return s->numElems >= s->maxElem;
 }
 
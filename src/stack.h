@@ -6,4 +6,19 @@
 #define STACK_TRUE 1
 #define STACK_FALSE 0
 
+/* Value of the managed field for a stack that reallocates as it fills */
+#define STACK_GROWABLE 2
+
+/* Value of the managed field for a stack built from linked blocks */
+#define STACK_SEGMENTED 3
+
+/*
+ * Block of a segmented stack: maxElem elements, and a link to the block
+ * below. Only the top block can have room to spare.
+ */
+struct stackBlock {
+    struct stackBlock              *prev;
+    char                            data[];
+};
+
 #endif
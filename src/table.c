@@ -1,146 +1,568 @@
+#include <limits.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "nanodtypes.h"
 #include "table.h"
+#include "pool.h"
+#include "copy.h"
 
 const unsigned short            bitsPerByte = 8;
 
+/*
+ * Variable-length keys are indexed as 9-bit groups: a bit that is set
+ * while key bytes remain, then the 8 bits of the byte. Past the end every
+ * bit is clear, so no key is a prefix of another and the trie keeps keys
+ * in byte-wise lexicographic order.
+ */
+#define VAR_BITS_PER_BYTE 9
+
+/* Longest variable-length key whose bit offsets still fit a node's bit */
+#define VAR_KEY_MAX (TABLE_BIT_MAX / VAR_BITS_PER_BYTE)
+
+/*
+ * Prefix keys are indexed the same way a bit at a time: a bit that is set
+ * while the prefix lasts, then the key bit. A prefix then sorts before
+ * every longer prefix that extends it.
+ */
+#define PREFIX_BITS_PER_BIT 2
+
+/* Widest fixed-size and prefix keys whose bit offsets fit a node's bit */
+#define FIXED_KEY_MAX (TABLE_BIT_MAX / CHAR_BIT)
+#define PREFIX_KEY_MAX (TABLE_BIT_MAX / CHAR_BIT / PREFIX_BITS_PER_BIT)
+
+/* Number of lookups nTablePeekBatch keeps in flight at once */
+#define PEEK_BATCH_WIDTH 16
+
+#if defined(__GNUC__)
+#define PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define PREFETCH(addr)
+#endif
+
+/* Walks over keys up to 8 bytes wide keep their stack in a local array */
+#define WALK_LOCAL_DEPTH 66
+
+/* Links an insert remembers from its lookup, so it need not walk again */
+#define INSERT_PATH_DEPTH 64
+
+/* One link followed by a lookup, and the bits tested above and below it */
+struct pathStep {
+    struct nTableNode             **link;
+    tableBit                        parentBit;
+    tableBit                        bit;
+};
+
+/* State of one in-flight lookup in nTablePeekBatch */
+struct peekCursor {
+    struct nTableNode              *node;
+    tableBit                        prevBit;
+    size_t                          keyIdx;
+};
+
+/*
+ * Snapshot files written by nTableSave hold a header and then one record
+ * per node, the head first and the rest in depth-first order. Links are
+ * byte offsets from the start of the record that holds them, so a mapping
+ * of the file can be searched wherever it lands. Files are only read back
+ * on machines with the same byte order.
+ */
+#define TABLE_FILE_MAGIC "nTable\0"
+#define TABLE_FILE_VERSION 2
+#define TABLE_FILE_BYTE_ORDER 0x01020304u
+#define TABLE_FILE_NO_LINK INT64_MIN
+
+struct tableFileHeader {
+    char                            magic[8];
+    uint32_t                        byteOrder;
+    uint32_t                        version;
+    uint64_t                        numElems;
+    uint64_t                        keySize;
+    uint64_t                        valueSize;
+    uint64_t                        recordSize;
+};
+
+/*
+ * Key bytes followed by value bytes, as in struct nTableNode; the value
+ * starts at the next multiple of 8 bytes from the record's start
+ */
+#define TABLE_FILE_VALUE_ALIGN 8
+
+struct tableFileNode {
+    int64_t                         l, r;
+    tableBit                        bit;
+    char                            data[];
+};
+
+/* Node of the walk in nTableSave, and the link of its parent to fill in */
+struct saveEntry {
+    struct nTableNode              *node;
+    size_t                          depth;
+    struct tableFileNode           *parent;
+    int                             side;
+};
+
 /* Helper functions */
 
+/*
+ * Key bytes of a node and, through lenOut, their length: keySize for
+ * fixed-size keys, the byte count for variable-length keys and the bit
+ * count for prefix keys
+ */
+static char                    *
+nodeKey(const struct nTable *t, struct nTableNode *node, size_t *lenOut)
+{
+    struct nTableVarKey ref;
+    uint32_t            prefixBits;
+
+    switch (t->keyMode) {
+    case TABLE_KEYS_VAR:
+        memcpy(&ref, node->data, sizeof(ref));
+        *lenOut = ref.len;
+        return ref.bytes;
+    case TABLE_KEYS_PREFIX:
+        memcpy(&prefixBits, node->data + t->keySize, sizeof(prefixBits));
+        *lenOut = prefixBits;
+        return node->data;
+    default:
+        *lenOut = t->keySize;
+        return node->data;
+    }
+}
+
+/* Bytes of a node, from its links to the end of its value */
+static size_t
+nodeSize(size_t keySlot, size_t valueSize)
+{
+    size_t              dataStart = offsetof(struct nTableNode, data);
+    size_t              size = dataStart + tableValueOffset(dataStart, keySlot, POOL_ALIGN) + valueSize;
+
+    return size > sizeof(struct nTableNode) ? size : sizeof(struct nTableNode);
+}
+
+/* Clear the bits of a prefix key past its first prefixBits */
+static void
+maskPrefix(unsigned char *key, size_t keySize, size_t prefixBits)
+{
+    size_t              byteOffset = prefixBits / bitsPerByte;
+
+    if (prefixBits % bitsPerByte)
+        key[byteOffset++] &= 0xff << (bitsPerByte - prefixBits % bitsPerByte);
+    memset(key + byteOffset, 0, keySize - byteOffset);
+}
+
 static struct nTableNode       *
-allocNode(struct nTable *t, const void *keyIn, const void *valueIn, short bit)
+allocNode(struct nTable *t, const void *keyIn, size_t keyLen, const void *valueIn, tableBit bit)
 {
     struct nTableNode  *newNode;
+    struct nTableVarKey ref;
+    uint32_t            prefixBits = keyLen;
 
-    if (!(newNode = malloc(sizeof(struct nTableNode))))
-        goto err;
-    if (!(newNode->key = malloc(t->keySize)))
-        goto errN;
-    if (!(newNode->value = malloc(t->valueSize)))
-        goto errK;
-    memcpy(newNode->key, keyIn, t->keySize);
-    memcpy(newNode->value, valueIn, t->valueSize);
+    if (!(newNode = nPoolAlloc(&t->pool)))
+        return NULL;
+    if (t->keyMode == TABLE_KEYS_VAR) {
+        if (!(ref.bytes = malloc(keyLen))) {
+            nPoolFree(&t->pool, newNode);
+            return NULL;
+        }
+        memcpy(ref.bytes, keyIn, keyLen);
+        ref.len = keyLen;
+        memcpy(newNode->data, &ref, sizeof(ref));
+    } else {
+        elemCopy(newNode->data, keyIn, t->keySize);
+    }
+    if (t->keyMode == TABLE_KEYS_PREFIX) {
+        maskPrefix((unsigned char *)newNode->data, t->keySize, prefixBits);
+        memcpy(newNode->data + t->keySize, &prefixBits, sizeof(prefixBits));
+    }
+    if (valueIn)
+        elemCopy(tableNodeValue(t, newNode), valueIn, t->valueSize);
+    else
+        memset(tableNodeValue(t, newNode), 0, t->valueSize);
     newNode->bit = bit;
     return newNode;
+}
+
+/* Release the separately allocated key of a variable-length key node */
+static void
+freeNodeKey(struct nTable *t, struct nTableNode *node)
+{
+    size_t              keyLen;
+
+    if (t->keyMode == TABLE_KEYS_VAR)
+        free(nodeKey(t, node, &keyLen));
+}
+
+static void
+freeNode(struct nTable *t, struct nTableNode *node)
+{
+    nPoolFree(&t->pool, node);
+}
+
+/*
+ * Every node is reached by exactly one downward link (child bit greater
+ * than parent bit); its other links point back up to ancestors. A
+ * depth-first walk over downward links visits each node once, and its
+ * stack never holds more than one entry per bit position plus one, nor
+ * more than one per node plus one.
+ */
+static size_t
+walkDepth(const struct nTable *t)
+{
+    size_t              maxDepth;
+
+    switch (t->keyMode) {
+    case TABLE_KEYS_VAR:
+        maxDepth = TABLE_WALK_DEPTH(t->keySize * VAR_BITS_PER_BYTE);
+        break;
+    case TABLE_KEYS_PREFIX:
+        maxDepth = TABLE_WALK_DEPTH(t->keySize * bitsPerByte * PREFIX_BITS_PER_BIT);
+        break;
+    default:
+        maxDepth = TABLE_WALK_DEPTH(t->keySize * bitsPerByte);
+        break;
+    }
+    if (maxDepth > t->numElems + 2)
+        maxDepth = t->numElems + 2;
+    return maxDepth;
+}
+
+/* The walk stack uses localBuf when that is big enough and localBuf is not NULL */
+static enum nErrorType
+pathInit(const struct nTable *t, struct nStack *pending, struct nTableNode **localBuf)
+{
+    size_t              maxDepth = walkDepth(t);
+
+    if (localBuf && maxDepth <= WALK_LOCAL_DEPTH)
+        nStackInit(pending, localBuf, maxDepth, sizeof(*localBuf));
+    else if (nStackInitM(pending, maxDepth, sizeof(*localBuf)))
+        return nCodeNoSpace;
+    return nCodeSuccess;
+}
+
+static enum nErrorType
+walkInit(const struct nTable *t, struct nStack *pending, struct nTableNode **localBuf)
+{
+    struct nTableNode  *head = t->head;
 
-errK:
-    free(newNode->key);
-errN:
-    free(newNode);
-err:
-    return NULL;
+    if (pathInit(t, pending, localBuf))
+        return nCodeNoSpace;
+    nStackPush(pending, &head);
+    return nCodeSuccess;
+}
+
+/* Return the next node of a walk after queueing its children; NULL when done */
+static struct nTableNode       *
+walkNext(struct nStack *pending)
+{
+    struct nTableNode  *node, *child;
+    int                 side;
+
+    if (nStackPop(pending, &node))
+        return NULL;
+    for (side = 0; side < 2; side++) {
+        child = side ? node->r : node->l;
+        if (child && tableLinkDown(node->bit, child->bit))
+            nStackPush(pending, &child);
+    }
+    return node;
 }
 
+/*
+ * Free every node and variable-length key without recursion. Back-edges
+ * lead to ancestors whose bit must stay readable, so visited nodes are
+ * chained through their left link and freed once the walk is complete.
+ * Pooled nodes are left for nPoolRelease.
+ */
 static void
-freeNode(struct nTableNode *node)
+freeAllNodes(struct nTable *t)
 {
-    free(node->key);
-    free(node->value);
-    free(node);
+    struct nStack       pending;
+    struct nTableNode  *localBuf[WALK_LOCAL_DEPTH], *node, *visited = NULL;
+
+    if (walkInit(t, &pending, localBuf))
+        return;
+    while ((node = walkNext(&pending))) {
+        node->l = visited;
+        visited = node;
+    }
+    nStackDestroy(&pending);
+
+    while (visited) {
+        node = visited->l;
+        freeNodeKey(t, visited);
+        if (!t->pool.nodesPerSlab)
+            freeNode(t, visited);
+        visited = node;
+    }
 }
 
+/* tableBitSet for variable-length keys; bits past the end read as clear */
 static enum nBool
-bitSet(unsigned short bitOff, const void *key)
+varBitSet(size_t keyLen, tableBit bitOff, const void *key)
 {
+    size_t              byteOffset = (uint32_t)bitOff / VAR_BITS_PER_BYTE;
+    unsigned int        groupBitOffset = (uint32_t)bitOff % VAR_BITS_PER_BYTE;
 
-    unsigned short      byteOffset = bitOff / bitsPerByte;
-    unsigned short      innerBitOffset = bitOff % bitsPerByte;
+    if (byteOffset >= keyLen)
+        return nFalse;
+    if (!groupBitOffset)
+        return nTrue;
 
-    return (*((unsigned char *)key + byteOffset) >> (bitsPerByte - 1 - innerBitOffset)) & 1;
+    return (*((unsigned char *)key + byteOffset) >> (VAR_BITS_PER_BYTE - 1 - groupBitOffset)) & 1;
+}
+
+/* tableBitSet for prefix keys; bits past the end of the prefix read as clear */
+static enum nBool
+prefixBitSet(size_t keySize, size_t prefixBits, tableBit bitOff, const void *key)
+{
+    tableBit            keyBit = (uint32_t)bitOff / PREFIX_BITS_PER_BIT;
 
+    if (keyBit >= prefixBits)
+        return nFalse;
+    if (!(bitOff % PREFIX_BITS_PER_BIT))
+        return nTrue;
+    return tableBitSet(keySize, keyBit, key);
 }
 
-static short
-findBitDiff(size_t keySize, const void *key1, const void *key2)
+static enum nBool
+keyBitSet(const struct nTable *t, size_t keyLen, tableBit bitOff, const void *key)
 {
-    unsigned char       curByte1, curByte2, *key1Byte, *key2Byte, curByteMask;
-    size_t              byteOffset;
-    unsigned short      innerBitOffset;
-    key1Byte = (unsigned char *)key1;
-    key2Byte = (unsigned char *)key2;
+    switch (t->keyMode) {
+    case TABLE_KEYS_VAR:
+        return varBitSet(keyLen, bitOff, key);
+    case TABLE_KEYS_PREFIX:
+        return prefixBitSet(t->keySize, keyLen, bitOff, key);
+    default:
+        return tableBitSet(keyLen, bitOff, key);
+    }
+}
 
-    for (byteOffset = 0; byteOffset < keySize; byteOffset++, key1Byte++, key2Byte++) {
+/* Offset of the most significant set bit in a nonzero byte */
+static unsigned short
+byteLeadingZeros(unsigned char byte)
+{
+    unsigned short      zeros = 0;
 
-        curByte1 = *key1Byte;
-        if (key2)
-            curByte2 = *key2Byte;
-        else
-            curByte2 = 0;
-        curByteMask = 0x80;
+    while (!(byte & 0x80)) {
+        byte <<= 1;
+        zeros++;
+    }
+    return zeros;
+}
 
-        for (innerBitOffset = 0; innerBitOffset < bitsPerByte; innerBitOffset++) {
-            if ((curByte1 & curByteMask) != (curByte2 & curByteMask))
-                return (byteOffset * bitsPerByte) + innerBitOffset;
-            curByteMask >>= 1;
+/*
+ * Offset of the first differing bit in a nonzero XOR of two words loaded
+ * from memory, where bit 0 is the top bit of the lowest-addressed byte
+ */
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define WORD_DIFF_BIT(x) __builtin_clzll(__builtin_bswap64(x))
+#elif defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define WORD_DIFF_BIT(x) __builtin_clzll(x)
+#endif
+
+/*
+ * Compare a word at a time; key2 == NULL compares against the all-zero
+ * key. Without a word-level bit search, a differing word is rescanned
+ * byte by byte.
+ */
+tableBit
+tableFindBitDiff(size_t keySize, const void *key1, const void *key2)
+{
+    const unsigned char *key1Byte = key1, *key2Byte = key2;
+    unsigned char       curByte1, curByte2;
+    uint64_t            curWord1, curWord2 = 0;
+    size_t              byteOffset = 0;
+
+    for (; byteOffset + sizeof(curWord1) <= keySize; byteOffset += sizeof(curWord1)) {
+        memcpy(&curWord1, key1Byte + byteOffset, sizeof(curWord1));
+        if (key2)
+            memcpy(&curWord2, key2Byte + byteOffset, sizeof(curWord2));
+        if (curWord1 != curWord2) {
+#ifdef WORD_DIFF_BIT
+            return byteOffset * bitsPerByte + WORD_DIFF_BIT(curWord1 ^ curWord2);
+#else
+            break;
+#endif
         }
     }
 
+    for (; byteOffset < keySize; byteOffset++) {
+        curByte1 = key1Byte[byteOffset];
+        curByte2 = key2 ? key2Byte[byteOffset] : 0;
+        if (curByte1 != curByte2)
+            return byteOffset * bitsPerByte + byteLeadingZeros(curByte1 ^ curByte2);
+    }
+
     return keySize * bitsPerByte;
 }
 
-static void
-lookupStep(struct nTableNode *node, const void *srchKey, struct nTableNode *parentNode,
-           struct nTableNode **closestOut, struct nTableNode **parentOut)
+/*
+ * findBitDiff for variable-length keys; key2 == NULL with len2 == 0 is the
+ * empty key. The bytes both keys share are compared as fixed-size keys.
+ */
+static tableBit
+varFindBitDiff(const void *key1, size_t len1, const void *key2, size_t len2)
 {
-    short               prevBit;
+    size_t              minLen = len1 < len2 ? len1 : len2;
+    tableBit            diffBit;
 
-    if (parentNode) {
-        prevBit = parentNode->bit;
-    } else {
-        prevBit = -1;
+    diffBit = tableFindBitDiff(minLen, key1, key2);
+    if (diffBit < minLen * bitsPerByte)
+        return diffBit / bitsPerByte * VAR_BITS_PER_BYTE + 1 + diffBit % bitsPerByte;
+    return minLen * VAR_BITS_PER_BYTE;
+}
+
+/* findBitDiff for prefix keys of len1 and len2 bits */
+static tableBit
+prefixFindBitDiff(size_t keySize, const void *key1, size_t len1, const void *key2, size_t len2)
+{
+    size_t              minLen = len1 < len2 ? len1 : len2;
+    tableBit            diffBit;
+
+    diffBit = tableFindBitDiff(keySize, key1, key2);
+    if (diffBit < minLen)
+        return diffBit * PREFIX_BITS_PER_BIT + 1;
+    return minLen * PREFIX_BITS_PER_BIT;
+}
+
+static tableBit
+keyBitDiff(const struct nTable *t, const void *key1, size_t len1, const void *key2, size_t len2)
+{
+    switch (t->keyMode) {
+    case TABLE_KEYS_VAR:
+        return varFindBitDiff(key1, len1, key2, len2);
+    case TABLE_KEYS_PREFIX:
+        return prefixFindBitDiff(t->keySize, key1, len1, key2, len2);
+    default:
+        return tableFindBitDiff(t->keySize, key1, key2);
     }
+}
 
-    if (node->bit > prevBit) {
-        if (bitSet(node->bit, srchKey)) {
-            if (node->r) {
-                lookupStep(node->r, srchKey, node, closestOut, parentOut);
-                return;
-            }
-        } else {
-            if (node->l) {
-                lookupStep(node->l, srchKey, node, closestOut, parentOut);
-                return;
-            }
-        }
+/* Bits of a prefix key past its length are ignored and stored as zero */
+static enum nBool
+nodeKeyDiffers(const struct nTable *t, struct nTableNode *node, const void *key, size_t keyLen)
+{
+    const char         *nodeBytes;
+    size_t              nodeLen;
+
+    if (t->keyMode == TABLE_KEYS_FIXED)
+        return elemDiffer(node->data, key, t->keySize);
+    nodeBytes = nodeKey(t, node, &nodeLen);
+    if (nodeLen != keyLen)
+        return nTrue;
+    if (t->keyMode == TABLE_KEYS_PREFIX)
+        return tableFindBitDiff(t->keySize, nodeBytes, key) < keyLen;
+    return memcmp(nodeBytes, key, keyLen) != 0;
+}
+
+/* Link to follow from node toward srchKey; NULL ends the search */
+static struct nTableNode       *
+nextLink(const struct nTable *t, const struct nTableNode *node, const void *srchKey,
+         size_t keyLen)
+{
+    if (keyBitSet(t, keyLen, node->bit, srchKey))
+        return node->r;
+    return node->l;
+}
+
+/*
+ * Walk down from node toward srchKey until a link points back up the trie
+ * (or is empty). Returns the node reached; parentOut receives the node
+ * whose link led there and grandparentOut the node above that on the path.
+ */
+static struct nTableNode       *
+lookupStep(const struct nTable *t, struct nTableNode *node, const void *srchKey, size_t keyLen,
+           struct nTableNode *parentNode, struct nTableNode **parentOut,
+           struct nTableNode **grandparentOut)
+{
+    struct nTableNode  *grandparentNode = NULL, *nextNode;
+    tableBit            prevBit = parentNode ? parentNode->bit : -1;
+
+    while (tableLinkDown(prevBit, node->bit) && (nextNode = nextLink(t, node, srchKey, keyLen))) {
+        grandparentNode = parentNode;
+        parentNode = node;
+        prevBit = node->bit;
+        node = nextNode;
     }
-    *closestOut = node;
     *parentOut = parentNode;
-    return;
+    *grandparentOut = grandparentNode;
+    return node;
 }
 
+/*
+ * lookupStep from the head that also records the links it follows in
+ * steps, up to INSERT_PATH_DEPTH of them, and their count in numStepsOut
+ */
 static struct nTableNode       *
-insert_step(struct nTable *t, struct nTableNode *node, short diffBit,
-            const void *diffKey, const void *newKey, const void *newItem, short parentBit)
+lookupPath(struct nTable *t, const void *srchKey, size_t keyLen, struct pathStep *steps,
+           size_t *numStepsOut)
 {
-    struct nTableNode  *newLink;
-    short               newBitDiff;
+    struct nTableNode **link = &t->head, *node;
+    tableBit            prevBit = -1;
+    size_t              numSteps = 0;
 
-    if (node->bit > diffBit || node->bit <= parentBit) {
-        newLink = allocNode(t, newKey, newItem, diffBit);
-        if (bitSet(diffBit, newKey)) {
-            newLink->r = newLink;
-            newLink->l = node;
-        } else {
-            newLink->r = node;
-            newLink->l = newLink;
+    for (;;) {
+        node = *link;
+        if (numSteps < INSERT_PATH_DEPTH) {
+            steps[numSteps].link = link;
+            steps[numSteps].parentBit = prevBit;
+            steps[numSteps++].bit = node->bit;
         }
-        return newLink;
-    } else {
-        if (bitSet(node->bit, newKey)) {
-            node->r = insert_step(t, node->r, diffBit, diffKey, newKey, newItem, node->bit);
+        if (!tableLinkDown(prevBit, node->bit))
+            break;
+        link = keyBitSet(t, keyLen, node->bit, srchKey) ? &node->r : &node->l;
+        if (!*link)
+            break;
+        prevBit = node->bit;
+    }
+    *numStepsOut = numSteps;
+    return node;
+}
+
+/*
+ * Link a new node for newKey into the trie at the first link along its
+ * search path that crosses diffBit or points back up the trie, starting
+ * from link, whose owner tests parentBit (-1 for the head)
+ */
+static enum nErrorType
+insert_step(struct nTable *t, tableBit diffBit, const void *newKey, size_t keyLen,
+            const void *newItem, struct nTableNode **link, tableBit parentBit,
+            struct nTableNode **nodeOut)
+{
+    struct nTableNode  *node, *newLink;
+
+    for (;;) {
+        node = *link;
+        if (tableInsertHere(parentBit, node->bit, diffBit)) {
+            if (!(newLink = allocNode(t, newKey, keyLen, newItem, diffBit)))
+                return nCodeNoSpace;
+            TABLE_LINK_NEW(newLink, newLink, node, keyBitSet(t, keyLen, diffBit, newKey));
+            *link = newLink;
+            *nodeOut = newLink;
+            return nCodeSuccess;
+        }
+        parentBit = node->bit;
+        if (keyBitSet(t, keyLen, node->bit, newKey)) {
+            link = &node->r;
+        } else if (node->l) {
+            link = &node->l;
         } else {
-            if (node->l) {
-                node->l = insert_step(t, node->l, diffBit, diffKey, newKey, newItem, node->bit);
-            } else {
-                newBitDiff = findBitDiff(t->keySize, newKey, NULL);
-                newLink = allocNode(t, newKey, newItem, newBitDiff);
-                newLink->r = newLink;
-                newLink->l = NULL;
-                node->l = newLink;
-            }
+            newLink = allocNode(t, newKey, keyLen, newItem,
+                                keyBitDiff(t, newKey, keyLen, NULL, 0));
+            if (!newLink)
+                return nCodeNoSpace;
+            newLink->r = newLink;
+            newLink->l = NULL;
+            node->l = newLink;
+            *nodeOut = newLink;
+            return nCodeSuccess;
         }
-        return node;
     }
 }
 
@@ -148,23 +570,15 @@ static void
 linkSwap(struct nTable *t, struct nTableNode *grandchildLink, struct nTableNode *childLink,
          struct nTableNode *parentLink)
 {
-    memcpy(grandchildLink->key, childLink->key, t->keySize);
-    memcpy(grandchildLink->value, childLink->value, t->valueSize);
-
-    if (parentLink->l == childLink)
-        parentLink->l = grandchildLink;
-    else
-        parentLink->r = grandchildLink;
+    memcpy(grandchildLink->data, childLink->data, tableNodeValueOffset(t) + t->valueSize);
 
-    if (childLink->r == grandchildLink)
-        childLink->r = NULL;
-    else
-        childLink->l = NULL;
+    TABLE_RELINK(parentLink, childLink, grandchildLink);
+    TABLE_RELINK(childLink, grandchildLink, NULL);
 }
 
+/* Splice victimLink out of the trie, given its parent (NULL for the head) */
 static void
-reduceLink(struct nTableNode *node, struct nTableNode *victimLink,
-           const void *targetKey)
+reduceLink(struct nTable *t, struct nTableNode *node, struct nTableNode *victimLink)
 {
     struct nTableNode  *newChild;
 
@@ -173,113 +587,1276 @@ reduceLink(struct nTableNode *node, struct nTableNode *victimLink,
     else
         newChild = victimLink->r;
 
-    if (node->l == victimLink) {
-        node->l = newChild;
-        freeNode(victimLink);
-        return;
-    } else if (node->r == victimLink) {
-        node->r = newChild;
-        freeNode(victimLink);
-        return;
-    }
-    if (bitSet(node->bit, targetKey))
-        reduceLink(node->r, victimLink, targetKey);
+    if (!node)
+        t->head = newChild;
     else
-        reduceLink(node->l, victimLink, targetKey);
-}
-
-/* API functions */
-
-void
-nTableInit(struct nTable *t, size_t keySize, size_t valueSize)
-{
-    t->head = NULL;
-    t->numElems = 0;
-    t->keySize = keySize;
-    t->valueSize = valueSize;
+        TABLE_RELINK(node, victimLink, newChild);
+    freeNode(t, victimLink);
 }
 
-enum nErrorType
-nTableInsert(struct nTable *t, const void *key, const void *dataIn)
+/*
+ * Find the node holding key, or add one with the value dataIn (zeroed if
+ * dataIn is NULL). addedOut tells which happened. The lookup remembers
+ * its path, and the new node goes in below the last link on it that does
+ * not yet cross the differing bit, so the trie is descended only once.
+ * Like the remove and lookup helpers below, this serves both the
+ * fixed-size and the variable-length key calls: keys are keySize bytes
+ * long in a fixed-size table and at least one byte long in a
+ * variable-length one.
+ */
+static enum nErrorType
+addKey(struct nTable *t, const void *key, size_t keyLen, const void *dataIn,
+       struct nTableNode **nodeOut, enum nBool *addedOut)
 {
-    struct nTableNode  *closestOut, *parentOut, *newNode;
-    short               tgtBit;
+    struct nTableNode  *closestOut, *newNode;
+    struct pathStep     steps[INSERT_PATH_DEPTH];
+    const char         *closestKey;
+    size_t              closestLen, numSteps, i;
+    tableBit            tgtBit;
 
+    *addedOut = nFalse;
     if (t->head) {
 
-        lookupStep(t->head, key, NULL, &closestOut, &parentOut);
-        if (!memcmp(closestOut->key, key, t->keySize)) {
-            memcpy(closestOut->value, dataIn, t->valueSize);
+        closestOut = lookupPath(t, key, keyLen, steps, &numSteps);
+        if (!nodeKeyDiffers(t, closestOut, key, keyLen)) {
+            *nodeOut = closestOut;
             return nCodeSuccess;
         }
-        tgtBit = findBitDiff(t->keySize, key, closestOut->key);
-        t->head = insert_step(t, t->head, tgtBit, closestOut->key, key, dataIn, -1);
+        closestKey = nodeKey(t, closestOut, &closestLen);
+        tgtBit = keyBitDiff(t, key, keyLen, closestKey, closestLen);
+        for (i = 0; i + 1 < numSteps; i++) {
+            if (tableInsertHere(steps[i].parentBit, steps[i].bit, tgtBit))
+                break;
+        }
+        if (insert_step(t, tgtBit, key, keyLen, dataIn, steps[i].link, steps[i].parentBit, nodeOut))
+            return nCodeNoSpace;
 
     } else {
-        tgtBit = findBitDiff(t->keySize, key, NULL);
-        newNode = allocNode(t, key, dataIn, tgtBit);
+        tgtBit = keyBitDiff(t, key, keyLen, NULL, 0);
+        if (!(newNode = allocNode(t, key, keyLen, dataIn, tgtBit)))
+            return nCodeNoSpace;
         newNode->r = newNode;
         newNode->l = NULL;
         t->head = newNode;
+        *nodeOut = newNode;
     }
 
     t->numElems++;
+    *addedOut = nTrue;
     return nCodeSuccess;
 }
 
-enum nErrorType
-nTableRemove(struct nTable *t, const void *key)
+static enum nErrorType
+insertKey(struct nTable *t, const void *key, size_t keyLen, const void *dataIn)
+{
+    struct nTableNode  *node;
+    enum nBool          added;
+
+    if (addKey(t, key, keyLen, dataIn, &node, &added))
+        return nCodeNoSpace;
+    if (!added)
+        elemCopy(tableNodeValue(t, node), dataIn, t->valueSize);
+    return nCodeSuccess;
+}
+
+/* Shared by the upserts: a value just added starts zeroed */
+static void
+upsertValue(void *value, enum nBool added, nTableValueFunc initFunc, nTableValueFunc updateFunc)
+{
+    if (added && initFunc)
+        initFunc(value);
+    if (updateFunc)
+        updateFunc(value);
+}
+
+static enum nErrorType
+removeKey(struct nTable *t, const void *key, size_t keyLen)
 {
-    struct nTableNode  *closestOut, *parentOut, *parentOut2, *grandParentOut;
+    struct nTableNode  *closestOut, *parentOut, *grandparentOut, *linkOwner, *unused;
+    const char         *parentKey;
+    size_t              parentLen;
 
     if (!t->head)
         return nCodeNotFound;
 
-    lookupStep(t->head, key, NULL, &closestOut, &parentOut);
+    closestOut = lookupStep(t, t->head, key, keyLen, NULL, &parentOut, &grandparentOut);
 
-    if (memcmp(closestOut->key, key, t->keySize))
+    if (nodeKeyDiffers(t, closestOut, key, keyLen))
         return nCodeNotFound;
 
-    lookupStep(t->head, parentOut->key, NULL, &parentOut2, &grandParentOut);
-
+    /* key may be the victim's own key buffer, so it is not read past here */
+    freeNodeKey(t, closestOut);
     if (parentOut == closestOut) {
-        if (parentOut->l == closestOut)
-            parentOut->l = NULL;
-        else
-            parentOut->r = NULL;
-
-        if (closestOut == t->head) {
-            if (closestOut->l)
-                t->head = closestOut->l;
-            else
-                t->head = closestOut->r;
-            freeNode(closestOut);
-        } else
-            reduceLink(t->head, closestOut, key);
+        /* The node refers to its own key; drop that link and splice it out */
+        TABLE_RELINK(parentOut, closestOut, NULL);
+        reduceLink(t, grandparentOut, closestOut);
     } else {
-        linkSwap(t, closestOut, parentOut, grandParentOut);
-        reduceLink(t->head, parentOut, key);
+        /*
+         * Move the parent's entry into the victim node and splice out the
+         * parent instead. The link that refers to the parent's key lies
+         * below the parent, so that search can start there.
+         */
+        parentKey = nodeKey(t, parentOut, &parentLen);
+        lookupStep(t, parentOut, parentKey, parentLen, grandparentOut, &linkOwner, &unused);
+        linkSwap(t, closestOut, parentOut, linkOwner);
+        reduceLink(t, grandparentOut, parentOut);
     }
 
     t->numElems--;
     return nCodeSuccess;
 }
 
-enum nErrorType
-nTablePeek(struct nTable *tab, const void *key, void *dataOut)
+/* The node holding key, or NULL if the key is absent */
+static struct nTableNode       *
+findKey(struct nTable *t, const void *key, size_t keyLen)
+{
+    struct nTableNode  *closestOut, *parentOut, *grandparentOut;
+
+    if (!t->head)
+        return NULL;
+
+    closestOut = lookupStep(t, t->head, key, keyLen, NULL, &parentOut, &grandparentOut);
+    if (nodeKeyDiffers(t, closestOut, key, keyLen))
+        return NULL;
+    return closestOut;
+}
+
+static enum nErrorType
+peekKey(struct nTable *t, const void *key, size_t keyLen, void *dataOut)
+{
+    struct nTableNode  *node;
+
+    if (!(node = findKey(t, key, keyLen)))
+        return nCodeNotFound;
+    elemCopy(dataOut, tableNodeValue(t, node), t->valueSize);
+    return nCodeSuccess;
+}
+
+/*
+ * Check a key passed to one of the variable-length calls. A fixed-size
+ * table accepts them for keys of exactly keySize bytes.
+ */
+static enum nErrorType
+checkVarKey(const struct nTable *t, size_t keyLen)
 {
-    struct nTableNode  *closestOut, *parentOut;
+    switch (t->keyMode) {
+    case TABLE_KEYS_VAR:
+        return keyLen <= VAR_KEY_MAX ? nCodeSuccess : nCodeBadInput;
+    case TABLE_KEYS_PREFIX:
+        return nCodeBadInput;
+    default:
+        return keyLen == t->keySize ? nCodeSuccess : nCodeBadInput;
+    }
+}
+
+/*
+ * The zero-length key of a variable-length key table, and the zero-length
+ * prefix of a prefix table, is kept apart from the trie in nullKey
+ */
+static enum nErrorType
+nullKeyAdd(struct nTable *t, enum nBool *addedOut)
+{
+    *addedOut = nFalse;
+    if (!t->nullKey) {
+        if (!(t->nullKey = calloc(1, t->valueSize ? t->valueSize : 1)))
+            return nCodeNoSpace;
+        t->numElems++;
+        *addedOut = nTrue;
+    }
+    return nCodeSuccess;
+}
+
+static enum nErrorType
+nullKeyInsert(struct nTable *t, const void *dataIn)
+{
+    enum nBool          added;
+
+    if (nullKeyAdd(t, &added))
+        return nCodeNoSpace;
+    memcpy(t->nullKey, dataIn, t->valueSize);
+    return nCodeSuccess;
+}
 
-    if (!tab->head)
+static enum nErrorType
+nullKeyPeek(struct nTable *t, void *dataOut)
+{
+    if (!t->nullKey)
         return nCodeNotFound;
+    memcpy(dataOut, t->nullKey, t->valueSize);
+    return nCodeSuccess;
+}
 
-    lookupStep(tab->head, key, NULL, &closestOut, &parentOut);
-    if (memcmp(closestOut->key, key, tab->keySize)) {
+static enum nErrorType
+nullKeyRemove(struct nTable *t)
+{
+    if (!t->nullKey)
         return nCodeNotFound;
+    free(t->nullKey);
+    t->nullKey = NULL;
+    t->numElems--;
+    return nCodeSuccess;
+}
+
+/*
+ * Call fixedFunc or varFunc on every entry, in no particular order.
+ * Removing an entry can move another entry into a different node, so the
+ * keys of entries that the callback asks to remove are queued and removed
+ * once the walk is complete. A fixed-size key is queued by value; a
+ * variable-length key keeps its buffer until it is removed, so its
+ * reference is queued instead.
+ */
+static void
+forEachEntry(struct nTable *t, nTableIterFunc fixedFunc, nTableVarIterFunc varFunc)
+{
+    struct nStack       pending;
+    struct nTableNode  *localBuf[WALK_LOCAL_DEPTH], *node;
+    struct nDeque       victims;
+    struct nTableVarKey ref;
+    enum nBool          removeNullKey = nFalse, removeIt;
+    uint32_t            prefixBits;
+    char               *key, *victimKey;
+    size_t              keyLen;
+
+    if (t->nullKey && varFunc(t->nullKey, 0, t->nullKey))
+        removeNullKey = nTrue;
+
+    if (t->head && !walkInit(t, &pending, localBuf)) {
+        nDequeInit(&victims, tableKeySlotSize(t));
+        while ((node = walkNext(&pending))) {
+            key = nodeKey(t, node, &keyLen);
+            if (fixedFunc)
+                removeIt = fixedFunc(key, tableNodeValue(t, node));
+            else
+                removeIt = varFunc(key, keyLen, tableNodeValue(t, node));
+            if (removeIt)
+                nDequeInsertTail(&victims, node->data);
+        }
+        nStackDestroy(&pending);
+
+        if (!nDequeEmpty(&victims) && (victimKey = malloc(tableKeySlotSize(t)))) {
+            while (!nDequeRemoveHead(&victims, victimKey)) {
+                if (t->keyMode == TABLE_KEYS_VAR) {
+                    memcpy(&ref, victimKey, sizeof(ref));
+                    removeKey(t, ref.bytes, ref.len);
+                } else if (t->keyMode == TABLE_KEYS_PREFIX) {
+                    memcpy(&prefixBits, victimKey + t->keySize, sizeof(prefixBits));
+                    removeKey(t, victimKey, prefixBits);
+                } else {
+                    removeKey(t, victimKey, t->keySize);
+                }
+            }
+            free(victimKey);
+        }
+        nDequeDestroy(&victims);
+    }
+
+    if (removeNullKey)
+        nullKeyRemove(t);
+}
+
+/*
+ * Ordered traversal. Each key sits at the one link that points back up to
+ * its node (or is a node's link to itself), and those links appear in key
+ * order in an in-order walk over the downward links. A cursor's path stack
+ * holds the nodes whose right link the walk has still to visit.
+ */
+
+/* Point the cursor at the entry of a node, or of nullKey for NULL */
+static void
+cursorSet(struct nTableCursor *c, struct nTableNode *node)
+{
+    c->atNullKey = node ? nFalse : nTrue;
+    if (node) {
+        c->key = nodeKey(c->t, node, &c->keyLen);
+        c->value = tableNodeValue(c->t, node);
     } else {
-        memcpy(dataOut, closestOut->value, tab->valueSize);
+        c->key = c->t->nullKey;
+        c->keyLen = 0;
+        c->value = c->t->nullKey;
+    }
+}
+
+/*
+ * Descend along left links from link, queueing each node passed. Returns
+ * the node of the first key below link, or NULL for an empty link.
+ */
+static struct nTableNode       *
+pushLeftChain(struct nTableCursor *c, struct nTableNode *link, tableBit parentBit)
+{
+    while (link && link->bit > parentBit) {
+        nStackPush(&c->path, &link);
+        parentBit = link->bit;
+        link = link->l;
+    }
+    return link;
+}
+
+/* Move to the next key of the walk; nCodeNotFound once the path is empty */
+static enum nErrorType
+cursorAdvance(struct nTableCursor *c)
+{
+    struct nTableNode  *node, *target;
+
+    while (!nStackPop(&c->path, &node)) {
+        if ((target = pushLeftChain(c, node->r, node->bit))) {
+            cursorSet(c, target);
+            return nCodeSuccess;
+        }
+    }
+    return nCodeNotFound;
+}
+
+/* Start a walk at the first key of the subtrie below link */
+static enum nErrorType
+cursorStart(struct nTableCursor *c, struct nTableNode *link, tableBit parentBit)
+{
+    struct nTableNode  *target;
+
+    if ((target = pushLeftChain(c, link, parentBit))) {
+        cursorSet(c, target);
+        return nCodeSuccess;
+    }
+    return cursorAdvance(c);
+}
+
+/*
+ * Position the cursor at the first key not less than key. All keys below
+ * a link agree with each other up to the link's bit, so the search stops
+ * at the first link past the bit where key leaves the trie; key then sorts
+ * before or after that whole subtrie depending on that bit.
+ */
+static enum nErrorType
+cursorSeek(struct nTableCursor *c, const void *key, size_t keyLen)
+{
+    struct nTable      *t = c->t;
+    struct nTableNode  *closestOut, *parentOut, *grandparentOut, *link, *node;
+    const char         *closestKey;
+    size_t              closestLen;
+    tableBit            diffBit = TABLE_BIT_MAX, parentBit = -1;
+    enum nBool          found;
+
+    if (!t->head)
+        return nCodeNotFound;
+
+    closestOut = lookupStep(t, t->head, key, keyLen, NULL, &parentOut, &grandparentOut);
+    if (!(found = !nodeKeyDiffers(t, closestOut, key, keyLen))) {
+        closestKey = nodeKey(t, closestOut, &closestLen);
+        diffBit = keyBitDiff(t, key, keyLen, closestKey, closestLen);
+    }
+
+    link = t->head;
+    while (link && link->bit > parentBit && link->bit < diffBit) {
+        node = link;
+        if (keyBitSet(t, keyLen, node->bit, key)) {
+            link = node->r;
+        } else {
+            nStackPush(&c->path, &node);
+            link = node->l;
+        }
+        parentBit = node->bit;
+    }
+
+    if (found) {
+        cursorSet(c, link);
         return nCodeSuccess;
     }
+    if (!keyBitSet(t, keyLen, diffBit, key))
+        return cursorStart(c, link, parentBit);
+    return cursorAdvance(c);
+}
+
+static int
+keyCompare(const struct nTable *t, const void *key1, size_t len1, const void *key2, size_t len2)
+{
+    int                 cmp;
+
+    if (t->keyMode == TABLE_KEYS_FIXED)
+        return memcmp(key1, key2, t->keySize);
+    if ((cmp = memcmp(key1, key2, len1 < len2 ? len1 : len2)))
+        return cmp;
+    return (len1 > len2) - (len1 < len2);
+}
+
+/* Cursor whose path stack lives in the caller's localBuf when it fits */
+static enum nErrorType
+cursorInit(struct nTable *t, struct nTableCursor *c, struct nTableNode **localBuf)
+{
+    c->t = t;
+    c->atNullKey = nFalse;
+    nStackInit(&c->path, NULL, 0, sizeof(t->head));
+    return pathInit(t, &c->path, localBuf);
+}
+
+static enum nBool
+callIter(const struct nTableCursor *c, nTableIterFunc fixedFunc, nTableVarIterFunc varFunc)
+{
+    if (fixedFunc)
+        return fixedFunc(c->key, c->value);
+    return varFunc(c->key, c->keyLen, c->value);
+}
+
+/* Call a callback on keys from lo through hi in order, until it returns nTrue */
+static enum nErrorType
+rangeScan(struct nTable *t, const void *lo, size_t loLen, const void *hi, size_t hiLen,
+          nTableIterFunc fixedFunc, nTableVarIterFunc varFunc)
+{
+    struct nTableCursor c;
+    struct nTableNode  *localBuf[WALK_LOCAL_DEPTH];
+    enum nErrorType     ret;
+
+    if (cursorInit(t, &c, localBuf))
+        return nCodeNoSpace;
+    if (t->keyMode == TABLE_KEYS_VAR && !loLen && t->nullKey) {
+        cursorSet(&c, NULL);
+        ret = nCodeSuccess;
+    } else {
+        ret = cursorSeek(&c, lo, loLen);
+    }
+    while (!ret && keyCompare(t, c.key, c.keyLen, hi, hiLen) <= 0) {
+        if (callIter(&c, fixedFunc, varFunc))
+            break;
+        ret = c.atNullKey ? cursorStart(&c, t->head, -1) : cursorAdvance(&c);
+    }
+    nStackDestroy(&c.path);
+    return nCodeSuccess;
+}
+
+/*
+ * Call a callback in order on keys whose first prefixBits bits match
+ * prefix. The search follows prefix down to the first link past
+ * prefixBits; every key below it matches if its first key does.
+ */
+static enum nErrorType
+prefixScan(struct nTable *t, const void *prefix, size_t prefixBits,
+           nTableIterFunc fixedFunc, nTableVarIterFunc varFunc)
+{
+    struct nTableCursor c;
+    struct nTableNode  *localBuf[WALK_LOCAL_DEPTH], *link = t->head, *node;
+    size_t              prefixLen = (prefixBits + bitsPerByte - 1) / bitsPerByte;
+    size_t              searchBits = prefixBits;
+    tableBit            parentBit = -1;
+    enum nBool          matched;
+    enum nErrorType     ret;
+
+    if (t->keyMode == TABLE_KEYS_VAR) {
+        if (prefixLen > VAR_KEY_MAX)
+            return nCodeBadInput;
+        searchBits = prefixBits / bitsPerByte * VAR_BITS_PER_BYTE;
+        if (prefixBits % bitsPerByte)
+            searchBits += 1 + prefixBits % bitsPerByte;
+    } else if (prefixLen > t->keySize) {
+        return nCodeBadInput;
+    }
+
+    if (cursorInit(t, &c, localBuf))
+        return nCodeNoSpace;
+    if (!prefixBits && t->nullKey && varFunc(t->nullKey, 0, t->nullKey)) {
+        nStackDestroy(&c.path);
+        return nCodeSuccess;
+    }
+
+    while (link && link->bit > parentBit && link->bit < searchBits) {
+        node = link;
+        link = nextLink(t, node, prefix, prefixLen);
+        parentBit = node->bit;
+    }
+
+    if (!(ret = cursorStart(&c, link, parentBit))) {
+        if (t->keyMode == TABLE_KEYS_VAR)
+            matched = varFindBitDiff(prefix, prefixLen, c.key, c.keyLen) >= searchBits;
+        else
+            matched = tableFindBitDiff(prefixLen, prefix, c.key) >= searchBits;
+        if (!matched)
+            ret = nCodeNotFound;
+    }
+    while (!ret) {
+        if (callIter(&c, fixedFunc, varFunc))
+            break;
+        ret = cursorAdvance(&c);
+    }
+    nStackDestroy(&c.path);
+    return nCodeSuccess;
+}
+
+static size_t
+fileValueOffset(size_t keySize)
+{
+    return tableValueOffset(offsetof(struct tableFileNode, data), keySize, TABLE_FILE_VALUE_ALIGN);
+}
+
+/* Records stay aligned for their 64-bit links */
+static size_t
+fileRecordSize(size_t keySize, size_t valueSize)
+{
+    size_t              align = sizeof(int64_t);
+
+    return (offsetof(struct tableFileNode, data) + fileValueOffset(keySize) + valueSize + align - 1)
+        / align * align;
+}
+
+/*
+ * Record of the ancestor with the given bit among pathRecs[0..depth],
+ * whose bits increase from the head down
+ */
+static struct tableFileNode    *
+findPathRecord(struct tableFileNode **pathRecs, size_t depth, tableBit bit)
+{
+    size_t              lo = 0, hi = depth, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (pathRecs[mid]->bit < bit)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return pathRecs[lo];
+}
+
+/*
+ * Write every node to records, depth first. A back link points to a node
+ * on the path from the head, whose record is already written; a downward
+ * link is filled in when the walk reaches the child.
+ */
+static void
+saveNodes(const struct nTable *t, char *records, struct nStack *pending,
+          struct tableFileNode **pathRecs)
+{
+    struct saveEntry    entry = {t->head, 0, NULL, 0}, child;
+    struct tableFileNode *rec;
+    struct nTableNode  *link;
+    size_t              recSize = fileRecordSize(t->keySize, t->valueSize);
+    int64_t            *field;
+
+    nStackPush(pending, &entry);
+    for (rec = (struct tableFileNode *)records; !nStackPop(pending, &entry);
+         rec = (struct tableFileNode *)((char *)rec + recSize)) {
+        if (entry.parent)
+            *(entry.side ? &entry.parent->r : &entry.parent->l) = (char *)rec - (char *)entry.parent;
+        rec->bit = entry.node->bit;
+        memcpy(rec->data, entry.node->data, t->keySize);
+        memcpy(rec->data + fileValueOffset(t->keySize), tableNodeValue(t, entry.node), t->valueSize);
+        pathRecs[entry.depth] = rec;
+
+        /* Push the right child first so that the left one comes next */
+        for (child.side = 1; child.side >= 0; child.side--) {
+            link = child.side ? entry.node->r : entry.node->l;
+            field = child.side ? &rec->r : &rec->l;
+            if (!link) {
+                *field = TABLE_FILE_NO_LINK;
+            } else if (link->bit > entry.node->bit) {
+                child.node = link;
+                child.depth = entry.depth + 1;
+                child.parent = rec;
+                nStackPush(pending, &child);
+            } else {
+                *field = (char *)findPathRecord(pathRecs, entry.depth, link->bit) - (char *)rec;
+            }
+        }
+    }
+}
+
+/*
+ * Check every link of the numElems records of a mapped snapshot: each
+ * must be empty or land on the start of a record in the file, so that
+ * lookups never leave the mapping
+ */
+static enum nBool
+mappedLinksValid(const char *records, size_t numElems, size_t recordSize)
+{
+    const struct tableFileNode *rec;
+    int64_t             link, before, after;
+    size_t              i;
+    int                 side;
+
+    for (i = 0; i < numElems; i++) {
+        rec = (const struct tableFileNode *)(records + i * recordSize);
+        before = (int64_t)(i * recordSize);
+        after = (int64_t)((numElems - i) * recordSize);
+        for (side = 0; side < 2; side++) {
+            link = side ? rec->r : rec->l;
+            if (link == TABLE_FILE_NO_LINK)
+                continue;
+            if (link < -before || link >= after || link % (int64_t)recordSize)
+                return nFalse;
+        }
+    }
+    return nTrue;
+}
+
+/*
+ * The value of key in a mapped snapshot, following the links of its
+ * records, or NULL if the key is absent
+ */
+static char                    *
+mappedValue(const struct nTable *t, const void *key)
+{
+    const struct tableFileNode *node;
+    tableBit            prevBit = -1;
+    int64_t             link;
+
+    if (!t->numElems)
+        return NULL;
+
+    node = (const struct tableFileNode *)((const char *)t->mapping + sizeof(struct tableFileHeader));
+    while (node->bit > prevBit) {
+        link = tableBitSet(t->keySize, node->bit, key) ? node->r : node->l;
+        if (link == TABLE_FILE_NO_LINK)
+            break;
+        prevBit = node->bit;
+        node = (const struct tableFileNode *)((const char *)node + link);
+    }
+    if (elemDiffer(node->data, key, t->keySize))
+        return NULL;
+    return (char *)node->data + fileValueOffset(t->keySize);
+}
+
+/* API functions */
+
+enum nErrorType
+nTableInit(struct nTable *t, size_t keySize, size_t valueSize)
+{
+    return nTableInitPool(t, keySize, valueSize, 0);
+}
+
+/*
+ * Carve nodes out of slabs of nodesPerSlab nodes each; 0 means plain
+ * malloc. Keys may be up to FIXED_KEY_MAX bytes, some 256 MB.
+ */
+enum nErrorType
+nTableInitPool(struct nTable *t, size_t keySize, size_t valueSize, size_t nodesPerSlab)
+{
+    if (keySize > FIXED_KEY_MAX)
+        return nCodeBadInput;
+    t->head = NULL;
+    t->numElems = 0;
+    t->keySize = keySize;
+    t->valueSize = valueSize;
+    t->nullKey = NULL;
+    t->keyMode = TABLE_KEYS_FIXED;
+    t->mapping = NULL;
+    t->mappingSize = 0;
+    nPoolInit(&t->pool, nodeSize(keySize, valueSize), nodesPerSlab);
+    return nCodeSuccess;
+}
+
+/*
+ * Keys of any length up to VAR_KEY_MAX bytes, some 200 MB, passed to the
+ * *Var calls. Each key is stored in its own allocation, so a table of
+ * short keys does not pay for the longest one.
+ */
+enum nErrorType
+nTableInitVar(struct nTable *t, size_t valueSize, size_t nodesPerSlab)
+{
+    nTableInitPool(t, 0, valueSize, 0);
+    t->keyMode = TABLE_KEYS_VAR;
+    nPoolInit(&t->pool, nodeSize(sizeof(struct nTableVarKey), valueSize), nodesPerSlab);
+    return nCodeSuccess;
+}
+
+/*
+ * Keys of keySize bytes stored with a prefix length in bits, for
+ * longest-prefix matching. Bits of a key past its prefix length are
+ * ignored.
+ */
+enum nErrorType
+nTableInitPrefix(struct nTable *t, size_t keySize, size_t valueSize, size_t nodesPerSlab)
+{
+    if (keySize > PREFIX_KEY_MAX)
+        return nCodeBadInput;
+    nTableInitPool(t, keySize, valueSize, 0);
+    t->keyMode = TABLE_KEYS_PREFIX;
+    nPoolInit(&t->pool, nodeSize(keySize + sizeof(uint32_t), valueSize), nodesPerSlab);
+    return nCodeSuccess;
+}
+
+void
+nTableDestroy(struct nTable *t)
+{
+    if (t->head && (t->keyMode == TABLE_KEYS_VAR || !t->pool.nodesPerSlab))
+        freeAllNodes(t);
+    if (t->pool.nodesPerSlab)
+        nPoolRelease(&t->pool);
+    if (t->mapping)
+        munmap(t->mapping, t->mappingSize);
+    t->mapping = NULL;
+    free(t->nullKey);
+    t->nullKey = NULL;
+    t->head = NULL;
+    t->numElems = 0;
+    if (t->keyMode == TABLE_KEYS_VAR)
+        t->keySize = 0;
+}
+
+enum nErrorType
+nTableInsert(struct nTable *t, const void *key, const void *dataIn)
+{
+    if (t->keyMode != TABLE_KEYS_FIXED)
+        return nCodeBadInput;
+    return insertKey(t, key, t->keySize, dataIn);
+}
+
+enum nErrorType
+nTableRemove(struct nTable *t, const void *key)
+{
+    if (t->keyMode != TABLE_KEYS_FIXED)
+        return nCodeBadInput;
+    return removeKey(t, key, t->keySize);
+}
+
+enum nErrorType
+nTablePeek(struct nTable *tab, const void *key, void *dataOut)
+{
+    char               *value;
+
+    if (tab->keyMode == TABLE_KEYS_MAPPED) {
+        if (!(value = mappedValue(tab, key)))
+            return nCodeNotFound;
+        elemCopy(dataOut, value, tab->valueSize);
+        return nCodeSuccess;
+    }
+    if (tab->keyMode != TABLE_KEYS_FIXED)
+        return nCodeBadInput;
+    return peekKey(tab, key, tab->keySize, dataOut);
+}
+
+/*
+ * Zero-copy access to the value of key in a fixed-size key table: valueOut
+ * receives a pointer to the value stored in the table, aligned for any
+ * scalar type up to double whatever the key size. Inserts leave the
+ * value in place, so the pointer stays valid until the next remove of any
+ * key (which can move another entry into the victim's node), or until the
+ * table is destroyed. The value of a mapped snapshot must not be written.
+ */
+enum nErrorType
+nTableGetRef(struct nTable *t, const void *key, void **valueOut)
+{
+    struct nTableNode  *node;
+
+    if (t->keyMode == TABLE_KEYS_MAPPED)
+        return (*valueOut = mappedValue(t, key)) ? nCodeSuccess : nCodeNotFound;
+    if (t->keyMode != TABLE_KEYS_FIXED)
+        return nCodeBadInput;
+    if (!(node = findKey(t, key, t->keySize)))
+        return nCodeNotFound;
+    *valueOut = tableNodeValue(t, node);
+    return nCodeSuccess;
+}
+
+/*
+ * Get or insert in one descent of the trie: if key is absent it is added
+ * with a zeroed value and initFunc, unless NULL, sets the value up; then
+ * updateFunc, unless NULL, modifies the value in place. Neither function
+ * may change the table.
+ */
+enum nErrorType
+nTableUpsert(struct nTable *t, const void *key, nTableValueFunc initFunc,
+             nTableValueFunc updateFunc)
+{
+    struct nTableNode  *node;
+    enum nBool          added;
+
+    if (t->keyMode != TABLE_KEYS_FIXED)
+        return nCodeBadInput;
+    if (addKey(t, key, t->keySize, NULL, &node, &added))
+        return nCodeNoSpace;
+    upsertValue(tableNodeValue(t, node), added, initFunc, updateFunc);
+    return nCodeSuccess;
+}
+
+/*
+ * nTableGetRef that adds key, with its value zeroed, when it is absent, so
+ * the value can be filled in place. The pointer stays valid as for
+ * nTableGetRef.
+ */
+enum nErrorType
+nTableUpsertSlot(struct nTable *t, const void *key, void **valueOut)
+{
+    struct nTableNode  *node;
+    enum nBool          added;
+
+    if (t->keyMode != TABLE_KEYS_FIXED)
+        return nCodeBadInput;
+    if (addKey(t, key, t->keySize, NULL, &node, &added))
+        return nCodeNoSpace;
+    *valueOut = tableNodeValue(t, node);
+    return nCodeSuccess;
+}
+
+/*
+ * Fill an empty fixed-size key table from numElems contiguous keys in
+ * strictly ascending byte order and the values that go with them, in one
+ * pass and without searching. Node i tests the first bit where key i
+ * differs from key i - 1 (key 0 from the all-zero key, as on insert), and
+ * the nodes form a Cartesian tree on those bits: the stack holds the
+ * nodes along the right edge of the trie built so far. A missing left
+ * child links back to node i - 1 and a missing right child to node i
+ * itself, so the trie is complete after every step. A pooled table takes
+ * all the nodes from one slab. Returns nCodeBadInput, leaving the table
+ * empty, when the keys are out of order or repeated.
+ */
+enum nErrorType
+nTableBuildSorted(struct nTable *t, const void *keys, const void *values, size_t numElems)
+{
+    struct nStack       rightEdge;
+    struct nTableNode  *localBuf[WALK_LOCAL_DEPTH], *node, *prev = NULL, *top, *popped;
+    const char         *key = keys, *prevKey = NULL, *value = values;
+    enum nErrorType     ret = nCodeSuccess;
+    tableBit            bit;
+    size_t              i;
+
+    if (t->keyMode != TABLE_KEYS_FIXED || t->head)
+        return nCodeBadInput;
+    if (!numElems)
+        return nCodeSuccess;
+    if (nPoolReserve(&t->pool, numElems))
+        return nCodeNoSpace;
+
+    /* pathInit sizes the stack by numElems */
+    t->numElems = numElems;
+    if (pathInit(t, &rightEdge, localBuf)) {
+        t->numElems = 0;
+        return nCodeNoSpace;
+    }
+    for (i = 0; i < numElems; i++, prevKey = key, key += t->keySize, value += t->valueSize) {
+        bit = tableFindBitDiff(t->keySize, key, prevKey);
+        if (prevKey && tableBitSet(t->keySize, bit, prevKey)) {
+            ret = nCodeBadInput;
+            break;
+        }
+        if (!(node = allocNode(t, key, t->keySize, value, bit))) {
+            ret = nCodeNoSpace;
+            break;
+        }
+
+        for (popped = NULL; !nStackPeek(&rightEdge, &top) && top->bit > bit;)
+            nStackPop(&rightEdge, &popped);
+        node->l = popped ? popped : prev;
+        node->r = node;
+        if (nStackEmpty(&rightEdge))
+            t->head = node;
+        else
+            top->r = node;
+        nStackPush(&rightEdge, &node);
+        prev = node;
+    }
+    nStackDestroy(&rightEdge);
+
+    if (ret) {
+        t->numElems = i;
+        nTableDestroy(t);
+    }
+    return ret;
+}
+
+/*
+ * Write a fixed-size key table to fd as a snapshot for nTableMapReadOnly,
+ * replacing what the file held. fd must be open for reading and writing,
+ * since the file is filled through a mapping; it is up to the caller to
+ * fsync. Returns nCodeNoSpace when the file cannot be sized or mapped,
+ * with errno telling why.
+ */
+enum nErrorType
+nTableSave(struct nTable *t, int fd)
+{
+    struct tableFileHeader header;
+    struct tableFileNode **pathRecs;
+    struct nStack       pending;
+    size_t              fileSize;
+    char               *map;
+    enum nErrorType     ret = nCodeNoSpace;
+
+    if (t->keyMode != TABLE_KEYS_FIXED)
+        return nCodeBadInput;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TABLE_FILE_MAGIC, sizeof(header.magic));
+    header.byteOrder = TABLE_FILE_BYTE_ORDER;
+    header.version = TABLE_FILE_VERSION;
+    header.numElems = t->numElems;
+    header.keySize = t->keySize;
+    header.valueSize = t->valueSize;
+    header.recordSize = fileRecordSize(t->keySize, t->valueSize);
+    fileSize = sizeof(header) + t->numElems * header.recordSize;
+
+    if (nStackInitM(&pending, walkDepth(t), sizeof(struct saveEntry)))
+        return nCodeNoSpace;
+    if ((pathRecs = malloc(walkDepth(t) * sizeof(*pathRecs))) && !ftruncate(fd, (off_t)fileSize)
+        && (map = mmap(NULL, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) != MAP_FAILED) {
+        memcpy(map, &header, sizeof(header));
+        if (t->head)
+            saveNodes(t, map + sizeof(header), &pending, pathRecs);
+        munmap(map, fileSize);
+        ret = nCodeSuccess;
+    }
+    free(pathRecs);
+    nStackDestroy(&pending);
+    return ret;
+}
+
+/*
+ * Map a snapshot written by nTableSave into t, which need not be
+ * initialized. nTablePeek searches the file where it is mapped, with no
+ * parsing or allocation; pages are read in as lookups touch them. The
+ * table is read-only: other calls that change or walk it fail or find
+ * nothing. nTableDestroy unmaps the file. Returns nCodeNotFound when the
+ * file cannot be opened and nCodeBadInput when it is not a snapshot or a
+ * link in it points outside its records; mapping checks every record once.
+ */
+enum nErrorType
+nTableMapReadOnly(struct nTable *t, const char *path)
+{
+    struct tableFileHeader header;
+    struct stat         st;
+    size_t              fileSize;
+    void               *map;
+    int                 fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return nCodeNotFound;
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(header)) {
+        close(fd);
+        return nCodeBadInput;
+    }
+    fileSize = st.st_size;
+    map = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return nCodeNoSpace;
+
+    memcpy(&header, map, sizeof(header));
+    if (memcmp(header.magic, TABLE_FILE_MAGIC, sizeof(header.magic))
+        || header.byteOrder != TABLE_FILE_BYTE_ORDER || header.version != TABLE_FILE_VERSION
+        || header.keySize > FIXED_KEY_MAX || header.valueSize > fileSize
+        || header.recordSize != fileRecordSize(header.keySize, header.valueSize)
+        || (fileSize - sizeof(header)) % header.recordSize
+        || (fileSize - sizeof(header)) / header.recordSize != header.numElems
+        || !mappedLinksValid((char *)map + sizeof(header), header.numElems, header.recordSize)) {
+        munmap(map, fileSize);
+        return nCodeBadInput;
+    }
+
+    nTableInitPool(t, header.keySize, header.valueSize, 0);
+    t->keyMode = TABLE_KEYS_MAPPED;
+    t->numElems = header.numElems;
+    t->mapping = map;
+    t->mappingSize = fileSize;
+    return nCodeSuccess;
+}
+
+/* The zero-length key is kept apart from the trie, in nullKey */
+enum nErrorType
+nTableInsertVar(struct nTable *t, const void *key, size_t keyLen, const void *dataIn)
+{
+    if (checkVarKey(t, keyLen))
+        return nCodeBadInput;
+    if (t->keyMode != TABLE_KEYS_VAR)
+        return insertKey(t, key, keyLen, dataIn);
+    if (!keyLen)
+        return nullKeyInsert(t, dataIn);
+
+    /* Walks size their stack from the longest key */
+    if (keyLen > t->keySize)
+        t->keySize = keyLen;
+    return insertKey(t, key, keyLen, dataIn);
+}
+
+enum nErrorType
+nTableUpsertVar(struct nTable *t, const void *key, size_t keyLen, nTableValueFunc initFunc,
+                nTableValueFunc updateFunc)
+{
+    struct nTableNode  *node;
+    enum nBool          added;
+
+    if (checkVarKey(t, keyLen))
+        return nCodeBadInput;
+    if (t->keyMode == TABLE_KEYS_VAR && !keyLen) {
+        if (nullKeyAdd(t, &added))
+            return nCodeNoSpace;
+        upsertValue(t->nullKey, added, initFunc, updateFunc);
+        return nCodeSuccess;
+    }
+    if (t->keyMode == TABLE_KEYS_VAR && keyLen > t->keySize)
+        t->keySize = keyLen;
+    if (addKey(t, key, keyLen, NULL, &node, &added))
+        return nCodeNoSpace;
+    upsertValue(tableNodeValue(t, node), added, initFunc, updateFunc);
+    return nCodeSuccess;
+}
+
+enum nErrorType
+nTablePeekVar(struct nTable *t, const void *key, size_t keyLen, void *dataOut)
+{
+    if (checkVarKey(t, keyLen))
+        return nCodeBadInput;
+    if (t->keyMode == TABLE_KEYS_VAR && !keyLen)
+        return nullKeyPeek(t, dataOut);
+    return peekKey(t, key, keyLen, dataOut);
+}
+
+enum nErrorType
+nTableRemoveVar(struct nTable *t, const void *key, size_t keyLen)
+{
+    if (checkVarKey(t, keyLen))
+        return nCodeBadInput;
+    if (t->keyMode == TABLE_KEYS_VAR && !keyLen)
+        return nullKeyRemove(t);
+    return removeKey(t, key, keyLen);
+}
+
+enum nErrorType
+nTableInsertPrefix(struct nTable *t, const void *key, size_t prefixBits, const void *dataIn)
+{
+    if (t->keyMode != TABLE_KEYS_PREFIX || prefixBits > t->keySize * bitsPerByte)
+        return nCodeBadInput;
+    if (!prefixBits)
+        return nullKeyInsert(t, dataIn);
+    return insertKey(t, key, prefixBits, dataIn);
+}
+
+enum nErrorType
+nTableRemovePrefix(struct nTable *t, const void *key, size_t prefixBits)
+{
+    if (t->keyMode != TABLE_KEYS_PREFIX || prefixBits > t->keySize * bitsPerByte)
+        return nCodeBadInput;
+    if (!prefixBits)
+        return nullKeyRemove(t);
+    return removeKey(t, key, prefixBits);
+}
+
+/*
+ * Find the longest stored prefix of a keySize-byte key. A stored prefix of
+ * the key leaves the key's search path where the prefix ends: at a node
+ * testing the bit that marks the prefix's end, as that node's left link
+ * back up the trie, or as the last node of the search. The path is walked
+ * once, checking each of those candidates in full.
+ */
+enum nErrorType
+nTableLongestMatch(struct nTable *t, const void *key, void *dataOut, size_t *matchedBitsOut)
+{
+    struct nTableNode  *node = t->head, *nextNode, *candidate, *bestNode = NULL;
+    size_t              keyBits = t->keySize * bitsPerByte, bestBits = 0, candidateBits;
+    const char         *candidateKey;
+    tableBit            prevBit = -1;
+
+    if (t->keyMode != TABLE_KEYS_PREFIX)
+        return nCodeBadInput;
+
+    while (node) {
+        candidate = NULL;
+        if (node->bit <= prevBit) {
+            candidate = node;
+        } else if (!(node->bit % PREFIX_BITS_PER_BIT) && node->l && node->l->bit <= node->bit) {
+            candidate = node->l;
+        }
+        if (candidate) {
+            candidateKey = nodeKey(t, candidate, &candidateBits);
+            if (candidateBits > bestBits
+                && tableFindBitDiff(t->keySize, candidateKey, key) >= candidateBits) {
+                bestNode = candidate;
+                bestBits = candidateBits;
+            }
+        }
+        if (node->bit <= prevBit || !(nextNode = nextLink(t, node, key, keyBits)))
+            break;
+        prevBit = node->bit;
+        node = nextNode;
+    }
+
+    if (bestNode) {
+        elemCopy(dataOut, tableNodeValue(t, bestNode), t->valueSize);
+        *matchedBitsOut = bestBits;
+        return nCodeSuccess;
+    }
+    if (t->nullKey) {
+        *matchedBitsOut = 0;
+        return nullKeyPeek(t, dataOut);
+    }
+    return nCodeNotFound;
+}
+
+/* Point a batch cursor at the next key; returns nFalse once keys run out */
+static enum nBool
+startCursor(struct nTable *t, struct peekCursor *cursor, size_t *nextKey, size_t numKeys)
+{
+    if (*nextKey == numKeys)
+        return nFalse;
+    cursor->node = t->head;
+    cursor->prevBit = -1;
+    cursor->keyIdx = (*nextKey)++;
+    return nTrue;
+}
+
+/*
+ * Look up numKeys contiguous keys, writing each value to the matching slot
+ * of valuesOut and each result to statusOut. Lookups advance one trie level
+ * per round in interleaved fashion, prefetching the next node of each, so
+ * that cache misses of different keys overlap. Returns the number found.
+ */
+size_t
+nTablePeekBatch(struct nTable *t, const void *keys, size_t numKeys, void *valuesOut,
+                enum nErrorType *statusOut)
+{
+    struct peekCursor   cursors[PEEK_BATCH_WIDTH], *cursor;
+    struct nTableNode  *nextNode;
+    const char         *key;
+    size_t              numActive = 0, nextKey = 0, numFound = 0, i;
+
+    if (!t->head || t->keyMode != TABLE_KEYS_FIXED) {
+        for (i = 0; i < numKeys; i++)
+            statusOut[i] = t->keyMode != TABLE_KEYS_FIXED ? nCodeBadInput : nCodeNotFound;
+        return 0;
+    }
+
+    while (numActive < PEEK_BATCH_WIDTH && startCursor(t, cursors + numActive, &nextKey, numKeys))
+        numActive++;
+
+    while (numActive) {
+        for (i = 0; i < numActive;) {
+            cursor = cursors + i;
+            key = (const char *)keys + cursor->keyIdx * t->keySize;
+            if (cursor->node->bit > cursor->prevBit
+                && (nextNode = nextLink(t, cursor->node, key, t->keySize))) {
+                PREFETCH(nextNode);
+                cursor->prevBit = cursor->node->bit;
+                cursor->node = nextNode;
+                i++;
+                continue;
+            }
+
+            if (elemDiffer(cursor->node->data, key, t->keySize)) {
+                statusOut[cursor->keyIdx] = nCodeNotFound;
+            } else {
+                elemCopy((char *)valuesOut + cursor->keyIdx * t->valueSize,
+                         tableNodeValue(t, cursor->node), t->valueSize);
+                statusOut[cursor->keyIdx] = nCodeSuccess;
+                numFound++;
+            }
+            if (startCursor(t, cursor, &nextKey, numKeys))
+                i++;
+            else
+                *cursor = cursors[--numActive];
+        }
+    }
+    return numFound;
+}
+
+/* Call func on every entry of a fixed-size key table, in no particular order */
+void
+nTableForEach(struct nTable *t, nTableIterFunc func)
+{
+    if (t->keyMode == TABLE_KEYS_FIXED)
+        forEachEntry(t, func, NULL);
+}
+
+/* Call func on every entry with its key length, in no particular order */
+void
+nTableForEachVar(struct nTable *t, nTableVarIterFunc func)
+{
+    forEachEntry(t, NULL, func);
+}
+
+/*
+ * Cursors visit entries in key order: memcmp order for fixed-size keys,
+ * and for variable-length keys the same with a key sorting before any
+ * longer key it is a prefix of. A cursor is positioned at an entry while
+ * these calls return nCodeSuccess, and must be released with
+ * nTableCursorDestroy if the walk stops before nCodeNotFound. Changing the
+ * table invalidates its cursors.
+ */
+enum nErrorType
+nTableFirst(struct nTable *t, struct nTableCursor *c)
+{
+    enum nErrorType     ret;
+
+    if (cursorInit(t, c, NULL))
+        return nCodeNoSpace;
+    if (t->nullKey) {
+        cursorSet(c, NULL);
+        return nCodeSuccess;
+    }
+    if ((ret = cursorStart(c, t->head, -1)))
+        nStackDestroy(&c->path);
+    return ret;
+}
+
+/* Position a cursor at the first key not less than key */
+enum nErrorType
+nTableSeek(struct nTable *t, struct nTableCursor *c, const void *key, size_t keyLen)
+{
+    enum nErrorType     ret;
+
+    if (checkVarKey(t, keyLen))
+        return nCodeBadInput;
+    if (t->keyMode == TABLE_KEYS_VAR && !keyLen)
+        return nTableFirst(t, c);
+    if (cursorInit(t, c, NULL))
+        return nCodeNoSpace;
+    if ((ret = cursorSeek(c, key, keyLen)))
+        nStackDestroy(&c->path);
+    return ret;
+}
+
+enum nErrorType
+nTableNext(struct nTableCursor *c)
+{
+    enum nErrorType     ret;
+
+    if (c->atNullKey)
+        ret = cursorStart(c, c->t->head, -1);
+    else
+        ret = cursorAdvance(c);
+    if (ret)
+        nStackDestroy(&c->path);
+    return ret;
+}
+
+void
+nTableCursorDestroy(struct nTableCursor *c)
+{
+    nStackDestroy(&c->path);
+}
+
+/*
+ * Call func in key order on the entries with keys from lo through hi,
+ * until func returns nTrue. The cost depends on the number of entries in
+ * range, not on the size of the table.
+ */
+enum nErrorType
+nTableRange(struct nTable *t, const void *lo, const void *hi, nTableIterFunc func)
+{
+    if (t->keyMode != TABLE_KEYS_FIXED)
+        return nCodeBadInput;
+    return rangeScan(t, lo, t->keySize, hi, t->keySize, func, NULL);
+}
+
+enum nErrorType
+nTableRangeVar(struct nTable *t, const void *lo, size_t loLen, const void *hi, size_t hiLen,
+               nTableVarIterFunc func)
+{
+    if (checkVarKey(t, loLen) || checkVarKey(t, hiLen))
+        return nCodeBadInput;
+    return rangeScan(t, lo, loLen, hi, hiLen, NULL, func);
+}
+
+/*
+ * Call func in key order on the entries whose keys start with the first
+ * prefixBits bits of prefix, until func returns nTrue
+ */
+enum nErrorType
+nTablePrefix(struct nTable *t, const void *prefix, size_t prefixBits, nTableIterFunc func)
+{
+    if (t->keyMode != TABLE_KEYS_FIXED)
+        return nCodeBadInput;
+    return prefixScan(t, prefix, prefixBits, func, NULL);
+}
+
+enum nErrorType
+nTablePrefixVar(struct nTable *t, const void *prefix, size_t prefixBits, nTableVarIterFunc func)
+{
+    if (t->keyMode == TABLE_KEYS_PREFIX)
+        return nCodeBadInput;
+    return prefixScan(t, prefix, prefixBits, NULL, func);
 }
 
 enum nBool
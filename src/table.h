@@ -1,10 +1,157 @@
 #ifndef TABLE_H
 #define TABLE_H
 
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pool.h"
+
+/* Values of nTable keyMode */
+#define TABLE_KEYS_FIXED 0
+#define TABLE_KEYS_VAR 1
+#define TABLE_KEYS_PREFIX 2
+#define TABLE_KEYS_MAPPED 3
+
+/*
+ * Bit offset within a key, as stored in a node. Searches start above the
+ * head with the offset -1, so the type is signed; keys are limited to
+ * offsets up to TABLE_BIT_MAX.
+ */
+typedef int32_t tableBit;
+
+#define TABLE_BIT_MAX INT32_MAX
+
+/* Key bytes followed by value bytes are stored inline after the header */
 struct nTableNode {
     struct nTableNode              *l, *r;
-    short                           bit;
-    void                           *key, *value;
+    tableBit                        bit;
+    char                            data[];
 };
 
+/*
+ * A table with variable-length keys keeps each key in its own allocation;
+ * the node's key slot holds this reference instead of the key bytes
+ */
+struct nTableVarKey {
+    char                           *bytes;
+    size_t                          len;
+};
+
+/*
+ * Node layout, shared with the concurrent table. A node's data starts
+ * with its key slot: keySize bytes, followed for a prefix key by its
+ * length in bits, or a struct nTableVarKey for a variable-length key.
+ */
+static inline size_t
+tableKeySlotSize(const struct nTable *t)
+{
+    switch (t->keyMode) {
+    case TABLE_KEYS_VAR:
+        return sizeof(struct nTableVarKey);
+    case TABLE_KEYS_PREFIX:
+        return t->keySize + sizeof(uint32_t);
+    default:
+        return t->keySize;
+    }
+}
+
+/*
+ * Bytes from the data of a node or record, dataStart bytes into it, to a
+ * value that follows keyBytes of key and is aligned to align from the
+ * start of the node
+ */
+static inline size_t
+tableValueOffset(size_t dataStart, size_t keyBytes, size_t align)
+{
+    return (dataStart + keyBytes + align - 1) / align * align - dataStart;
+}
+
+/*
+ * Values sit at POOL_ALIGN within a node, so the pointers handed out by
+ * nTableGetRef and the upserts can be used as any scalar type
+ */
+static inline size_t
+tableNodeValueOffset(const struct nTable *t)
+{
+    return tableValueOffset(offsetof(struct nTableNode, data), tableKeySlotSize(t), POOL_ALIGN);
+}
+
+static inline char             *
+tableNodeValue(const struct nTable *t, struct nTableNode *node)
+{
+    return node->data + tableNodeValueOffset(t);
+}
+
+/* Key bit helpers shared with the concurrent table */
+tableBit                        tableFindBitDiff(size_t keySize, const void *key1, const void *key2);
+
+/*
+ * The all-zero key is stored with bit == keySize * 8 and a right link to
+ * itself, so bits past the end of a key read as set
+ */
+static inline enum nBool
+tableBitSet(size_t keySize, tableBit bitOff, const void *key)
+{
+    size_t              byteOffset = (uint32_t)bitOff / CHAR_BIT;
+    unsigned int        innerBitOffset = (uint32_t)bitOff % CHAR_BIT;
+
+    if (byteOffset >= keySize)
+        return nTrue;
+
+    return (*((unsigned char *)key + byteOffset) >> (CHAR_BIT - 1 - innerBitOffset)) & 1;
+}
+
+/*
+ * Trie rules shared by nTable, nCTable and nITable, whose nodes differ in
+ * what a link is but all have l and r links and a bit. A link leads down
+ * the trie when its target tests a later bit than its owner; otherwise it
+ * refers back up to the node holding the key a search is after.
+ */
+static inline enum nBool
+tableLinkDown(tableBit ownerBit, tableBit targetBit)
+{
+    return targetBit > ownerBit;
+}
+
+/*
+ * A key first differing from the trie at diffBit goes in place of the
+ * first link on its search path that crosses diffBit or points back up
+ */
+static inline enum nBool
+tableInsertHere(tableBit parentBit, tableBit nodeBit, tableBit diffBit)
+{
+    return nodeBit > diffBit || !tableLinkDown(parentBit, nodeBit);
+}
+
+/*
+ * A new node refers to itself on the side its own key takes at its bit,
+ * and to old, the target of the link it replaces, on the other
+ */
+#define TABLE_LINK_NEW(node, self, old, keyBitSet)                              \
+    do {                                                                        \
+        if (keyBitSet) {                                                        \
+            (node)->r = (self);                                                 \
+            (node)->l = (old);                                                  \
+        } else {                                                                \
+            (node)->r = (old);                                                  \
+            (node)->l = (self);                                                 \
+        }                                                                       \
+    } while (0)
+
+/* Point whichever link of owner leads to from at to instead */
+#define TABLE_RELINK(owner, from, to)                                           \
+    do {                                                                        \
+        if ((owner)->l == (from))                                               \
+            (owner)->l = (to);                                                  \
+        else                                                                    \
+            (owner)->r = (to);                                                  \
+    } while (0)
+
+/*
+ * Every node is reached by exactly one downward link, so a walk stack
+ * holds at most one entry per bit position plus one for keyBits-bit keys
+ */
+#define TABLE_WALK_DEPTH(keyBits) ((keyBits) + 2)
+
 #endif
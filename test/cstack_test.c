@@ -0,0 +1,188 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+#include "nanodtypes.h"
+#include "test.h"
+
+/* Single-threaded use */
+
+static enum nBool
+cstackPushPop()
+{
+    struct nCStack      s;
+    uint16_t            i, value;
+
+    if (nCodeBadInput != nCStackInit(&s, 0, sizeof(value)))
+        return nFalse;
+    if (nCStackInit(&s, 10, sizeof(value)))
+        return nFalse;
+    if (!nCStackEmpty(&s) || nCodeEmpty != nCStackPop(&s, &value))
+        return nFalse;
+    for (i = 0; i < 10; i++)
+        if (nCStackPush(&s, &i))
+            return nFalse;
+    if (nCodeFull != nCStackPush(&s, &i))
+        return nFalse;
+    for (i = 10; i-- > 0;)
+        if (nCStackPop(&s, &value) || value != i)
+            return nFalse;
+    if (!nCStackEmpty(&s))
+        return nFalse;
+    nCStackDestroy(&s);
+    return nTrue;
+}
+
+/* Bulk calls keep the order of nStackPushN and nStackPopN */
+static enum nBool
+cstackBulk()
+{
+    struct nCStack      s;
+    uint32_t            in[6] = {1, 2, 3, 4, 5, 6}, out[6], value;
+    int                 i;
+
+    if (nCStackInit(&s, 8, sizeof(value)))
+        return nFalse;
+    if (nCStackPushN(&s, in, 6))
+        return nFalse;
+    if (nCodeFull != nCStackPushN(&s, in, 3) || nCStackPop(&s, &value) || value != 6)
+        return nFalse;
+    if (nCodeEmpty != nCStackPopN(&s, out, 6))
+        return nFalse;
+    if (nCStackPopN(&s, out, 5))
+        return nFalse;
+    for (i = 0; i < 5; i++)
+        if (out[i] != in[i])
+            return nFalse;
+    if (!nCStackEmpty(&s))
+        return nFalse;
+    nCStackDestroy(&s);
+    return nTrue;
+}
+
+/* A cache spills to and refills from the shared stack in halves */
+static enum nBool
+cstackCache()
+{
+    struct nCStack      s;
+    struct nCStackCache c;
+    uint32_t            i, value, seen = 0;
+
+    if (nCStackInit(&s, 16, sizeof(value)) || nCStackCacheInit(&c, &s, 4))
+        return nFalse;
+    for (i = 0; i < 4; i++)
+        if (nCStackCachePush(&c, &i))
+            return nFalse;
+    if (!nCStackEmpty(&s))
+        return nFalse;
+    if (nCStackCachePush(&c, &i) || nCStackEmpty(&s))
+        return nFalse;
+    if (nCStackPop(&s, &value) || value != 1 || nCStackPop(&s, &value) || value != 0)
+        return nFalse;
+
+    for (i = 0; i < 3; i++) {
+        if (nCStackCachePop(&c, &value))
+            return nFalse;
+        seen |= 1 << value;
+    }
+    if (seen != (1 << 2 | 1 << 3 | 1 << 4) || nCodeEmpty != nCStackCachePop(&c, &value))
+        return nFalse;
+
+    i = 9;
+    if (nCStackPush(&s, &i) || nCStackCachePop(&c, &value) || value != 9)
+        return nFalse;
+    if (nCStackCachePush(&c, &i))
+        return nFalse;
+    nCStackCacheDestroy(&c);
+    if (nCStackPop(&s, &value) || value != 9 || !nCStackEmpty(&s))
+        return nFalse;
+    nCStackDestroy(&s);
+    return nTrue;
+}
+
+/*
+ * Threads share a pool of buffers: each pops one, claims it, releases it
+ * and pushes it back. A buffer handed to two threads at once, or lost,
+ * shows up in the claims or the final count.
+ */
+
+#define CSTACK_THREADS 4
+#define CSTACK_BUFFERS 16
+#define CSTACK_ROUNDS 50000
+
+static struct nCStack           threadStack;
+static int                      bufferOwned[CSTACK_BUFFERS];
+
+static enum nBool
+useBuffer(uint32_t buffer)
+{
+    if (buffer >= CSTACK_BUFFERS || __atomic_exchange_n(&bufferOwned[buffer], 1, __ATOMIC_ACQ_REL))
+        return nFalse;
+    __atomic_store_n(&bufferOwned[buffer], 0, __ATOMIC_RELEASE);
+    return nTrue;
+}
+
+static void                    *
+cstackWorker(void *arg)
+{
+    struct nCStackCache cache;
+    uint32_t            buffer;
+    int                 round, cached = arg != NULL;
+
+    if (cached && nCStackCacheInit(&cache, &threadStack, 4))
+        return &threadStack;
+    for (round = 0; round < CSTACK_ROUNDS; round++) {
+        if (cached ? nCStackCachePop(&cache, &buffer) : nCStackPop(&threadStack, &buffer)) {
+            sched_yield();
+            continue;
+        }
+        if (!useBuffer(buffer))
+            return &threadStack;
+        if (cached ? nCStackCachePush(&cache, &buffer) : nCStackPush(&threadStack, &buffer))
+            return &threadStack;
+    }
+    if (cached)
+        nCStackCacheDestroy(&cache);
+    return NULL;
+}
+
+static enum nBool
+cstackThreads()
+{
+    pthread_t           threads[CSTACK_THREADS];
+    uint32_t            buffer, seen = 0;
+    void               *failed;
+    enum nBool          result = nTrue;
+    uintptr_t           i;
+
+    if (nCStackInit(&threadStack, CSTACK_BUFFERS, sizeof(buffer)))
+        return nFalse;
+    for (buffer = 0; buffer < CSTACK_BUFFERS; buffer++)
+        nCStackPush(&threadStack, &buffer);
+
+    /* Half the threads go through a cache of their own */
+    for (i = 0; i < CSTACK_THREADS; i++)
+        if (pthread_create(&threads[i], NULL, cstackWorker, (void *)(i % 2)))
+            return nFalse;
+    for (i = 0; i < CSTACK_THREADS; i++) {
+        pthread_join(threads[i], &failed);
+        if (failed)
+            result = nFalse;
+    }
+
+    while (!nCStackPop(&threadStack, &buffer))
+        seen |= 1u << buffer;
+    if (seen != (1u << CSTACK_BUFFERS) - 1)
+        result = nFalse;
+    nCStackDestroy(&threadStack);
+    return result;
+}
+
+struct testInfo                 cstackTests[] = {
+    {cstackPushPop, "Concurrent stack push and pop succeed"},
+    {cstackBulk, "Concurrent stack bulk calls keep order"},
+    {cstackCache, "Per-thread cache spills and refills in halves"},
+    {cstackThreads, "Threads sharing a buffer pool never share a buffer"},
+
+    {NULL, ""}
+};
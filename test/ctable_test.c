@@ -0,0 +1,202 @@
+#include <pthread.h>
+#include <stdint.h>
+
+#include "nanodtypes.h"
+#include "test.h"
+
+/* Single-threaded use */
+
+static enum nBool
+ctableSimple()
+{
+    struct nCTable      ct;
+    uint32_t            k, dataIn, dataOut;
+
+    if (nCodeBadInput != nCTableInit(&ct, sizeof(k), sizeof(dataIn), 0, 0))
+        return nFalse;
+    if (nCTableInit(&ct, sizeof(k), sizeof(dataIn), 0, 2))
+        return nFalse;
+
+    k = 0;
+    if (nCodeNotFound != nCTablePeek(&ct, 0, &k, &dataOut))
+        return nFalse;
+    if (nCodeNotFound != nCTableRemove(&ct, &k))
+        return nFalse;
+    for (k = 0; k < 3; k++) {
+        dataIn = k + 100;
+        if (nCTableInsert(&ct, &k, &dataIn))
+            return nFalse;
+    }
+    if (nCTableSize(&ct) != 3)
+        return nFalse;
+
+    k = 1;
+    dataIn = 7;
+    if (nCTableInsert(&ct, &k, &dataIn) || nCTableSize(&ct) != 3)
+        return nFalse;
+    if (nCTablePeek(&ct, 1, &k, &dataOut) || dataOut != 7)
+        return nFalse;
+    if (nCodeBadInput != nCTablePeek(&ct, 2, &k, &dataOut))
+        return nFalse;
+
+    k = 0;
+    if (nCTableRemove(&ct, &k) || nCodeNotFound != nCTablePeek(&ct, 0, &k, &dataOut))
+        return nFalse;
+    k = 2;
+    if (nCTablePeek(&ct, 0, &k, &dataOut) || dataOut != 102)
+        return nFalse;
+    if (nCTableSize(&ct) != 2)
+        return nFalse;
+    nCTableDestroy(&ct);
+    return nTrue;
+}
+
+/* Random inserts, updates and removals checked against a presence map */
+
+#define CTABLE_CHURN_OPS 20000
+#define CTABLE_CHURN_KEYS 1024
+#define CTABLE_CHECK_EVERY 1000
+
+static enum nBool
+ctableMatchesMap(struct nCTable *ct, const unsigned short *present)
+{
+    unsigned short      k, dataOut;
+
+    for (k = 0; k < CTABLE_CHURN_KEYS; k++) {
+        if (present[k] && (nCTablePeek(ct, 0, &k, &dataOut) || dataOut + 1 != present[k]))
+            return nFalse;
+        if (!present[k] && nCodeNotFound != nCTablePeek(ct, 0, &k, &dataOut))
+            return nFalse;
+    }
+    return nTrue;
+}
+
+static enum nBool
+ctableChurn()
+{
+    static unsigned short present[CTABLE_CHURN_KEYS];
+    struct nCTable      ct;
+    unsigned long       seed = 2468;
+    unsigned short      k, dataIn;
+    size_t              expectedSize = 0;
+    int                 op;
+
+    if (nCTableInit(&ct, sizeof(k), sizeof(dataIn), 64, 1))
+        return nFalse;
+    for (op = 0; op < CTABLE_CHURN_OPS; op++) {
+        seed = seed * 1103515245 + 12345;
+        k = (seed >> 8) % CTABLE_CHURN_KEYS;
+        dataIn = op & 0xffff;
+        if ((seed >> 24) % 3) {
+            if (nCTableInsert(&ct, &k, &dataIn))
+                return nFalse;
+            if (!present[k])
+                expectedSize++;
+            present[k] = dataIn + 1;
+        } else {
+            if (nCTableRemove(&ct, &k) != (present[k] ? nCodeSuccess : nCodeNotFound))
+                return nFalse;
+            if (present[k])
+                expectedSize--;
+            present[k] = 0;
+        }
+        if (nCTableSize(&ct) != expectedSize)
+            return nFalse;
+        if (op % CTABLE_CHECK_EVERY == 0 && !ctableMatchesMap(&ct, present))
+            return nFalse;
+    }
+    if (!ctableMatchesMap(&ct, present))
+        return nFalse;
+    nCTableDestroy(&ct);
+    return nTrue;
+}
+
+/*
+ * Readers search while a writer churns. Even keys stay in the table the
+ * whole time, their value flipping between two correct values; odd keys
+ * come and go but always carry a correct value when found.
+ */
+
+#define CTABLE_THREAD_READERS 3
+#define CTABLE_THREAD_KEYS 4096
+#define CTABLE_WRITER_OPS 40000
+
+static struct nCTable           threadTable;
+static int                      writerDone;
+
+static uint32_t
+ctableValue(uint32_t k, uint32_t flip)
+{
+    return k * 7 + flip;
+}
+
+static void                    *
+ctableReader(void *arg)
+{
+    size_t              reader = (size_t)arg;
+    uint32_t            k = reader, dataOut;
+    enum nErrorType     ret;
+
+    while (!__atomic_load_n(&writerDone, __ATOMIC_ACQUIRE)) {
+        k = (k * 2654435761u + 1) % CTABLE_THREAD_KEYS;
+        ret = nCTablePeek(&threadTable, reader, &k, &dataOut);
+        if (ret == nCodeNotFound && k % 2 == 0)
+            return &threadTable;
+        if (ret == nCodeSuccess && dataOut != ctableValue(k, 0) && dataOut != ctableValue(k, 1))
+            return &threadTable;
+    }
+    return NULL;
+}
+
+static enum nBool
+ctableThreads()
+{
+    pthread_t           readers[CTABLE_THREAD_READERS];
+    unsigned long       seed = 97531;
+    uint32_t            k, dataIn;
+    void               *failed;
+    enum nBool          result = nTrue;
+    size_t              i;
+
+    if (nCTableInit(&threadTable, sizeof(k), sizeof(dataIn), 256, CTABLE_THREAD_READERS))
+        return nFalse;
+    for (k = 0; k < CTABLE_THREAD_KEYS; k += 2) {
+        dataIn = ctableValue(k, 0);
+        if (nCTableInsert(&threadTable, &k, &dataIn))
+            return nFalse;
+    }
+
+    writerDone = 0;
+    for (i = 0; i < CTABLE_THREAD_READERS; i++)
+        if (pthread_create(&readers[i], NULL, ctableReader, (void *)i))
+            return nFalse;
+    for (i = 0; i < CTABLE_WRITER_OPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        k = (seed >> 8) % CTABLE_THREAD_KEYS;
+        dataIn = ctableValue(k, (seed >> 24) & 1);
+        if (k % 2 == 0 || (seed >> 25) % 2)
+            nCTableInsert(&threadTable, &k, &dataIn);
+        else
+            nCTableRemove(&threadTable, &k);
+    }
+    __atomic_store_n(&writerDone, 1, __ATOMIC_RELEASE);
+    for (i = 0; i < CTABLE_THREAD_READERS; i++) {
+        pthread_join(readers[i], &failed);
+        if (failed)
+            result = nFalse;
+    }
+
+    for (k = 0; k < CTABLE_THREAD_KEYS; k += 2)
+        if (nCTablePeek(&threadTable, 0, &k, &dataIn))
+            result = nFalse;
+    nCTableDestroy(&threadTable);
+    return result;
+}
+
+struct testInfo                 ctableTests[] = {
+    {ctableSimple, "Concurrent table insert, update and remove succeeds"},
+    {ctableChurn, "Concurrent table churn matches reference"},
+    {ctableThreads, "Readers alongside a writer always find stable keys"},
+
+    {NULL, ""}
+};
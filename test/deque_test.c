@@ -0,0 +1,185 @@
+#include "nanodtypes.h"
+#include "test.h"
+
+static struct nDeque            simpleDeque;
+
+static enum nBool
+nDequeSimpleEmptyCheck()
+{
+    nDequeInit(&simpleDeque, sizeof(char));
+    if (nDequeSize(&simpleDeque) != 0)
+        return nFalse;
+    return nDequeEmpty(&simpleDeque);
+}
+
+/* Depends on nDequeSimpleEmptyCheck */
+static enum nBool
+nDequeAddRemoveHead()
+{
+    char                outputData = 'X', inputData = 'N';
+
+    if (nDequeInsertHead(&simpleDeque, &inputData))
+        return nFalse;
+    if (nDequeRemoveTail(&simpleDeque, &outputData))
+        return nFalse;
+    if (inputData != outputData)
+        return nFalse;
+    return nDequeEmpty(&simpleDeque);
+}
+
+/* Deque must be empty */
+static enum nBool
+nDequeSimplePopExtra()
+{
+    char                dummyData;
+    if (nCodeEmpty != nDequeRemoveTail(&simpleDeque, &dummyData))
+        return nFalse;
+    if (nCodeEmpty != nDequeRemoveHead(&simpleDeque, &dummyData))
+        return nFalse;
+    return nTrue;
+}
+
+/* Deque must be empty at this point */
+static enum nBool
+nDequeSimpleAddRemove()
+{
+    char                i, outData;
+
+    for (i = 1; i <= 4; i++) {
+        nDequeInsertHead(&simpleDeque, &i);     /* H 4 3 2 1 T */
+    }
+    if (nDequeRemoveHead(&simpleDeque, &outData) || outData != 4)
+        return nFalse;
+    if (nDequeRemoveTail(&simpleDeque, &outData) || outData != 1)
+        return nFalse;
+    i = 5;
+    nDequeInsertTail(&simpleDeque, &i); /* H 3 2 5 T */
+    if (nDequeRemoveHead(&simpleDeque, &outData) || outData != 3)
+        return nFalse;
+    if (nDequeRemoveHead(&simpleDeque, &outData) || outData != 2)
+        return nFalse;
+    if (nDequeRemoveHead(&simpleDeque, &outData) || outData != 5)
+        return nFalse;
+    return nDequeEmpty(&simpleDeque);
+}
+
+/* Growth while the elements wrap around the end of the buffer */
+
+#define WRAP_ELEMS 100
+
+static struct nDeque            wrapDeque;
+
+static enum nBool
+nDequeGrowWrapped()
+{
+    int                 i, outData;
+
+    nDequeInit(&wrapDeque, sizeof(int));
+    /* Move the head off zero, then insert at both ends */
+    for (i = 0; i < 5; i++)
+        nDequeInsertTail(&wrapDeque, &i);
+    for (i = 0; i < 5; i++)
+        nDequeRemoveHead(&wrapDeque, &outData);
+    for (i = 0; i < WRAP_ELEMS; i++) {
+        if (nDequeInsertTail(&wrapDeque, &i))
+            return nFalse;
+    }
+    for (i = -1; i >= -WRAP_ELEMS; i--) {
+        if (nDequeInsertHead(&wrapDeque, &i))
+            return nFalse;
+    }
+    if (nDequeSize(&wrapDeque) != 2 * WRAP_ELEMS)
+        return nFalse;
+    for (i = -WRAP_ELEMS; i < WRAP_ELEMS; i++) {
+        if (nDequeRemoveHead(&wrapDeque, &outData) || outData != i)
+            return nFalse;
+    }
+    return nDequeEmpty(&wrapDeque);
+}
+
+static enum nBool
+nDequeDestroyCheck()
+{
+    int                 i = 3;
+
+    nDequeInsertTail(&wrapDeque, &i);
+    nDequeDestroy(&wrapDeque);
+    nDequeDestroy(&wrapDeque);  /* Confirm no double free */
+    if (!nDequeEmpty(&wrapDeque))
+        return nFalse;
+    if (nDequeInsertHead(&wrapDeque, &i) || nDequeSize(&wrapDeque) != 1)
+        return nFalse;
+    nDequeDestroy(&wrapDeque);
+    return nTrue;
+}
+
+/* ForEach tests */
+
+static struct nDeque            feDeque;
+static unsigned int             numFeCalls;
+
+static enum nBool
+nDequeIterFuncRemoveEven(void *data)
+{
+    numFeCalls++;
+    return *(int *)data % 2 == 0;
+}
+
+static enum nBool
+nDequeIterFuncEmpty(void *data)
+{
+    numFeCalls++;
+    return nFalse;
+}
+
+static enum nBool
+nDequeForEachEmpty()
+{
+    nDequeInit(&feDeque, sizeof(int));
+    numFeCalls = 0;
+    nDequeForEach(&feDeque, nDequeIterFuncEmpty);
+    return numFeCalls == 0;
+}
+
+static enum nBool
+nDequeForEachRemove()
+{
+    int                 i, outData;
+
+    /* Wrapped layout: H 0 1 .. 9 T with the head near the buffer end */
+    for (i = 4; i >= 0; i--)
+        nDequeInsertHead(&feDeque, &i);
+    for (i = 5; i < 10; i++)
+        nDequeInsertTail(&feDeque, &i);
+
+    numFeCalls = 0;
+    nDequeForEach(&feDeque, nDequeIterFuncRemoveEven);
+    if (numFeCalls != 10 || nDequeSize(&feDeque) != 5)
+        return nFalse;
+    for (i = 1; i < 10; i += 2) {
+        if (nDequeRemoveHead(&feDeque, &outData) || outData != i)
+            return nFalse;
+    }
+    nDequeDestroy(&feDeque);
+    return nTrue;
+}
+
+struct testInfo                 dequeTests[] = {
+
+    /* Simple deque */
+    {nDequeSimpleEmptyCheck, "Simple deque reads initially empty"},
+    {nDequeAddRemoveHead, "Add single element to head and remove from tail"},
+    {nDequeSimplePopExtra, "Removing too many elements is an error"},
+    {nDequeSimpleAddRemove, "Several insertions and removals"},
+
+    /* Growth */
+    {nDequeGrowWrapped, "Growing a wrapped deque keeps element order"},
+    {nDequeDestroyCheck, "Destroyed deque is empty and reusable"},
+
+    /* Foreach */
+    {nDequeForEachEmpty, "ForEach on empty deque does nothing"},
+    {nDequeForEachRemove, "ForEach removes elements in place"},
+
+    {NULL, ""}
+
+};
@@ -0,0 +1,183 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "nanodtypes.h"
+#include "test.h"
+
+static enum nBool
+hashSimple()
+{
+    struct nHash        h;
+    uint32_t            k, dataIn, dataOut;
+
+    if (nCodeBadInput != nHashInit(&h, 0, sizeof(dataIn), 0))
+        return nFalse;
+    if (nHashInit(&h, sizeof(k), sizeof(dataIn), 0))
+        return nFalse;
+
+    k = 0;
+    if (nCodeNotFound != nHashPeek(&h, &k, &dataOut) || nCodeNotFound != nHashRemove(&h, &k))
+        return nFalse;
+    for (k = 0; k < 3; k++) {
+        dataIn = k + 100;
+        if (nHashInsert(&h, &k, &dataIn))
+            return nFalse;
+    }
+    dataIn = 7;
+    if (nHashInsert(&h, &k, &dataIn) || nHashInsert(&h, &k, &dataIn) || nHashSize(&h) != 4)
+        return nFalse;
+
+    k = 0;
+    if (nHashRemove(&h, &k) || nCodeNotFound != nHashPeek(&h, &k, &dataOut))
+        return nFalse;
+    k = 2;
+    if (nHashPeek(&h, &k, &dataOut) || dataOut != 102)
+        return nFalse;
+    nHashDestroy(&h);
+    return nHashEmpty(&h);
+}
+
+/*
+ * Random inserts, updates and removals checked against a presence map.
+ * The table starts at its smallest, so many of the operations land while
+ * entries are still moving to a bigger array.
+ */
+
+#define HASH_CHURN_OPS 60000
+#define HASH_CHURN_KEYS 20000
+#define HASH_CHECK_EVERY 997
+
+static enum nBool
+hashMatchesMap(struct nHash *h, const unsigned short *present)
+{
+    unsigned int        k;
+    unsigned short      dataOut;
+
+    for (k = 0; k < HASH_CHURN_KEYS; k++) {
+        if (present[k] && (nHashPeek(h, &k, &dataOut) || dataOut + 1 != present[k]))
+            return nFalse;
+        if (!present[k] && nCodeNotFound != nHashPeek(h, &k, &dataOut))
+            return nFalse;
+    }
+    return nTrue;
+}
+
+static enum nBool
+hashChurn()
+{
+    static unsigned short present[HASH_CHURN_KEYS];
+    struct nHash        h;
+    unsigned long       seed = 2468;
+    unsigned int        k;
+    unsigned short      dataIn;
+    size_t              expectedSize = 0;
+    int                 op;
+
+    if (nHashInit(&h, sizeof(k), sizeof(dataIn), 0))
+        return nFalse;
+    for (op = 0; op < HASH_CHURN_OPS; op++) {
+        seed = seed * 1103515245 + 12345;
+        k = (seed >> 8) % HASH_CHURN_KEYS;
+        dataIn = op & 0x7fff;
+        if ((seed >> 24) % 4) {
+            if (nHashInsert(&h, &k, &dataIn))
+                return nFalse;
+            if (!present[k])
+                expectedSize++;
+            present[k] = dataIn + 1;
+        } else {
+            if (nHashRemove(&h, &k) != (present[k] ? nCodeSuccess : nCodeNotFound))
+                return nFalse;
+            if (present[k])
+                expectedSize--;
+            present[k] = 0;
+        }
+        if (nHashSize(&h) != expectedSize)
+            return nFalse;
+        if (op % HASH_CHECK_EVERY == 0 && !hashMatchesMap(&h, present))
+            return nFalse;
+    }
+    if (!hashMatchesMap(&h, present))
+        return nFalse;
+    nHashDestroy(&h);
+    return nTrue;
+}
+
+/* Keys that are not a whole number of words, including the all-zero key */
+
+#define WIDE_HASH_KEY 13
+#define WIDE_HASH_KEYS 300
+
+static enum nBool
+hashWideKeys()
+{
+    struct nHash        h;
+    unsigned char       key[WIDE_HASH_KEY];
+    unsigned int        i, dataOut;
+
+    if (nHashInit(&h, sizeof(key), sizeof(i), 1000))
+        return nFalse;
+    for (i = 0; i < WIDE_HASH_KEYS; i++) {
+        memset(key, 0, sizeof(key));
+        key[i % WIDE_HASH_KEY] = i / WIDE_HASH_KEY;
+        if (nHashInsert(&h, key, &i))
+            return nFalse;
+    }
+    for (i = 0; i < WIDE_HASH_KEYS; i++) {
+        memset(key, 0, sizeof(key));
+        key[i % WIDE_HASH_KEY] = i / WIDE_HASH_KEY;
+        if (nHashPeek(&h, key, &dataOut))
+            return nFalse;
+
+        /* The zero key is stored once for each position */
+        if (i >= WIDE_HASH_KEY && dataOut != i)
+            return nFalse;
+    }
+    nHashDestroy(&h);
+    return nTrue;
+}
+
+static unsigned int             numHashCalls;
+
+static enum nBool
+removeOddHashKeys(void *key, void *value)
+{
+    uint32_t            k;
+
+    memcpy(&k, key, sizeof(k));
+    numHashCalls++;
+    return k % 2 ? nTrue : nFalse;
+}
+
+static enum nBool
+hashForEachRemove()
+{
+    struct nHash        h;
+    uint32_t            k, dataOut;
+
+    if (nHashInit(&h, sizeof(k), sizeof(k), 0))
+        return nFalse;
+
+    /* Stop while entries are still moving to a bigger array */
+    for (k = 0; k < 60; k++)
+        if (nHashInsert(&h, &k, &k))
+            return nFalse;
+    numHashCalls = 0;
+    nHashForEach(&h, removeOddHashKeys);
+    if (numHashCalls != 60 || nHashSize(&h) != 30)
+        return nFalse;
+    for (k = 0; k < 60; k++)
+        if ((nHashPeek(&h, &k, &dataOut) == nCodeSuccess) == (k % 2))
+            return nFalse;
+    nHashDestroy(&h);
+    return nTrue;
+}
+
+struct testInfo                 hashTests[] = {
+    {hashSimple, "Hash insert, peek and remove succeed"},
+    {hashChurn, "Hash churn across resizes matches reference"},
+    {hashWideKeys, "Hash keys of odd widths"},
+    {hashForEachRemove, "Hash foreach removes requested entries"},
+
+    {NULL, ""}
+};
@@ -0,0 +1,212 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "nanodtypes.h"
+#include "test.h"
+
+static enum nBool
+itableSimple()
+{
+    struct nITable      t;
+    uint32_t            k, dataIn, dataOut;
+
+    if (nCodeBadInput != nITableInit(&t, 0, sizeof(dataIn), 0))
+        return nFalse;
+    if (nCodeBadInput != nITableInit(&t, 1 << 16, sizeof(dataIn), 0))
+        return nFalse;
+    if (nITableInit(&t, sizeof(k), sizeof(dataIn), 0))
+        return nFalse;
+
+    k = 0;
+    if (nCodeNotFound != nITablePeek(&t, &k, &dataOut) || nCodeNotFound != nITableRemove(&t, &k))
+        return nFalse;
+    for (k = 0; k < 3; k++) {
+        dataIn = k + 100;
+        if (nITableInsert(&t, &k, &dataIn))
+            return nFalse;
+    }
+    dataIn = 7;
+    if (nITableInsert(&t, &k, &dataIn) || nITableInsert(&t, &k, &dataIn) || nITableSize(&t) != 4)
+        return nFalse;
+
+    k = 0;
+    if (nITableRemove(&t, &k) || nCodeNotFound != nITablePeek(&t, &k, &dataOut))
+        return nFalse;
+    k = 2;
+    if (nITablePeek(&t, &k, &dataOut) || dataOut != 102)
+        return nFalse;
+    nITableDestroy(&t);
+    return nITableEmpty(&t);
+}
+
+/*
+ * Random inserts, updates and removals checked against a presence map,
+ * packing the table now and then; the node array grows from its minimum
+ */
+
+#define ITABLE_CHURN_OPS 20000
+#define ITABLE_CHURN_KEYS 1024
+#define ITABLE_CHECK_EVERY 1000
+
+static enum nBool
+itableMatchesMap(struct nITable *t, const unsigned short *present)
+{
+    unsigned short      k, dataOut;
+
+    for (k = 0; k < ITABLE_CHURN_KEYS; k++) {
+        if (present[k] && (nITablePeek(t, &k, &dataOut) || dataOut + 1 != present[k]))
+            return nFalse;
+        if (!present[k] && nCodeNotFound != nITablePeek(t, &k, &dataOut))
+            return nFalse;
+    }
+    return nTrue;
+}
+
+static enum nBool
+itableChurn()
+{
+    static unsigned short present[ITABLE_CHURN_KEYS];
+    struct nITable      t;
+    unsigned long       seed = 1357;
+    unsigned short      k, dataIn;
+    size_t              expectedSize = 0;
+    int                 op;
+
+    if (nITableInit(&t, sizeof(k), sizeof(dataIn), 0))
+        return nFalse;
+    for (op = 0; op < ITABLE_CHURN_OPS; op++) {
+        seed = seed * 1103515245 + 12345;
+        k = (seed >> 8) % ITABLE_CHURN_KEYS;
+        dataIn = op & 0xffff;
+        if ((seed >> 24) % 3) {
+            if (nITableInsert(&t, &k, &dataIn))
+                return nFalse;
+            if (!present[k])
+                expectedSize++;
+            present[k] = dataIn + 1;
+        } else {
+            if (nITableRemove(&t, &k) != (present[k] ? nCodeSuccess : nCodeNotFound))
+                return nFalse;
+            if (present[k])
+                expectedSize--;
+            present[k] = 0;
+        }
+        if (nITableSize(&t) != expectedSize)
+            return nFalse;
+        if (op % ITABLE_CHECK_EVERY == 0) {
+            if (!itableMatchesMap(&t, present))
+                return nFalse;
+            if (op % (4 * ITABLE_CHECK_EVERY) == 0 && nITablePack(&t))
+                return nFalse;
+        }
+    }
+    if (!itableMatchesMap(&t, present))
+        return nFalse;
+    nITableDestroy(&t);
+    return nTrue;
+}
+
+/* Packing numbers nodes breadth-first and leaves no room to spare */
+static enum nBool
+itablePack()
+{
+    struct nITable      t;
+    uint32_t            k, dataOut;
+
+    if (nITableInit(&t, sizeof(k), sizeof(k), 100) || nITablePack(&t))
+        return nFalse;
+    for (k = 0; k < 40; k++)
+        if (nITableInsert(&t, &k, &k))
+            return nFalse;
+    for (k = 0; k < 40; k += 2)
+        if (nITableRemove(&t, &k))
+            return nFalse;
+    if (nITablePack(&t) || t.head != 0 || t.capacity != 20)
+        return nFalse;
+    for (k = 0; k < 40; k++) {
+        if (k % 2 ? nITablePeek(&t, &k, &dataOut) || dataOut != k
+            : nCodeNotFound != nITablePeek(&t, &k, &dataOut))
+            return nFalse;
+    }
+    k = 0;
+    if (nITableInsert(&t, &k, &k) || nITablePeek(&t, &k, &dataOut) || dataOut != 0)
+        return nFalse;
+    nITableDestroy(&t);
+    return nTrue;
+}
+
+static unsigned int             numItCalls;
+
+static enum nBool
+removeOddKeys(void *key, void *value)
+{
+    uint32_t            k;
+
+    /* Entries sit 2 bytes past a 4-byte boundary */
+    memcpy(&k, key, sizeof(k));
+    numItCalls++;
+    return k % 2 ? nTrue : nFalse;
+}
+
+static enum nBool
+itableForEachRemove()
+{
+    struct nITable      t;
+    uint32_t            k, dataOut;
+
+    if (nITableInit(&t, sizeof(k), sizeof(k), 0))
+        return nFalse;
+    for (k = 0; k < 100; k++)
+        if (nITableInsert(&t, &k, &k))
+            return nFalse;
+    numItCalls = 0;
+    nITableForEach(&t, removeOddKeys);
+    if (numItCalls != 100 || nITableSize(&t) != 50)
+        return nFalse;
+    for (k = 0; k < 100; k++)
+        if ((nITablePeek(&t, &k, &dataOut) == nCodeSuccess) == (k % 2))
+            return nFalse;
+    nITableDestroy(&t);
+    return nTrue;
+}
+
+/* Walks over a few long keys size their stack by the entries, not the key bits */
+#define LONG_KEY 4096
+#define LONG_KEYS 5
+
+static enum nBool
+countEntries(void *key, void *value)
+{
+    numItCalls++;
+    return nFalse;
+}
+
+static enum nBool
+itableForEachLongKeys()
+{
+    static unsigned char key[LONG_KEY];
+    struct nITable      t;
+    uint32_t            i;
+
+    if (nITableInit(&t, sizeof(key), sizeof(i), 0))
+        return nFalse;
+    for (i = 0; i < LONG_KEYS; i++) {
+        key[LONG_KEY - 1 - i] = 1;
+        if (nITableInsert(&t, key, &i))
+            return nFalse;
+    }
+    numItCalls = 0;
+    nITableForEach(&t, countEntries);
+    nITableDestroy(&t);
+    return numItCalls == LONG_KEYS;
+}
+
+struct testInfo                 itableTests[] = {
+    {itableSimple, "Index table insert, peek and remove succeed"},
+    {itableChurn, "Index table churn matches reference"},
+    {itablePack, "Packed index table keeps every entry"},
+    {itableForEachRemove, "Index table foreach removes requested entries"},
+    {itableForEachLongKeys, "Index table foreach visits a few long keys"},
+
+    {NULL, ""}
+};
@@ -176,6 +176,220 @@ nListForEachRemove()
     return nListEmpty(&feList);
 }
 
+/* Pooled list tests */
+
+static struct nList             poolList;
+
+static enum nBool
+nListPoolChurn()
+{
+    int                 i, outData;
+
+    nListInitPool(&poolList, sizeof(int), 4);
+    for (i = 0; i < 10; i++)
+        if (nListInsertTail(&poolList, &i))
+            return nFalse;
+    for (i = 0; i < 5; i++) {
+        if (nListRemoveHead(&poolList, &outData) || outData != i)
+            return nFalse;
+    }
+    for (i = 10; i < 15; i++)
+        if (nListInsertTail(&poolList, &i))
+            return nFalse;
+    for (i = 5; i < 15; i++) {
+        if (nListRemoveHead(&poolList, &outData) || outData != i)
+            return nFalse;
+    }
+    return nListEmpty(&poolList);
+}
+
+static enum nBool
+nListPoolDestroy()
+{
+    int                 i;
+
+    for (i = 0; i < 10; i++)
+        nListInsertHead(&poolList, &i);
+    nListDestroy(&poolList);
+    if (!nListEmpty(&poolList))
+        return nFalse;
+    /* The list is reusable after destruction */
+    if (nListInsertHead(&poolList, &i) || nListSize(&poolList) != 1)
+        return nFalse;
+    nListDestroy(&poolList);
+    return nListEmpty(&poolList);
+}
+
+static enum nBool
+nListDestroyUnpooled()
+{
+    int                 i;
+
+    nListInit(&poolList, sizeof(int));
+    nListDestroy(&poolList);
+    for (i = 0; i < 10; i++)
+        nListInsertTail(&poolList, &i);
+    nListDestroy(&poolList);
+    return nListEmpty(&poolList);
+}
+
+/* Bulk insert and remove */
+
+#define BULK_NUM_ELEM 30
+
+static struct nList             bulkList;
+
+static enum nBool
+nListBulkInsertRemove()
+{
+    int                 in[BULK_NUM_ELEM], out[BULK_NUM_ELEM], one = -1, i;
+
+    for (i = 0; i < BULK_NUM_ELEM; i++)
+        in[i] = i;
+    nListInit(&bulkList, sizeof(int));
+    if (nListInsertTailN(&bulkList, in, BULK_NUM_ELEM / 2))
+        return nFalse;
+    nListInsertHead(&bulkList, &one);
+    if (nListInsertTailN(&bulkList, in + BULK_NUM_ELEM / 2, BULK_NUM_ELEM / 2))
+        return nFalse;
+    if (nListSize(&bulkList) != BULK_NUM_ELEM + 1)
+        return nFalse;
+    if (nListRemoveHeadN(&bulkList, out, 1) || out[0] != one)
+        return nFalse;
+    if (nListRemoveHeadN(&bulkList, out, BULK_NUM_ELEM - 1))
+        return nFalse;
+    for (i = 0; i < BULK_NUM_ELEM - 1; i++) {
+        if (out[i] != in[i])
+            return nFalse;
+    }
+    /* The remaining element is still linked correctly */
+    if (nListRemoveTail(&bulkList, &one) || one != in[BULK_NUM_ELEM - 1])
+        return nFalse;
+    return nListEmpty(&bulkList);
+}
+
+static enum nBool
+nListBulkLimits()
+{
+    int                 in[2] = {1, 2}, out[3];
+
+    if (nListInsertTailN(&bulkList, in, 0) || nListRemoveHeadN(&bulkList, out, 0))
+        return nFalse;
+    nListInsertTailN(&bulkList, in, 2);
+    if (nCodeEmpty != nListRemoveHeadN(&bulkList, out, 3))
+        return nFalse;
+    if (nListRemoveHeadN(&bulkList, out, 2) || out[0] != 1 || out[1] != 2)
+        return nFalse;
+    return nListEmpty(&bulkList);
+}
+
+/* Intrusive list */
+
+#define ILIST_NUM_ELEM 10
+
+struct record {
+    int                 id;
+    struct nListLink    link;
+    char                payload[20];
+};
+
+static struct record            records[ILIST_NUM_ELEM];
+static struct nIList            iList;
+
+static int
+recordId(struct nListLink *link)
+{
+    return nListEntry(link, struct record, link)->id;
+}
+
+/* The ids from head to tail must match expected */
+static enum nBool
+iListMatches(const int *expected, size_t numExpected)
+{
+    struct nListLink   *link;
+    size_t              i = 0;
+
+    if (nIListSize(&iList) != numExpected)
+        return nFalse;
+    for (link = nIListFirst(&iList); link; link = nIListNext(&iList, link)) {
+        if (i >= numExpected || recordId(link) != expected[i++])
+            return nFalse;
+    }
+    return i == numExpected;
+}
+
+static enum nBool
+nIListInsertRemove()
+{
+    struct nListLink   *out;
+    int                 i;
+
+    nIListInit(&iList);
+    if (!nIListEmpty(&iList) || nIListFirst(&iList) || nCodeEmpty != nIListRemoveHead(&iList, &out))
+        return nFalse;
+    for (i = 0; i < ILIST_NUM_ELEM; i++)
+        records[i].id = i;
+    for (i = 0; i < 3; i++)
+        nIListInsertHead(&iList, &records[i].link);
+    for (i = 3; i < 6; i++)
+        nIListInsertTail(&iList, &records[i].link);
+    if (!iListMatches((int[]) {2, 1, 0, 3, 4, 5}, 6))
+        return nFalse;
+
+    /* The record comes back in place, not as a copy */
+    if (nIListRemoveHead(&iList, &out) || out != &records[2].link)
+        return nFalse;
+    if (nIListRemoveTail(&iList, &out) || nListEntry(out, struct record, link) != &records[5])
+        return nFalse;
+    return iListMatches((int[]) {1, 0, 3, 4}, 4);
+}
+
+/* Depends on nIListInsertRemove */
+static enum nBool
+nIListRemoveAny()
+{
+    struct nListLink   *out;
+
+    nIListRemove(&iList, &records[0].link);   /* middle */
+    if (!iListMatches((int[]) {1, 3, 4}, 3))
+        return nFalse;
+    nIListRemove(&iList, &records[1].link);   /* head */
+    nIListRemove(&iList, &records[4].link);   /* tail */
+    if (!iListMatches((int[]) {3}, 1))
+        return nFalse;
+    nIListRemove(&iList, &records[3].link);   /* last */
+    if (!nIListEmpty(&iList) || nCodeEmpty != nIListRemoveTail(&iList, &out))
+        return nFalse;
+
+    /* A removed record can go back on the list */
+    nIListInsertTail(&iList, &records[0].link);
+    nIListInsertTail(&iList, &records[3].link);
+    return iListMatches((int[]) {0, 3}, 2);
+}
+
+static enum nBool
+removeEvenRecords(struct nListLink *link)
+{
+    numFeCalls++;
+    return recordId(link) % 2 == 0;
+}
+
+/* Depends on nIListRemoveAny */
+static enum nBool
+nIListForEachRemove()
+{
+    int                 i;
+
+    nIListInit(&iList);
+    for (i = 0; i < ILIST_NUM_ELEM; i++)
+        nIListInsertTail(&iList, &records[i].link);
+    numFeCalls = 0;
+    nIListForEach(&iList, removeEvenRecords);
+    if (numFeCalls != ILIST_NUM_ELEM)
+        return nFalse;
+    return iListMatches((int[]) {1, 3, 5, 7, 9}, 5);
+}
+
 struct testInfo                 listTests[] = {
 
     /* Simple stack */
@@ -192,6 +406,20 @@ struct testInfo                 listTests[] = {
     {nListForEachBlank, "ForEach on multi-list"},
     {nListForEachRemove, "ForEach remove first and last element"},
 
+    /* Pooled list and destruction */
+    {nListPoolChurn, "Pooled list recycles nodes in order"},
+    {nListPoolDestroy, "Destroying pooled list releases everything"},
+    {nListDestroyUnpooled, "Destroying unpooled list empties it"},
+
+    /* Bulk operations */
+    {nListBulkInsertRemove, "Bulk insert and remove keep element order"},
+    {nListBulkLimits, "Bulk removal is all or nothing"},
+
+    /* Intrusive list */
+    {nIListInsertRemove, "Intrusive list links records in place"},
+    {nIListRemoveAny, "Intrusive list removes any record"},
+    {nIListForEachRemove, "Intrusive list foreach removes requested records"},
+
     {NULL, ""}
 
 };
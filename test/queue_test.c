@@ -0,0 +1,168 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+#include "nanodtypes.h"
+#include "test.h"
+
+/* Single-threaded use */
+
+static enum nBool
+queueFullEmpty()
+{
+    struct nQueue       q;
+    uint32_t            i, value;
+
+    if (nCodeBadInput != nQueueInit(&q, 0, sizeof(value)))
+        return nFalse;
+    if (nQueueInit(&q, 5, sizeof(value)))
+        return nFalse;
+    if (!nQueueEmpty(&q) || nCodeEmpty != nQueueRemoveHead(&q, &value))
+        return nFalse;
+
+    /* Capacity rounds up to 8 */
+    for (i = 0; i < 8; i++)
+        if (nQueueInsertTail(&q, &i))
+            return nFalse;
+    if (nCodeFull != nQueueInsertTail(&q, &i) || nQueueSize(&q) != 8)
+        return nFalse;
+    for (i = 0; i < 8; i++)
+        if (nQueueRemoveHead(&q, &value) || value != i)
+            return nFalse;
+    if (nCodeEmpty != nQueueRemoveHead(&q, &value))
+        return nFalse;
+    nQueueDestroy(&q);
+    return nTrue;
+}
+
+/* Elements keep their order as the ring wraps many times */
+static enum nBool
+queueWrap()
+{
+    struct nQueue       q;
+    char                elem[3], out[3];
+    int                 i, inserted = 0, removed = 0;
+
+    if (nQueueInitSPSC(&q, 4, sizeof(elem)))
+        return nFalse;
+    for (i = 0; i < 1000; i++) {
+        elem[0] = inserted;
+        elem[2] = -inserted;
+        if (!nQueueInsertTail(&q, elem))
+            inserted++;
+        if (i % 3 && !nQueueRemoveHead(&q, out)) {
+            if (out[0] != (char)removed || out[2] != (char)-removed)
+                return nFalse;
+            removed++;
+        }
+    }
+    if (nQueueSize(&q) != (size_t)(inserted - removed))
+        return nFalse;
+    nQueueDestroy(&q);
+    return nTrue;
+}
+
+/*
+ * Producers each insert an increasing sequence tagged with their number;
+ * consumers check that every producer's elements arrive in order and
+ * that nothing is lost or duplicated
+ */
+
+#define QUEUE_THREAD_ITEMS 100000
+#define QUEUE_MAX_THREADS 4
+
+static struct nQueue            threadQueue;
+static int                      numProducers;
+static uint64_t                 consumedTotal;
+static int                      producersDone;
+
+static void                    *
+queueProducer(void *arg)
+{
+    uint64_t            producer = (uintptr_t)arg, i, item;
+
+    for (i = 0; i < QUEUE_THREAD_ITEMS; i++) {
+        item = producer << 32 | i;
+        while (nQueueInsertTail(&threadQueue, &item))
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void                    *
+queueConsumer(void *arg)
+{
+    uint64_t            next[QUEUE_MAX_THREADS] = {0}, item, sum = 0;
+    int                 producer;
+
+    for (;;) {
+        if (nQueueRemoveHead(&threadQueue, &item)) {
+            if (__atomic_load_n(&producersDone, __ATOMIC_ACQUIRE) && nQueueEmpty(&threadQueue))
+                break;
+            sched_yield();
+            continue;
+        }
+        producer = item >> 32;
+        if (producer >= numProducers || (item & 0xffffffff) < next[producer])
+            return arg;
+        next[producer] = (item & 0xffffffff) + 1;
+        sum += item & 0xffffffff;
+    }
+    __atomic_add_fetch(&consumedTotal, sum, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static enum nBool
+queueThreads(int producers, int consumers, enum nBool spsc)
+{
+    pthread_t           threads[2 * QUEUE_MAX_THREADS];
+    void               *failed;
+    enum nBool          result = nTrue;
+    uint64_t            expected = (uint64_t)QUEUE_THREAD_ITEMS * (QUEUE_THREAD_ITEMS - 1) / 2;
+    int                 i;
+
+    if ((spsc ? nQueueInitSPSC : nQueueInit) (&threadQueue, 64, sizeof(uint64_t)))
+        return nFalse;
+    numProducers = producers;
+    consumedTotal = 0;
+    producersDone = 0;
+    for (i = 0; i < consumers; i++)
+        if (pthread_create(&threads[producers + i], NULL, queueConsumer, (void *)1))
+            return nFalse;
+    for (i = 0; i < producers; i++)
+        if (pthread_create(&threads[i], NULL, queueProducer, (void *)(uintptr_t)i))
+            return nFalse;
+    for (i = 0; i < producers; i++)
+        pthread_join(threads[i], NULL);
+    __atomic_store_n(&producersDone, 1, __ATOMIC_RELEASE);
+    for (i = 0; i < consumers; i++) {
+        pthread_join(threads[producers + i], &failed);
+        if (failed)
+            result = nFalse;
+    }
+    if (consumedTotal != expected * producers)
+        result = nFalse;
+    nQueueDestroy(&threadQueue);
+    return result;
+}
+
+static enum nBool
+queueSPSCThreads()
+{
+    return queueThreads(1, 1, nTrue);
+}
+
+static enum nBool
+queueMPMCThreads()
+{
+    return queueThreads(QUEUE_MAX_THREADS, QUEUE_MAX_THREADS, nFalse);
+}
+
+struct testInfo                 queueTests[] = {
+    {queueFullEmpty, "Queue reports full and empty"},
+    {queueWrap, "Queue keeps order across wrap-around"},
+    {queueSPSCThreads, "Single producer and consumer lose nothing"},
+    {queueMPMCThreads, "Many producers and consumers lose nothing"},
+
+    {NULL, ""}
+};
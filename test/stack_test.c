@@ -192,6 +192,277 @@ numberPushPop()
     return nTrue;
 }
 
+/* Tests on a growable stack */
+
+#define GROW_NUM_ELEM 1000
+#define GROW_LIMIT 1024
+
+static struct nStack            growStack;
+
+static enum nBool
+growBadInput()
+{
+    if (nCodeBadInput != nStackInitG(&growStack, 0, 0, sizeof(int)))
+        return nFalse;
+    if (nCodeBadInput != nStackInitG(&growStack, 8, 4, sizeof(int)))
+        return nFalse;
+    return nTrue;
+}
+
+static enum nBool
+growPushPop()
+{
+    int                 i, out;
+
+    if (nStackInitG(&growStack, 2, GROW_LIMIT, sizeof(int)))
+        return nFalse;
+    for (i = 0; i < GROW_NUM_ELEM; i++) {
+        if (nStackPush(&growStack, &i) || nStackFull(&growStack))
+            return nFalse;
+    }
+    if (nStackPeek(&growStack, &out) || out != GROW_NUM_ELEM - 1)
+        return nFalse;
+    for (i = GROW_NUM_ELEM - 1; i >= 0; i--) {
+        if (nStackPop(&growStack, &out) || out != i)
+            return nFalse;
+    }
+    return nStackEmpty(&growStack);
+}
+
+/* Depends on growPushPop */
+static enum nBool
+growShrinks()
+{
+    /* Popping back to empty must have released most of the buffer */
+    return growStack.maxElem < 8;
+}
+
+static enum nBool
+growLimit()
+{
+    int                 i;
+
+    for (i = 0; i < GROW_LIMIT; i++) {
+        if (nStackPush(&growStack, &i))
+            return nFalse;
+    }
+    if (!nStackFull(&growStack))
+        return nFalse;
+    if (nCodeFull != nStackPush(&growStack, &i))
+        return nFalse;
+    return nStackSize(&growStack) == GROW_LIMIT;
+}
+
+static enum nBool
+growReserve()
+{
+    int                 i, out;
+
+    nStackDestroy(&growStack);
+    if (nStackInitG(&growStack, 1, 0, sizeof(int)))
+        return nFalse;
+    if (nStackReserve(&growStack, 100) || growStack.maxElem != 100)
+        return nFalse;
+    for (i = 0; i < 2; i++)
+        nStackPush(&growStack, &i);
+    for (i = 0; i < 2; i++)
+        nStackPop(&growStack, &out);
+    /* Reserved room is kept after popping */
+    if (growStack.maxElem != 100)
+        return nFalse;
+    if (nCodeFull != nStackReserve(&simpleStack, 100))
+        return nFalse;
+    nStackDestroy(&growStack);
+    return nTrue;
+}
+
+/* Bulk push and pop */
+
+#define BULK_NUM_ELEM 40
+
+static struct nStack            bulkStack;
+
+static enum nBool
+bulkPushPop()
+{
+    short               in[BULK_NUM_ELEM], out[BULK_NUM_ELEM], one;
+    int                 i;
+
+    for (i = 0; i < BULK_NUM_ELEM; i++)
+        in[i] = i * 3;
+    if (nStackInitM(&bulkStack, BULK_NUM_ELEM, sizeof(short)))
+        return nFalse;
+    if (nStackPushN(&bulkStack, in, BULK_NUM_ELEM / 2))
+        return nFalse;
+    if (nStackPushN(&bulkStack, in + BULK_NUM_ELEM / 2, BULK_NUM_ELEM / 2))
+        return nFalse;
+    /* Single pops see the last element pushed first */
+    if (nStackPop(&bulkStack, &one) || one != in[BULK_NUM_ELEM - 1])
+        return nFalse;
+    if (nStackPopN(&bulkStack, out, BULK_NUM_ELEM - 1))
+        return nFalse;
+    for (i = 0; i < BULK_NUM_ELEM - 1; i++) {
+        if (out[i] != in[i])
+            return nFalse;
+    }
+    return nStackEmpty(&bulkStack);
+}
+
+static enum nBool
+bulkLimits()
+{
+    short               in[BULK_NUM_ELEM + 1] = {0};
+
+    if (nCodeFull != nStackPushN(&bulkStack, in, BULK_NUM_ELEM + 1))
+        return nFalse;
+    if (nStackPushN(&bulkStack, in, 2))
+        return nFalse;
+    if (nCodeEmpty != nStackPopN(&bulkStack, in, 3) || nStackSize(&bulkStack) != 2)
+        return nFalse;
+    nStackDestroy(&bulkStack);
+
+    /* A growable stack grows to fit the whole batch */
+    if (nStackInitG(&bulkStack, 1, 0, sizeof(short)))
+        return nFalse;
+    if (nStackPushN(&bulkStack, in, BULK_NUM_ELEM + 1))
+        return nFalse;
+    if (nStackSize(&bulkStack) != BULK_NUM_ELEM + 1)
+        return nFalse;
+    nStackDestroy(&bulkStack);
+    return nTrue;
+}
+
+/* Segmented stack */
+
+#define SEG_BLOCK 5
+#define SEG_NUM_ELEM 101
+
+static enum nBool
+segmentPushPop()
+{
+    struct nStack       s;
+    int                 i, out;
+
+    if (nCodeBadInput != nStackInitS(&s, 0, 0, sizeof(int)))
+        return nFalse;
+    if (nStackInitS(&s, SEG_BLOCK, 0, sizeof(int)))
+        return nFalse;
+    for (i = 0; i < SEG_NUM_ELEM; i++) {
+        if (nStackPush(&s, &i) || nStackFull(&s))
+            return nFalse;
+        if (nStackPeek(&s, &out) || out != i)
+            return nFalse;
+    }
+
+    /* The top element sits alone in its block: back and forth across the edge */
+    for (i = 0; i < 4; i++) {
+        if (nStackPop(&s, &out) || out != SEG_NUM_ELEM - 1 || nStackPush(&s, &out))
+            return nFalse;
+    }
+    for (i = SEG_NUM_ELEM - 1; i >= 0; i--) {
+        if (nStackPeek(&s, &out) || out != i || nStackPop(&s, &out) || out != i)
+            return nFalse;
+    }
+    if (!nStackEmpty(&s) || nCodeEmpty != nStackPop(&s, &out))
+        return nFalse;
+
+    /* The stack can be filled again after emptying */
+    for (i = 0; i < SEG_NUM_ELEM; i++)
+        if (nStackPush(&s, &i))
+            return nFalse;
+    nStackDestroy(&s);
+    return nStackEmpty(&s);
+}
+
+static enum nBool
+segmentLimit()
+{
+    struct nStack       s;
+    int                 i, in[SEG_NUM_ELEM];
+
+    if (nStackInitS(&s, SEG_BLOCK, SEG_NUM_ELEM, sizeof(int)))
+        return nFalse;
+    if (nCodeFull != nStackReserve(&s, SEG_NUM_ELEM + 1) || nStackReserve(&s, SEG_NUM_ELEM))
+        return nFalse;
+    for (i = 0; i < SEG_NUM_ELEM - 1; i++)
+        if (nStackPush(&s, &i))
+            return nFalse;
+    if (nCodeFull != nStackPushN(&s, in, 2) || nStackSize(&s) != SEG_NUM_ELEM - 1)
+        return nFalse;
+    if (nStackPush(&s, &i) || !nStackFull(&s) || nCodeFull != nStackPush(&s, &i))
+        return nFalse;
+    nStackDestroy(&s);
+    return nTrue;
+}
+
+/* Bulk calls spanning several blocks keep element order */
+static enum nBool
+segmentBulk()
+{
+    struct nStack       s;
+    int                 i, in[SEG_NUM_ELEM], out[SEG_NUM_ELEM], one;
+
+    for (i = 0; i < SEG_NUM_ELEM; i++)
+        in[i] = i * 7;
+    if (nStackInitS(&s, SEG_BLOCK, 0, sizeof(int)))
+        return nFalse;
+    if (nStackPush(&s, in) || nStackPushN(&s, in + 1, 12) || nStackPushN(&s, in + 13, SEG_NUM_ELEM - 13))
+        return nFalse;
+    if (nStackPop(&s, &one) || one != in[SEG_NUM_ELEM - 1])
+        return nFalse;
+    if (nCodeEmpty != nStackPopN(&s, out, SEG_NUM_ELEM) || nStackSize(&s) != SEG_NUM_ELEM - 1)
+        return nFalse;
+    if (nStackPopN(&s, out + 30, SEG_NUM_ELEM - 31) || nStackPopN(&s, out, 30))
+        return nFalse;
+    for (i = 0; i < SEG_NUM_ELEM - 1; i++) {
+        if (out[i] != in[i])
+            return nFalse;
+    }
+    nStackDestroy(&s);
+    return nTrue;
+}
+
+/* In-place access */
+
+static enum nBool
+slotPushTop()
+{
+    struct nStack       s;
+    int                 i, out, *slot, *top;
+
+    nStackInitM(&s, 2, sizeof(int));
+    if (nCodeEmpty != nStackTop(&s, (void **)&top))
+        return nFalse;
+    for (i = 0; i < 2; i++) {
+        if (nStackPushSlot(&s, (void **)&slot))
+            return nFalse;
+        *slot = i + 10;
+        if (nStackTop(&s, (void **)&top) || top != slot)
+            return nFalse;
+    }
+    if (nCodeFull != nStackPushSlot(&s, (void **)&slot) || nStackSize(&s) != 2)
+        return nFalse;
+
+    /* Writes through the top pointer are what pop returns */
+    *top = 99;
+    if (nStackPop(&s, &out) || out != 99 || nStackPop(&s, &out) || out != 10)
+        return nFalse;
+    nStackDestroy(&s);
+
+    /* Slots on a growable or segmented stack are pushed like elements */
+    nStackInitS(&s, SEG_BLOCK, 0, sizeof(int));
+    for (i = 0; i < SEG_NUM_ELEM; i++) {
+        if (nStackPushSlot(&s, (void **)&slot))
+            return nFalse;
+        *slot = i;
+    }
+    for (i = SEG_NUM_ELEM - 1; i >= 0; i--)
+        if (nStackTop(&s, (void **)&top) || *top != i || nStackPop(&s, &out))
+            return nFalse;
+    nStackDestroy(&s);
+    return nTrue;
+}
+
 /* Test list */
 
 struct testInfo                 stackTests[] = {
@@ -220,6 +491,25 @@ struct testInfo                 stackTests[] = {
     /* Numbered stack */
     {numberPushPop, "Example with short member works"},
 
+    /* Growable stack */
+    {growBadInput, "Growable stack rejects bad sizes"},
+    {growPushPop, "Growable stack grows past initial size"},
+    {growShrinks, "Growable stack shrinks when emptied"},
+    {growLimit, "Growable stack stops at its limit"},
+    {growReserve, "Reserved room is kept"},
+
+    /* Bulk operations */
+    {bulkPushPop, "Bulk push and pop keep element order"},
+    {bulkLimits, "Bulk push and pop are all or nothing"},
+
+    /* Segmented stack */
+    {segmentPushPop, "Segmented stack pushes and pops across blocks"},
+    {segmentLimit, "Segmented stack stops at its limit"},
+    {segmentBulk, "Bulk calls on a segmented stack keep order"},
+
+    /* In-place access */
+    {slotPushTop, "Pushing a slot and writing through the top pointer"},
+
     {NULL, ""}
 
 };
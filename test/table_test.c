@@ -1,3 +1,8 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
 #include "nanodtypes.h"
 #include "test.h"
 
@@ -133,6 +138,1286 @@ removeLeft()
     return nTrue;
 }
 
+/* Pooled table and destruction */
+
+#define MANY_KEYS 200
+
+struct nTable                   poolTable;
+
+static enum nBool
+fillMany(struct nTable *t)
+{
+    short               k, dataOut;
+
+    for (k = 0; k < MANY_KEYS; k++) {
+        if (nTableInsert(t, &k, &k))
+            return nFalse;
+    }
+    for (k = 0; k < MANY_KEYS; k += 2) {
+        if (nTableRemove(t, &k))
+            return nFalse;
+    }
+    for (k = 0; k < MANY_KEYS; k++) {
+        if (k % 2 && (nTablePeek(t, &k, &dataOut) || dataOut != k))
+            return nFalse;
+        if (!(k % 2) && nCodeNotFound != nTablePeek(t, &k, &dataOut))
+            return nFalse;
+    }
+    return nTableSize(t) == MANY_KEYS / 2;
+}
+
+static enum nBool
+poolInsertRemove()
+{
+    nTableInitPool(&poolTable, sizeof(short), sizeof(short), 16);
+    return fillMany(&poolTable);
+}
+
+static enum nBool
+poolDestroy()
+{
+    short               k = 7, dataOut;
+
+    nTableDestroy(&poolTable);
+    if (!nTableEmpty(&poolTable))
+        return nFalse;
+    if (nCodeNotFound != nTablePeek(&poolTable, &k, &dataOut))
+        return nFalse;
+    /* The table is reusable after destruction */
+    if (!fillMany(&poolTable))
+        return nFalse;
+    nTableDestroy(&poolTable);
+    return nTableEmpty(&poolTable);
+}
+
+static enum nBool
+destroyUnpooled()
+{
+    nTableInit(&poolTable, sizeof(short), sizeof(short));
+    nTableDestroy(&poolTable);
+    if (!fillMany(&poolTable))
+        return nFalse;
+    nTableDestroy(&poolTable);
+    return nTableEmpty(&poolTable);
+}
+
+/* ForEach tests */
+
+#define FE_KEYS 500
+
+struct nTable                   feTable;
+static unsigned int             numFeCalls;
+static long                     feKeySum;
+
+static enum nBool
+tableIterFuncCount(void *key, void *value)
+{
+    numFeCalls++;
+    feKeySum += *(short *)key;
+    return *(short *)key != *(short *)value;
+}
+
+static enum nBool
+tableIterFuncRemoveEven(void *key, void *value)
+{
+    numFeCalls++;
+    return *(short *)key % 2 == 0;
+}
+
+static enum nBool
+forEachEmpty()
+{
+    nTableInit(&feTable, sizeof(short), sizeof(short));
+    numFeCalls = 0;
+    nTableForEach(&feTable, tableIterFuncCount);
+    return numFeCalls == 0;
+}
+
+static enum nBool
+forEachVisitsOnce()
+{
+    short               k;
+    long                expectedSum = 0;
+
+    /* Includes the all-zero key and negative keys */
+    for (k = -FE_KEYS / 2; k < FE_KEYS / 2; k++) {
+        nTableInsert(&feTable, &k, &k);
+        expectedSum += k;
+    }
+    numFeCalls = 0;
+    feKeySum = 0;
+    nTableForEach(&feTable, tableIterFuncCount);
+    if (numFeCalls != FE_KEYS || feKeySum != expectedSum)
+        return nFalse;
+    return nTableSize(&feTable) == FE_KEYS;
+}
+
+static enum nBool
+forEachRemove()
+{
+    short               k, dataOut;
+
+    numFeCalls = 0;
+    nTableForEach(&feTable, tableIterFuncRemoveEven);
+    if (numFeCalls != FE_KEYS || nTableSize(&feTable) != FE_KEYS / 2)
+        return nFalse;
+    for (k = -FE_KEYS / 2; k < FE_KEYS / 2; k++) {
+        if ((k % 2 == 0) != (nTablePeek(&feTable, &k, &dataOut) == nCodeNotFound))
+            return nFalse;
+    }
+    nTableDestroy(&feTable);
+    return nTrue;
+}
+
+/* Batched lookups */
+
+#define BATCH_KEYS 300
+
+struct nTable                   batchTable;
+
+static enum nBool
+batchPeekEmpty()
+{
+    short               batchKeys[2] = {1, 2}, values[2];
+    enum nErrorType     status[2];
+
+    nTableInit(&batchTable, sizeof(short), sizeof(short));
+    if (nTablePeekBatch(&batchTable, batchKeys, 2, values, status))
+        return nFalse;
+    return status[0] == nCodeNotFound && status[1] == nCodeNotFound;
+}
+
+static enum nBool
+batchPeekMatchesPeek()
+{
+    short               k, batchKeys[BATCH_KEYS], values[BATCH_KEYS], dataOut;
+    enum nErrorType     status[BATCH_KEYS];
+    size_t              numFound = 0, i;
+
+    for (k = 1; k < 200; k += 2)
+        nTableInsert(&batchTable, &k, &k);
+    for (i = 0; i < BATCH_KEYS; i++)
+        batchKeys[i] = (i * 37) % BATCH_KEYS - 50;
+
+    if (nTablePeekBatch(&batchTable, batchKeys, BATCH_KEYS, values, status) != 100)
+        return nFalse;
+    for (i = 0; i < BATCH_KEYS; i++) {
+        if (status[i] != nTablePeek(&batchTable, batchKeys + i, &dataOut))
+            return nFalse;
+        if (status[i] == nCodeSuccess && values[i] != dataOut)
+            return nFalse;
+        numFound += status[i] == nCodeSuccess;
+    }
+    nTableDestroy(&batchTable);
+    return numFound == 100;
+}
+
+/* Random inserts and removals checked against a presence map */
+
+#define CHURN_OPS 20000
+#define CHURN_KEY_RANGE 4096
+
+struct nTable                   churnTable;
+
+static enum nBool
+randomChurn()
+{
+    static unsigned short present[CHURN_KEY_RANGE];
+    unsigned long       seed = 12345;
+    unsigned short      k, dataIn, dataOut;
+    size_t              expectedSize = 0;
+    int                 op;
+
+    nTableInit(&churnTable, sizeof(k), sizeof(dataIn));
+    for (op = 0; op < CHURN_OPS; op++) {
+        seed = seed * 1103515245 + 12345;
+        k = (seed >> 8) % CHURN_KEY_RANGE;
+        dataIn = op & 0xffff;
+        if ((seed >> 24) % 3) {
+            if (nTableInsert(&churnTable, &k, &dataIn))
+                return nFalse;
+            if (!present[k])
+                expectedSize++;
+            present[k] = dataIn + 1;
+        } else {
+            if (nTableRemove(&churnTable, &k) != (present[k] ? nCodeSuccess : nCodeNotFound))
+                return nFalse;
+            if (present[k])
+                expectedSize--;
+            present[k] = 0;
+        }
+        if (nTableSize(&churnTable) != expectedSize)
+            return nFalse;
+    }
+    for (k = 0; k < CHURN_KEY_RANGE; k++) {
+        if (present[k] && (nTablePeek(&churnTable, &k, &dataOut) || dataOut + 1 != present[k]))
+            return nFalse;
+        if (!present[k] && nCodeNotFound != nTablePeek(&churnTable, &k, &dataOut))
+            return nFalse;
+    }
+    nTableDestroy(&churnTable);
+    return nTrue;
+}
+
+/* Wide keys differing in one bit each, spanning whole words and a tail */
+
+#define WIDE_KEY_SIZE 20
+
+struct nTable                   wideTable;
+
+static void
+setWideKey(unsigned char *key, int bit)
+{
+    memset(key, 0, WIDE_KEY_SIZE);
+    if (bit >= 0)
+        key[bit / 8] = 0x80 >> (bit % 8);
+}
+
+static enum nBool
+wideSingleBits()
+{
+    unsigned char       key[WIDE_KEY_SIZE];
+    int                 bit, dataOut;
+
+    nTableInit(&wideTable, WIDE_KEY_SIZE, sizeof(bit));
+    for (bit = -1; bit < WIDE_KEY_SIZE * 8; bit++) {
+        setWideKey(key, bit);
+        if (nTableInsert(&wideTable, key, &bit))
+            return nFalse;
+    }
+    for (bit = -1; bit < WIDE_KEY_SIZE * 8; bit++) {
+        setWideKey(key, bit);
+        if (nTablePeek(&wideTable, key, &dataOut) || dataOut != bit)
+            return nFalse;
+    }
+    for (bit = WIDE_KEY_SIZE * 8 - 1; bit >= -1; bit -= 2) {
+        setWideKey(key, bit);
+        if (nTableRemove(&wideTable, key))
+            return nFalse;
+    }
+    for (bit = -1; bit < WIDE_KEY_SIZE * 8; bit++) {
+        setWideKey(key, bit);
+        if ((bit % 2 != 0) != (nTablePeek(&wideTable, key, &dataOut) == nCodeNotFound))
+            return nFalse;
+    }
+    numFeCalls = 0;
+    nTableForEach(&wideTable, tableIterFuncRemoveEven);
+    if (numFeCalls != WIDE_KEY_SIZE * 8 / 2)
+        return nFalse;
+    nTableDestroy(&wideTable);
+    return nTrue;
+}
+
+/*
+ * Keys of 8 KB, whose bit offsets run past 32767, churned and walked in
+ * order. Keys differ only in bytes past the first 4 KB.
+ */
+
+#define HUGE_KEY_SIZE 8192
+#define HUGE_KEYS 64
+#define HUGE_OPS 2000
+
+static unsigned char            hugeKeys[HUGE_KEYS][HUGE_KEY_SIZE];
+
+static enum nBool
+hugeKeysMatch(struct nTable *t, const unsigned short *present)
+{
+    struct nTableCursor c;
+    unsigned short      dataOut;
+    const void         *prevKey = NULL;
+    size_t              k, walked = 0;
+    enum nErrorType     ret;
+
+    for (k = 0; k < HUGE_KEYS; k++) {
+        if (present[k] && (nTablePeek(t, hugeKeys[k], &dataOut) || dataOut + 1 != present[k]))
+            return nFalse;
+        if (!present[k] && nCodeNotFound != nTablePeek(t, hugeKeys[k], &dataOut))
+            return nFalse;
+    }
+    for (ret = nTableFirst(t, &c); !ret; ret = nTableNext(&c)) {
+        if (prevKey && memcmp(prevKey, c.key, HUGE_KEY_SIZE) >= 0) {
+            nTableCursorDestroy(&c);
+            return nFalse;
+        }
+        prevKey = c.key;
+        walked++;
+    }
+    return walked == nTableSize(t);
+}
+
+static enum nBool
+hugeKeyChurn()
+{
+    static unsigned short present[HUGE_KEYS];
+    struct nTable       t;
+    unsigned long       seed = 4242;
+    unsigned short      dataIn;
+    size_t              k;
+    int                 op;
+
+    if (nCodeBadInput != nTableInit(&t, (size_t)1 << 31, sizeof(dataIn)))
+        return nFalse;
+    if (nCodeBadInput != nTableInitPrefix(&t, (size_t)1 << 30, sizeof(dataIn), 0))
+        return nFalse;
+
+    /* Key 0 is the all-zero key */
+    for (k = 1; k < HUGE_KEYS; k++) {
+        hugeKeys[k][HUGE_KEY_SIZE - 1] = k;
+        hugeKeys[k][4100 + k * 37 % 4000] = 0x80 >> k % 8;
+    }
+    if (nTableInit(&t, HUGE_KEY_SIZE, sizeof(dataIn)))
+        return nFalse;
+    for (op = 0; op < HUGE_OPS; op++) {
+        seed = seed * 1103515245 + 12345;
+        k = (seed >> 8) % HUGE_KEYS;
+        dataIn = op;
+        if ((seed >> 24) % 3) {
+            if (nTableInsert(&t, hugeKeys[k], &dataIn))
+                return nFalse;
+            present[k] = dataIn + 1;
+        } else {
+            if (nTableRemove(&t, hugeKeys[k]) != (present[k] ? nCodeSuccess : nCodeNotFound))
+                return nFalse;
+            present[k] = 0;
+        }
+        if (op % 100 == 0 && !hugeKeysMatch(&t, present))
+            return nFalse;
+    }
+    if (!hugeKeysMatch(&t, present))
+        return nFalse;
+    nTableDestroy(&t);
+    return nTrue;
+}
+
+/* Variable-length keys */
+
+struct nTable                   varTable;
+
+static const char              *varKeys[] = {"", "a", "ab", "abc", "abc\0", "abd", "b", "ba"};
+static const size_t             varKeyLens[] = {0, 1, 2, 3, 4, 3, 1, 2};
+#define NUM_VAR_KEYS (sizeof(varKeyLens) / sizeof(varKeyLens[0]))
+
+static enum nBool
+varPrefixKeys()
+{
+    unsigned int        i, j, value;
+
+    nTableInitVar(&varTable, sizeof(value), 0);
+    for (i = 0; i < NUM_VAR_KEYS; i++)
+        if (nTableInsertVar(&varTable, varKeys[i], varKeyLens[i], &i))
+            return nFalse;
+    if (nTableSize(&varTable) != NUM_VAR_KEYS)
+        return nFalse;
+    if (nCodeNotFound != nTablePeekVar(&varTable, "abcd", 4, &value))
+        return nFalse;
+    if (nCodeNotFound != nTablePeekVar(&varTable, "\0", 1, &value))
+        return nFalse;
+
+    /* Remove keys one at a time, checking the rest each time */
+    for (i = 0; i < NUM_VAR_KEYS; i++) {
+        for (j = i; j < NUM_VAR_KEYS; j++)
+            if (nTablePeekVar(&varTable, varKeys[j], varKeyLens[j], &value) || value != j)
+                return nFalse;
+        if (nTableRemoveVar(&varTable, varKeys[i], varKeyLens[i]))
+            return nFalse;
+        if (nCodeNotFound != nTablePeekVar(&varTable, varKeys[i], varKeyLens[i], &value))
+            return nFalse;
+    }
+    if (!nTableEmpty(&varTable))
+        return nFalse;
+    nTableDestroy(&varTable);
+    return nTrue;
+}
+
+static enum nBool
+varWrongCalls()
+{
+    struct nTable       fixedTable;
+    unsigned int        value = 0;
+    enum nErrorType     status;
+
+    nTableInitVar(&varTable, sizeof(value), 0);
+    if (nCodeBadInput != nTableInsert(&varTable, "abcd", &value))
+        return nFalse;
+    if (nTablePeekBatch(&varTable, "abcd", 1, &value, &status) || status != nCodeBadInput)
+        return nFalse;
+    nTableDestroy(&varTable);
+
+    nTableInit(&fixedTable, 4, sizeof(value));
+    if (nCodeBadInput != nTableInsertVar(&fixedTable, "abc", 3, &value))
+        return nFalse;
+    if (nTableInsertVar(&fixedTable, "abcd", 4, &value))
+        return nFalse;
+    if (nTablePeek(&fixedTable, "abcd", &value))
+        return nFalse;
+    nTableDestroy(&fixedTable);
+    return nTrue;
+}
+
+static unsigned int             numVarCalls;
+
+static enum nBool
+varIterRemoveOdd(void *key, size_t keyLen, void *value)
+{
+    numVarCalls++;
+    return (keyLen & 1) ? nTrue : nFalse;
+}
+
+static enum nBool
+varForEachRemove()
+{
+    unsigned int        i, value;
+
+    nTableInitVar(&varTable, sizeof(value), 4);
+    for (i = 0; i < NUM_VAR_KEYS; i++)
+        nTableInsertVar(&varTable, varKeys[i], varKeyLens[i], &i);
+    numVarCalls = 0;
+    nTableForEachVar(&varTable, varIterRemoveOdd);
+    if (numVarCalls != NUM_VAR_KEYS)
+        return nFalse;
+    for (i = 0; i < NUM_VAR_KEYS; i++) {
+        if ((varKeyLens[i] & 1) != (nCodeNotFound == nTablePeekVar(&varTable, varKeys[i],
+                                                                     varKeyLens[i], &value)))
+            return nFalse;
+    }
+    nTableDestroy(&varTable);
+    return nTrue;
+}
+
+/* Keys are every string of up to VAR_CHURN_LEN characters from "\0\1a" */
+#define VAR_CHURN_LEN 5
+#define VAR_CHURN_KEYS 364
+
+static size_t
+varChurnKey(unsigned int idx, char *key)
+{
+    static const char   alphabet[] = {'\0', '\1', 'a'};
+    size_t              len = 0, count = 1;
+
+    while (idx >= count) {
+        idx -= count;
+        count *= 3;
+        len++;
+    }
+    for (count = 0; count < len; count++, idx /= 3)
+        key[count] = alphabet[idx % 3];
+    return len;
+}
+
+static enum nBool
+varRandomChurn()
+{
+    static unsigned short present[VAR_CHURN_KEYS];
+    unsigned long       seed = 54321;
+    unsigned short      dataIn, dataOut;
+    unsigned int        k;
+    char                key[VAR_CHURN_LEN];
+    size_t              keyLen, expectedSize = 0;
+    int                 op;
+
+    nTableInitVar(&varTable, sizeof(dataIn), 32);
+    for (op = 0; op < CHURN_OPS; op++) {
+        seed = seed * 1103515245 + 12345;
+        k = (seed >> 8) % VAR_CHURN_KEYS;
+        keyLen = varChurnKey(k, key);
+        dataIn = op & 0xffff;
+        if ((seed >> 24) % 3) {
+            if (nTableInsertVar(&varTable, key, keyLen, &dataIn))
+                return nFalse;
+            if (!present[k])
+                expectedSize++;
+            present[k] = dataIn + 1;
+        } else {
+            if (nTableRemoveVar(&varTable, key, keyLen)
+                != (present[k] ? nCodeSuccess : nCodeNotFound))
+                return nFalse;
+            if (present[k])
+                expectedSize--;
+            present[k] = 0;
+        }
+        if (nTableSize(&varTable) != expectedSize)
+            return nFalse;
+    }
+    for (k = 0; k < VAR_CHURN_KEYS; k++) {
+        keyLen = varChurnKey(k, key);
+        if (present[k] && (nTablePeekVar(&varTable, key, keyLen, &dataOut)
+                           || dataOut + 1 != present[k]))
+            return nFalse;
+        if (!present[k] && nCodeNotFound != nTablePeekVar(&varTable, key, keyLen, &dataOut))
+            return nFalse;
+    }
+    nTableDestroy(&varTable);
+    return nTrue;
+}
+
+/* Ordered traversal */
+
+#define ORDER_KEY_RANGE 4096
+
+struct nTable                   orderTable;
+static unsigned char            orderPresent[ORDER_KEY_RANGE];
+static unsigned int             orderSeen[ORDER_KEY_RANGE], numOrderSeen;
+
+/* Keys are stored big-endian so that key order is numeric order */
+static void
+setOrderKey(unsigned char *key, unsigned int k)
+{
+    key[0] = k >> 8;
+    key[1] = k & 0xff;
+}
+
+static unsigned int
+getOrderKey(const void *key)
+{
+    return ((const unsigned char *)key)[0] << 8 | ((const unsigned char *)key)[1];
+}
+
+static enum nBool
+orderCollect(void *key, void *value)
+{
+    orderSeen[numOrderSeen++] = getOrderKey(key);
+    return nFalse;
+}
+
+/* Reference count of present keys from lo through hi */
+static unsigned int
+orderExpected(unsigned int lo, unsigned int hi)
+{
+    unsigned int        k, count = 0;
+
+    for (k = lo; k <= hi && k < ORDER_KEY_RANGE; k++)
+        count += orderPresent[k];
+    return count;
+}
+
+/* The seen keys must be the present keys from lo on, in order */
+static enum nBool
+orderCheckSeen(unsigned int lo, unsigned int count)
+{
+    unsigned int        i, k = lo;
+
+    if (numOrderSeen != count)
+        return nFalse;
+    for (i = 0; i < numOrderSeen; i++, k++) {
+        while (k < ORDER_KEY_RANGE && !orderPresent[k])
+            k++;
+        if (orderSeen[i] != k)
+            return nFalse;
+    }
+    return nTrue;
+}
+
+static enum nBool
+orderWalk()
+{
+    struct nTableCursor c;
+    unsigned long       seed = 777;
+    unsigned int        k, value;
+    unsigned char       key[2];
+    enum nErrorType     ret;
+
+    nTableInit(&orderTable, sizeof(key), sizeof(k));
+    if (nCodeNotFound != nTableFirst(&orderTable, &c))
+        return nFalse;
+    for (k = 0; k < ORDER_KEY_RANGE; k++) {
+        seed = seed * 1103515245 + 12345;
+        orderPresent[k] = k == 0 || k == ORDER_KEY_RANGE - 1 || !((seed >> 16) % 3);
+        setOrderKey(key, k);
+        if (orderPresent[k] && nTableInsert(&orderTable, key, &k))
+            return nFalse;
+    }
+
+    numOrderSeen = 0;
+    for (ret = nTableFirst(&orderTable, &c); !ret; ret = nTableNext(&c)) {
+        memcpy(&value, c.value, sizeof(value));
+        if (value != getOrderKey(c.key) || c.keyLen != sizeof(key))
+            return nFalse;
+        orderSeen[numOrderSeen++] = getOrderKey(c.key);
+    }
+    return orderCheckSeen(0, orderExpected(0, ORDER_KEY_RANGE));
+}
+
+/* Depends on orderWalk */
+static enum nBool
+orderSeek()
+{
+    struct nTableCursor c;
+    unsigned int        k, want;
+    unsigned char       key[2];
+    enum nErrorType     ret;
+
+    for (k = 0; k < ORDER_KEY_RANGE; k++) {
+        setOrderKey(key, k);
+        ret = nTableSeek(&orderTable, &c, key, sizeof(key));
+        for (want = k; want < ORDER_KEY_RANGE && !orderPresent[want]; want++)
+            ;
+        if (want == ORDER_KEY_RANGE) {
+            if (ret != nCodeNotFound)
+                return nFalse;
+            continue;
+        }
+        if (ret || getOrderKey(c.key) != want)
+            return nFalse;
+        nTableCursorDestroy(&c);
+    }
+    return nTrue;
+}
+
+/* Depends on orderWalk */
+static enum nBool
+orderRange()
+{
+    unsigned long       seed = 4242;
+    unsigned int        i, lo, hi;
+    unsigned char       loKey[2], hiKey[2];
+
+    for (i = 0; i < 500; i++) {
+        seed = seed * 1103515245 + 12345;
+        lo = (seed >> 8) % ORDER_KEY_RANGE;
+        hi = lo + (seed >> 20) % 64;
+        if (hi >= ORDER_KEY_RANGE)
+            hi = ORDER_KEY_RANGE - 1;
+        setOrderKey(loKey, lo);
+        setOrderKey(hiKey, hi);
+        numOrderSeen = 0;
+        if (nTableRange(&orderTable, loKey, hiKey, orderCollect))
+            return nFalse;
+        if (!orderCheckSeen(lo, orderExpected(lo, hi)))
+            return nFalse;
+    }
+    return nTrue;
+}
+
+/* Depends on orderWalk */
+static enum nBool
+orderPrefix()
+{
+    unsigned int        prefixBits, k, lo;
+    unsigned char       key[2];
+
+    for (prefixBits = 0; prefixBits <= 16; prefixBits++) {
+        for (k = 0; k < ORDER_KEY_RANGE; k += 37) {
+            lo = k >> (16 - prefixBits) << (16 - prefixBits);
+            setOrderKey(key, k);
+            numOrderSeen = 0;
+            if (nTablePrefix(&orderTable, key, prefixBits, orderCollect))
+                return nFalse;
+            if (!orderCheckSeen(lo, orderExpected(lo, lo + (1u << (16 - prefixBits)) - 1)))
+                return nFalse;
+        }
+    }
+    nTableDestroy(&orderTable);
+    return nTrue;
+}
+
+static int
+varKeyCompare(const char *key1, size_t len1, const char *key2, size_t len2)
+{
+    int                 cmp;
+
+    if ((cmp = memcmp(key1, key2, len1 < len2 ? len1 : len2)))
+        return cmp;
+    return (len1 > len2) - (len1 < len2);
+}
+
+static unsigned int             varPrefixCount;
+
+static enum nBool
+varCountPrefix(void *key, size_t keyLen, void *value)
+{
+    varPrefixCount++;
+    return nFalse;
+}
+
+/* Lexicographic order and byte prefixes over variable-length keys */
+static enum nBool
+varOrderPrefix()
+{
+    struct nTableCursor c;
+    unsigned long       seed = 99;
+    unsigned int        k, i, count, expected, value, prefixBits;
+    char                key[VAR_CHURN_LEN], prevKey[VAR_CHURN_LEN], probe[VAR_CHURN_LEN];
+    size_t              keyLen, prevLen = 0, probeLen;
+    enum nBool          first = nTrue;
+    enum nErrorType     ret;
+
+    nTableInitVar(&varTable, sizeof(k), 0);
+    for (k = 0; k < VAR_CHURN_KEYS; k++) {
+        seed = seed * 1103515245 + 12345;
+        if ((seed >> 16) % 2)
+            continue;
+        keyLen = varChurnKey(k, key);
+        nTableInsertVar(&varTable, key, keyLen, &k);
+    }
+
+    count = 0;
+    for (ret = nTableFirst(&varTable, &c); !ret; ret = nTableNext(&c), count++) {
+        if (!first && varKeyCompare(prevKey, prevLen, c.key, c.keyLen) >= 0)
+            return nFalse;
+        memcpy(prevKey, c.key, c.keyLen);
+        prevLen = c.keyLen;
+        first = nFalse;
+    }
+    if (count != nTableSize(&varTable))
+        return nFalse;
+
+    /* Whole-byte prefixes, then prefixes ending inside a byte */
+    for (i = 0; i < 2 * VAR_CHURN_KEYS; i += 7) {
+        probeLen = varChurnKey(i % VAR_CHURN_KEYS, probe);
+        prefixBits = probeLen * 8;
+        if (i >= VAR_CHURN_KEYS && probeLen)
+            prefixBits -= 7;
+        expected = 0;
+        for (k = 0; k < VAR_CHURN_KEYS; k++) {
+            keyLen = varChurnKey(k, key);
+            if (keyLen * 8 < prefixBits || nTablePeekVar(&varTable, key, keyLen, &value))
+                continue;
+            if (prefixBits % 8 && (probeLen > 1 && memcmp(key, probe, probeLen - 1)))
+                continue;
+            if (prefixBits % 8 && (key[probeLen - 1] ^ probe[probeLen - 1]) & 0x80)
+                continue;
+            if (!(prefixBits % 8) && memcmp(key, probe, probeLen))
+                continue;
+            expected++;
+        }
+        varPrefixCount = 0;
+        if (nTablePrefixVar(&varTable, probe, prefixBits, varCountPrefix))
+            return nFalse;
+        if (varPrefixCount != expected)
+            return nFalse;
+    }
+    nTableDestroy(&varTable);
+    return nTrue;
+}
+
+/* Longest-prefix match */
+
+#define LPM_ROUTES 2000
+#define LPM_LOOKUPS 20000
+
+struct nTable                   lpmTable;
+static unsigned int             lpmAddr[LPM_ROUTES], lpmBits[LPM_ROUTES];
+static unsigned char            lpmLive[LPM_ROUTES];
+
+static void
+setLpmKey(unsigned char *key, unsigned int addr)
+{
+    key[0] = addr >> 24;
+    key[1] = addr >> 16;
+    key[2] = addr >> 8;
+    key[3] = addr;
+}
+
+static unsigned int
+lpmMask(unsigned int bits)
+{
+    return bits ? 0xffffffffu << (32 - bits) : 0;
+}
+
+/* Reference: index of the longest live route matching addr, or -1 */
+static int
+lpmReference(unsigned int addr)
+{
+    int                 i, best = -1;
+
+    for (i = 0; i < LPM_ROUTES; i++) {
+        if (lpmLive[i] && !((addr ^ lpmAddr[i]) & lpmMask(lpmBits[i]))
+            && (best < 0 || lpmBits[i] > lpmBits[best]))
+            best = i;
+    }
+    return best;
+}
+
+static enum nBool
+lpmCheckLookups(unsigned long seed)
+{
+    unsigned int        i, j, addr, value;
+    unsigned char       key[4];
+    size_t              matchedBits;
+    enum nErrorType     ret;
+    int                 want;
+
+    for (i = 0; i < LPM_LOOKUPS; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        addr = seed >> 32;
+        j = (seed >> 8) % LPM_ROUTES;
+        /* Half the lookups land inside a route */
+        if (i & 1)
+            addr = lpmAddr[j] | (addr & ~lpmMask(lpmBits[j]));
+        setLpmKey(key, addr);
+        ret = nTableLongestMatch(&lpmTable, key, &value, &matchedBits);
+        want = lpmReference(addr);
+        if (want < 0) {
+            if (ret != nCodeNotFound)
+                return nFalse;
+        } else if (ret || value != (unsigned int)want || matchedBits != lpmBits[want]) {
+            return nFalse;
+        }
+    }
+    return nTrue;
+}
+
+static enum nBool
+lpmMatches()
+{
+    unsigned long       seed = 31337;
+    unsigned int        i, j, value;
+    unsigned char       key[4];
+
+    nTableInitPrefix(&lpmTable, sizeof(key), sizeof(value), 64);
+    for (i = 0; i < LPM_ROUTES; i++) {
+        seed = seed * 1103515245 + 12345;
+        /* Few distinct top bits, so that routes nest */
+        lpmBits[i] = (seed >> 8) % 33;
+        lpmAddr[i] = ((seed >> 16) % 8) << 29 | (unsigned int)(seed * 2654435761u);
+        lpmAddr[i] &= lpmMask(lpmBits[i]);
+        for (j = 0; j < i; j++)
+            if (lpmLive[j] && lpmAddr[j] == lpmAddr[i] && lpmBits[j] == lpmBits[i])
+                lpmLive[j] = 0;
+        lpmLive[i] = 1;
+        setLpmKey(key, lpmAddr[i] | ~lpmMask(lpmBits[i]));
+        if (nTableInsertPrefix(&lpmTable, key, lpmBits[i], &i))
+            return nFalse;
+    }
+    return lpmCheckLookups(1);
+}
+
+/* Depends on lpmMatches */
+static enum nBool
+lpmRemove()
+{
+    unsigned int        i, j;
+    enum nBool          found;
+    unsigned char       key[4];
+    size_t              expectedSize = 0;
+
+    /* A route may repeat an earlier one, whose entry it then replaced */
+    for (i = 0; i < LPM_ROUTES; i += 3) {
+        found = nFalse;
+        for (j = 0; j < LPM_ROUTES; j++) {
+            if (lpmLive[j] && lpmAddr[j] == lpmAddr[i] && lpmBits[j] == lpmBits[i]) {
+                found = nTrue;
+                lpmLive[j] = 0;
+            }
+        }
+        setLpmKey(key, lpmAddr[i]);
+        if (nTableRemovePrefix(&lpmTable, key, lpmBits[i]) != (found ? nCodeSuccess : nCodeNotFound))
+            return nFalse;
+    }
+    for (i = 0; i < LPM_ROUTES; i++)
+        expectedSize += lpmLive[i];
+    if (nTableSize(&lpmTable) != expectedSize)
+        return nFalse;
+    if (nCodeBadInput != nTableInsertPrefix(&lpmTable, key, 33, &i))
+        return nFalse;
+    if (!lpmCheckLookups(2))
+        return nFalse;
+    nTableDestroy(&lpmTable);
+    return nTrue;
+}
+
+/* Bulk load */
+
+#define BUILD_KEY_RANGE 4096
+
+static unsigned char            buildKeys[BUILD_KEY_RANGE][2];
+static unsigned int             buildValues[BUILD_KEY_RANGE];
+static unsigned char            buildPresent[BUILD_KEY_RANGE];
+
+/* Every key is found with its value, in order, and nothing else */
+static enum nBool
+buildCheck(struct nTable *t, size_t numKeys)
+{
+    struct nTableCursor c;
+    unsigned int        k, value;
+    unsigned char       key[2];
+    size_t              numSeen = 0;
+    enum nErrorType     ret;
+
+    for (k = 0; k < BUILD_KEY_RANGE; k++) {
+        setOrderKey(key, k);
+        if (buildPresent[k] ? nTablePeek(t, key, &value) || value != k * 3
+            : nCodeNotFound != nTablePeek(t, key, &value))
+            return nFalse;
+    }
+    for (ret = nTableFirst(t, &c), k = 0; !ret; ret = nTableNext(&c), k++) {
+        while (!buildPresent[k])
+            k++;
+        if (getOrderKey(c.key) != k)
+            return nFalse;
+        numSeen++;
+    }
+    nTableCursorDestroy(&c);
+    return ret == nCodeNotFound && numSeen == numKeys && nTableSize(t) == numKeys;
+}
+
+/* Sorted key sets of every density, with and without the zero key */
+static enum nBool
+buildSortedMatches()
+{
+    struct nTable       t;
+    unsigned long       seed = 4242;
+    unsigned int        k, density, value;
+    unsigned char       key[2];
+    size_t              numKeys;
+
+    for (density = 1; density <= 8; density++) {
+        numKeys = 0;
+        for (k = 0; k < BUILD_KEY_RANGE; k++) {
+            seed = seed * 1103515245 + 12345;
+            buildPresent[k] = (seed >> 16) % 8 < density;
+            if (!buildPresent[k])
+                continue;
+            setOrderKey(buildKeys[numKeys], k);
+            buildValues[numKeys++] = k * 3;
+        }
+        nTableInitPool(&t, sizeof(key), sizeof(k), density % 2 ? 64 : 0);
+        if (nTableBuildSorted(&t, buildKeys, buildValues, numKeys) || !buildCheck(&t, numKeys))
+            return nFalse;
+
+        /* The built trie must take further updates like any other */
+        for (k = density; k < BUILD_KEY_RANGE; k += 7) {
+            setOrderKey(key, k);
+            value = k * 3;
+            numKeys -= buildPresent[k];
+            buildPresent[k] = !buildPresent[k];
+            if (buildPresent[k])
+                numKeys++;
+            if (buildPresent[k] ? nTableInsert(&t, key, &value) : nTableRemove(&t, key))
+                return nFalse;
+        }
+        if (!buildCheck(&t, numKeys))
+            return nFalse;
+        nTableDestroy(&t);
+    }
+    return nTrue;
+}
+
+static enum nBool
+buildSortedBadInput()
+{
+    struct nTable       t;
+    unsigned int        k;
+
+    for (k = 0; k < 10; k++) {
+        setOrderKey(buildKeys[k], k * 10);
+        buildValues[k] = k;
+    }
+    nTableInit(&t, 2, sizeof(k));
+    if (nTableBuildSorted(&t, buildKeys, buildValues, 0) || !nTableEmpty(&t))
+        return nFalse;
+
+    /* Out of order, then repeated */
+    setOrderKey(buildKeys[6], 45);
+    if (nCodeBadInput != nTableBuildSorted(&t, buildKeys, buildValues, 10) || !nTableEmpty(&t))
+        return nFalse;
+    setOrderKey(buildKeys[6], 50);
+    if (nCodeBadInput != nTableBuildSorted(&t, buildKeys, buildValues, 10) || !nTableEmpty(&t))
+        return nFalse;
+
+    /* Only into an empty table */
+    setOrderKey(buildKeys[6], 60);
+    if (nTableBuildSorted(&t, buildKeys, buildValues, 10) || nTableSize(&t) != 10)
+        return nFalse;
+    if (nCodeBadInput != nTableBuildSorted(&t, buildKeys, buildValues, 10))
+        return nFalse;
+    nTableDestroy(&t);
+
+    nTableInitVar(&t, sizeof(k), 0);
+    if (nCodeBadInput != nTableBuildSorted(&t, buildKeys, buildValues, 10))
+        return nFalse;
+    nTableDestroy(&t);
+    return nTrue;
+}
+
+/* Snapshot files */
+
+#define SNAP_KEYS 5000
+#define SNAP_KEY_RANGE 20000
+
+/* Save src, map it back and check every lookup against src */
+static enum nBool
+snapCheck(struct nTable *src, int fd, const char *path)
+{
+    struct nTable       mapped;
+    unsigned int        k, srcValue, mappedValue;
+    enum nErrorType     srcRet;
+    void               *ref;
+
+    if (nTableSave(src, fd) || nTableMapReadOnly(&mapped, path))
+        return nFalse;
+    if (nTableSize(&mapped) != nTableSize(src))
+        return nFalse;
+    for (k = 0; k < SNAP_KEY_RANGE; k++) {
+        srcRet = nTablePeek(src, &k, &srcValue);
+        if (nTablePeek(&mapped, &k, &mappedValue) != srcRet)
+            return nFalse;
+        if (!srcRet && mappedValue != srcValue)
+            return nFalse;
+        if (nTableGetRef(&mapped, &k, &ref) != srcRet || (!srcRet && memcmp(ref, &srcValue, sizeof(srcValue))))
+            return nFalse;
+    }
+
+    /* Mapped tables are read-only */
+    k = 0;
+    if (nCodeBadInput != nTableInsert(&mapped, &k, &k) || nCodeBadInput != nTableSave(&mapped, fd))
+        return nFalse;
+    nTableDestroy(&mapped);
+    return nTrue;
+}
+
+static enum nBool
+snapRoundTrip()
+{
+    struct nTable       src;
+    char                path[] = "/tmp/nanodtypes_snapXXXXXX";
+    unsigned long       seed = 999;
+    unsigned int        k, value;
+    enum nBool          ok;
+    int                 fd;
+
+    if ((fd = mkstemp(path)) < 0)
+        return nFalse;
+    nTableInit(&src, sizeof(k), sizeof(value));
+    ok = snapCheck(&src, fd, path);
+
+    /* Random keys with some removed, and the zero key */
+    for (k = 0; k < SNAP_KEYS; k++) {
+        seed = seed * 1103515245 + 12345;
+        value = (seed >> 8) % SNAP_KEY_RANGE;
+        nTableInsert(&src, &value, &k);
+        if (k % 3 == 0)
+            nTableRemove(&src, &value);
+    }
+    k = 0;
+    nTableInsert(&src, &k, &k);
+    ok = ok && snapCheck(&src, fd, path);
+
+    nTableDestroy(&src);
+    close(fd);
+    unlink(path);
+    return ok;
+}
+
+static enum nBool
+snapBadFiles()
+{
+    struct nTable       t;
+    char                path[] = "/tmp/nanodtypes_snapXXXXXX";
+    unsigned int        k = 1;
+    enum nBool          ok;
+    int                 fd;
+
+    if ((fd = mkstemp(path)) < 0)
+        return nFalse;
+    nTableInit(&t, sizeof(k), sizeof(k));
+    nTableInsert(&t, &k, &k);
+
+    /* Cut short inside the first record, then inside the header */
+    ok = !nTableSave(&t, fd) && !ftruncate(fd, 60) && nCodeBadInput == nTableMapReadOnly(&t, path)
+        && !ftruncate(fd, 10) && nCodeBadInput == nTableMapReadOnly(&t, path);
+    nTableDestroy(&t);
+
+    nTableInitVar(&t, sizeof(k), 0);
+    ok = ok && nCodeBadInput == nTableSave(&t, fd);
+    close(fd);
+    unlink(path);
+    return ok && nCodeNotFound == nTableMapReadOnly(&t, path);
+}
+
+/*
+ * Links pointing past the last record, before the first or into the middle
+ * of one are refused. The first record's right link sits 8 bytes past the
+ * 48-byte header.
+ */
+
+#define SNAP_FIRST_RIGHT_LINK 56
+
+static enum nBool
+snapBadLinks()
+{
+    static const long long badLinks[] = {1 << 20, -4096, 4};
+    struct nTable       t;
+    char                path[] = "/tmp/nanodtypes_snapXXXXXX";
+    unsigned int        k, i;
+    long long           link;
+    enum nBool          ok = nTrue;
+    int                 fd;
+
+    if ((fd = mkstemp(path)) < 0)
+        return nFalse;
+    nTableInit(&t, sizeof(k), sizeof(k));
+    for (k = 1; k < 10; k++)
+        nTableInsert(&t, &k, &k);
+    ok = !nTableSave(&t, fd);
+    nTableDestroy(&t);
+    ok = ok && pread(fd, &link, sizeof(link), SNAP_FIRST_RIGHT_LINK) == sizeof(link);
+
+    for (i = 0; ok && i < sizeof(badLinks) / sizeof(badLinks[0]); i++) {
+        ok = pwrite(fd, &badLinks[i], sizeof(link), SNAP_FIRST_RIGHT_LINK) == sizeof(link)
+            && nCodeBadInput == nTableMapReadOnly(&t, path);
+    }
+
+    /* The file maps again once the link is put back */
+    ok = ok && pwrite(fd, &link, sizeof(link), SNAP_FIRST_RIGHT_LINK) == sizeof(link)
+        && !nTableMapReadOnly(&t, path);
+    k = 5;
+    ok = ok && !nTablePeek(&t, &k, &i) && i == 5;
+    nTableDestroy(&t);
+    close(fd);
+    unlink(path);
+    return ok;
+}
+
+/* In-place access */
+
+#define REF_KEYS 500
+#define REF_VALUE_WORDS 16
+
+/* Values written through pointers stay put while other keys go in */
+static enum nBool
+refUpsertInPlace()
+{
+    static unsigned int *refs[REF_KEYS];
+    struct nTable       t;
+    unsigned int        k, value[REF_VALUE_WORDS];
+    void               *ref;
+
+    nTableInitPool(&t, sizeof(k), sizeof(value), 64);
+    k = 7;
+    if (nCodeNotFound != nTableGetRef(&t, &k, &ref))
+        return nFalse;
+    for (k = 0; k < REF_KEYS; k++) {
+        if (nTableUpsertSlot(&t, &k, &ref))
+            return nFalse;
+        refs[k] = ref;
+        if (refs[k][0] || refs[k][REF_VALUE_WORDS - 1])
+            return nFalse;
+        refs[k][REF_VALUE_WORDS - 1] = k + 1;
+    }
+    if (nTableSize(&t) != REF_KEYS)
+        return nFalse;
+
+    /* A second upsert finds the same value, and peek sees the writes */
+    for (k = 0; k < REF_KEYS; k++) {
+        if (nTableUpsertSlot(&t, &k, &ref) || ref != refs[k])
+            return nFalse;
+        if (nTableGetRef(&t, &k, &ref) || ref != refs[k])
+            return nFalse;
+        if (nTablePeek(&t, &k, value) || value[REF_VALUE_WORDS - 1] != k + 1)
+            return nFalse;
+    }
+    if (nTableSize(&t) != REF_KEYS)
+        return nFalse;
+    nTableDestroy(&t);
+
+    nTableInitVar(&t, sizeof(value), 0);
+    if (nCodeBadInput != nTableGetRef(&t, &k, &ref) || nCodeBadInput != nTableUpsertSlot(&t, &k, &ref))
+        return nFalse;
+    nTableDestroy(&t);
+    return nTrue;
+}
+
+/* Values behind odd-sized keys are aligned for wide types */
+
+#define ODD_KEY_SIZE 13
+
+static enum nBool
+refAlignedValues()
+{
+    struct nTable       t;
+    unsigned char       key[ODD_KEY_SIZE] = {0};
+    unsigned int        k, keySize;
+    void               *ref;
+    double             *d;
+
+    for (keySize = 1; keySize <= ODD_KEY_SIZE; keySize += 2) {
+        nTableInitPool(&t, keySize, sizeof(double), keySize % 4 ? 16 : 0);
+        for (k = 0; k < 40; k++) {
+            key[0] = k;
+            if (nTableUpsertSlot(&t, key, &ref) || (uintptr_t)ref % sizeof(double))
+                return nFalse;
+            d = ref;
+            *d = k * 0.5;
+        }
+        for (k = 0; k < 40; k++) {
+            key[0] = k;
+            if (nTableGetRef(&t, key, &ref) || *(double *)ref != k * 0.5)
+                return nFalse;
+        }
+        nTableDestroy(&t);
+    }
+    return nTrue;
+}
+
+/* Counts start at 100 so a missed initFunc shows */
+static void
+initCount(void *value)
+{
+    unsigned int        count = 100;
+
+    memcpy(value, &count, sizeof(count));
+}
+
+static void
+addOne(void *value)
+{
+    unsigned int        count;
+
+    memcpy(&count, value, sizeof(count));
+    count++;
+    memcpy(value, &count, sizeof(count));
+}
+
+/* Key k is upserted k % 5 + 1 times, alternating fixed and var calls */
+static enum nBool
+upsertCounts()
+{
+    static const char  *words[] = {"", "a", "ab", "abc", "b", "ba", "zz", "zzz"};
+    struct nTable       t;
+    unsigned int        k, i, count;
+
+    nTableInit(&t, sizeof(k), sizeof(count));
+    for (k = 0; k < REF_KEYS; k++) {
+        for (i = 0; i <= k % 5; i++) {
+            if (i % 2 ? nTableUpsertVar(&t, &k, sizeof(k), initCount, addOne)
+                : nTableUpsert(&t, &k, initCount, addOne))
+                return nFalse;
+        }
+    }
+    for (k = 0; k < REF_KEYS; k++)
+        if (nTablePeek(&t, &k, &count) || count != 100 + k % 5 + 1)
+            return nFalse;
+
+    /* NULL functions leave a new value zeroed and an old one alone */
+    k = REF_KEYS;
+    if (nTableUpsert(&t, &k, NULL, NULL) || nTablePeek(&t, &k, &count) || count)
+        return nFalse;
+    k = 3;
+    if (nTableUpsert(&t, &k, initCount, NULL) || nTablePeek(&t, &k, &count) || count != 104)
+        return nFalse;
+    if (nCodeBadInput != nTableUpsertVar(&t, &k, 1, NULL, addOne))
+        return nFalse;
+    nTableDestroy(&t);
+
+    /* Variable-length keys, including the empty one */
+    nTableInitVar(&t, sizeof(count), 0);
+    if (nCodeBadInput != nTableUpsert(&t, &k, NULL, addOne))
+        return nFalse;
+    for (i = 0; i < 3 * sizeof(words) / sizeof(words[0]); i++) {
+        k = i % (sizeof(words) / sizeof(words[0]));
+        if (nTableUpsertVar(&t, words[k], strlen(words[k]), initCount, addOne))
+            return nFalse;
+    }
+    if (nTableSize(&t) != sizeof(words) / sizeof(words[0]))
+        return nFalse;
+    for (k = 0; k < sizeof(words) / sizeof(words[0]); k++)
+        if (nTablePeekVar(&t, words[k], strlen(words[k]), &count) || count != 103)
+            return nFalse;
+    nTableDestroy(&t);
+    return nTrue;
+}
+
 struct testInfo                 tableTests[] = {
 
     /* Simple table */
@@ -144,6 +1429,58 @@ struct testInfo                 tableTests[] = {
     {addLeft, "Adding zero element to the left succeeds"},
     {removeLeft, "Removing these elements succeeds"},
 
+    /* Pooled table and destruction */
+    {poolInsertRemove, "Pooled table insert and remove succeeds"},
+    {poolDestroy, "Destroying pooled table releases everything"},
+    {destroyUnpooled, "Destroying unpooled table empties it"},
+
+    /* Foreach */
+    {forEachEmpty, "ForEach on empty table does nothing"},
+    {forEachVisitsOnce, "ForEach visits every entry once"},
+    {forEachRemove, "ForEach removes selected entries"},
+
+    /* Batched lookups */
+    {batchPeekEmpty, "Batched lookup on empty table finds nothing"},
+    {batchPeekMatchesPeek, "Batched lookup matches single lookups"},
+
+    /* Wide keys */
+    {wideSingleBits, "Wide keys differing in a single bit"},
+    {hugeKeyChurn, "Keys wider than 32767 bits match reference"},
+
+    /* Randomized */
+    {randomChurn, "Random inserts and removals match reference"},
+
+    /* Variable-length keys */
+    {varPrefixKeys, "Keys that are prefixes of each other"},
+    {varWrongCalls, "Key length must suit the table"},
+    {varForEachRemove, "ForEach with key lengths removes entries"},
+    {varRandomChurn, "Random variable-length keys match reference"},
+
+    /* Ordered traversal */
+    {orderWalk, "Cursor visits keys in order"},
+    {orderSeek, "Seek finds the first key not less than a probe"},
+    {orderRange, "Range scans match reference"},
+    {orderPrefix, "Prefix scans match reference"},
+    {varOrderPrefix, "Variable-length key order and prefixes"},
+
+    /* Longest-prefix match */
+    {lpmMatches, "Longest-prefix match agrees with reference"},
+    {lpmRemove, "Longest-prefix match after removing routes"},
+
+    /* Bulk load */
+    {buildSortedMatches, "Table built from sorted keys matches reference"},
+    {buildSortedBadInput, "Building from unsorted keys fails"},
+
+    /* Snapshot files */
+    {snapRoundTrip, "Mapped snapshot answers lookups like its table"},
+    {snapBadFiles, "Mapping a damaged or missing snapshot fails"},
+    {snapBadLinks, "Mapping a snapshot with stray links fails"},
+
+    /* In-place access */
+    {refUpsertInPlace, "Values written in place stay put across inserts"},
+    {refAlignedValues, "Values after odd-sized keys are aligned"},
+    {upsertCounts, "Upserts initialize new values and update old ones"},
+
     {NULL, ""}
 
 };
@@ -2,7 +2,9 @@
 
 #include "test.h"
 
-extern struct testInfo          stackTests[], listTests[], tableTests[];
+extern struct testInfo          stackTests[], listTests[], dequeTests[], tableTests[],
+                                typedTests[], ctableTests[],
+                                queueTests[], cstackTests[], itableTests[], hashTests[];
 
 struct {
     struct testInfo                *testDefs;
@@ -11,12 +13,33 @@ struct {
     {
         stackTests, "Stack Tests"
     },
+    {
+        cstackTests, "Concurrent Stack Tests"
+    },
     {
         listTests, "List Tests"
     },
+    {
+        dequeTests, "Deque Tests"
+    },
+    {
+        queueTests, "Queue Tests"
+    },
     {
         tableTests, "Table Tests"
     },
+    {
+        typedTests, "Typed Wrapper Tests"
+    },
+    {
+        ctableTests, "Concurrent Table Tests"
+    },
+    {
+        itableTests, "Index Table Tests"
+    },
+    {
+        hashTests, "Hash Tests"
+    },
 
     {
         NULL, ""
@@ -0,0 +1,122 @@
+#include <stdint.h>
+
+#include "nanodtypes.h"
+#include "nanodtypes_typed.h"
+#include "test.h"
+
+ND_DEFINE_STACK(u64, uint64_t)
+ND_DEFINE_STACK(u16, uint16_t)
+
+#define TYPED_ELEMS 100
+
+static enum nBool
+typedStackFixed()
+{
+    struct nStack       s;
+    uint64_t            i, value;
+
+    nStackInitM(&s, TYPED_ELEMS, sizeof(uint64_t));
+    for (i = 0; i < TYPED_ELEMS; i++)
+        if (nStackPush_u64(&s, i * 3))
+            return nFalse;
+    if (nCodeFull != nStackPush_u64(&s, 0))
+        return nFalse;
+    if (nStackPeek_u64(&s, &value) || value != (TYPED_ELEMS - 1) * 3)
+        return nFalse;
+    for (i = TYPED_ELEMS; i-- > 0;)
+        if (nStackPop_u64(&s, &value) || value != i * 3)
+            return nFalse;
+    if (nCodeEmpty != nStackPop_u64(&s, &value))
+        return nFalse;
+    nStackDestroy(&s);
+    return nTrue;
+}
+
+/* Typed and generic calls on the same growable stack */
+static enum nBool
+typedStackGrowMixed()
+{
+    struct nStack       s;
+    uint16_t            i, value;
+
+    if (nStackInitG(&s, 2, 0, sizeof(uint16_t)))
+        return nFalse;
+    for (i = 0; i < TYPED_ELEMS; i++)
+        if ((i & 1) ? nStackPush(&s, &i) : nStackPush_u16(&s, i))
+            return nFalse;
+    for (i = TYPED_ELEMS; i-- > 0;) {
+        if ((i & 1) ? nStackPop_u16(&s, &value) : nStackPop(&s, &value))
+            return nFalse;
+        if (value != i)
+            return nFalse;
+    }
+    if (!nStackEmpty(&s) || s.maxElem != s.minElem)
+        return nFalse;
+    nStackDestroy(&s);
+    return nTrue;
+}
+
+/* Typed and generic calls on the same segmented stack, across blocks */
+static enum nBool
+typedStackSegmentMixed()
+{
+    struct nStack       s;
+    uint16_t            i, value;
+
+    if (nStackInitS(&s, 7, 0, sizeof(uint16_t)))
+        return nFalse;
+    for (i = 0; i < TYPED_ELEMS; i++)
+        if ((i % 3) ? nStackPush_u16(&s, i) : nStackPush(&s, &i))
+            return nFalse;
+    for (i = TYPED_ELEMS; i-- > 0;) {
+        if ((i % 3) ? nStackPop_u16(&s, &value) : nStackPop(&s, &value))
+            return nFalse;
+        if (value != i)
+            return nFalse;
+    }
+    if (!nStackEmpty(&s))
+        return nFalse;
+    nStackDestroy(&s);
+    return nTrue;
+}
+
+/* Typed pushes stop at the limit, which lies past the first block */
+static enum nBool
+typedStackSegmentLimit()
+{
+    struct nStack       s;
+    uint16_t            i;
+
+    if (nCodeBadInput != nStackInitS(&s, 16, 4, sizeof(uint16_t)))
+        return nFalse;
+    if (nStackInitS(&s, 4, 10, sizeof(uint16_t)))
+        return nFalse;
+    for (i = 0; i < 10; i++)
+        if (nStackPush_u16(&s, i))
+            return nFalse;
+    if (nCodeFull != nStackPush_u16(&s, i) || nStackSize(&s) != 10)
+        return nFalse;
+    nStackDestroy(&s);
+
+    /* A limit of one block is reached by the inline path */
+    if (nStackInitS(&s, 4, 4, sizeof(uint16_t)))
+        return nFalse;
+    for (i = 0; i < 4; i++)
+        if (nStackPush_u16(&s, i))
+            return nFalse;
+    if (nCodeFull != nStackPush_u16(&s, i) || nStackSize(&s) != 4)
+        return nFalse;
+    nStackDestroy(&s);
+    return nTrue;
+}
+
+struct testInfo                 typedTests[] = {
+
+    {typedStackFixed, "Typed push/pop/peek on a fixed stack"},
+    {typedStackGrowMixed, "Typed and generic calls mix on a growable stack"},
+    {typedStackSegmentMixed, "Typed and generic calls mix on a segmented stack"},
+    {typedStackSegmentLimit, "Typed pushes stop at a segmented stack's limit"},
+
+    {NULL, ""}
+
+};